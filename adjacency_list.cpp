@@ -0,0 +1,92 @@
+#include "bct.h"
+
+/*
+ * Allocates an adjacency list with the given number of nodes and edges.  The
+ * offsets are initialized so that every node has no neighbors; callers that
+ * fill in edges are responsible for setting them.
+ */
+BCT_NAMESPACE::adjacency_list* BCT_NAMESPACE::adjacency_list_alloc(int size, int edges) {
+	adjacency_list* adj = new adjacency_list;
+	adj->size = size;
+	adj->capacity = edges;
+	adj->offsets = new int[size + 1];
+	adj->nodes = new int[(edges > 0) ? edges : 1];
+	adj->weights = new FP_T[(edges > 0) ? edges : 1];
+	for (int i = 0; i <= size; i++) {
+		adj->offsets[i] = 0;
+	}
+	return adj;
+}
+
+/*
+ * Frees an adjacency list.
+ */
+void BCT_NAMESPACE::adjacency_list_free(adjacency_list* adj) {
+	if (adj == NULL) {
+		return;
+	}
+	delete[] adj->offsets;
+	delete[] adj->nodes;
+	delete[] adj->weights;
+	delete adj;
+}
+
+/*
+ * Converts a connection matrix to an adjacency list.  The neighbors of node i
+ * are the columns j for which m(i,j) is nonzero, stored in increasing order
+ * along with the corresponding weights.  Loops are kept.
+ */
+BCT_NAMESPACE::adjacency_list* BCT_NAMESPACE::to_adjacency_list(const MATRIX_T* m) {
+	adjacency_list* adj = adjacency_list_alloc(m->size1, 0);
+	to_adjacency_list_into(m, adj);
+	return adj;
+}
+
+/*
+ * Converts a connection matrix to an adjacency list, as to_adjacency_list, into
+ * an existing list with one node per row of m.  The storage for edges is
+ * reallocated only if m has more edges than the list has room for, so a list
+ * reused for graphs of the same size stops allocating once it has grown.
+ */
+void BCT_NAMESPACE::to_adjacency_list_into(const MATRIX_T* m, adjacency_list* adj) {
+	int N = m->size1;
+	if (adj->size != N) {
+		throw bct_exception("to_adjacency_list_into: adj must have one node per row");
+	}
+	int edges = 0;
+	for (int i = 0; i < N; i++) {
+		for (int j = 0; j < (int)m->size2; j++) {
+			if (fp_nonzero(MATRIX_ID(get)(m, i, j))) {
+				edges++;
+			}
+		}
+	}
+	if (edges > adj->capacity) {
+		delete[] adj->nodes;
+		delete[] adj->weights;
+		adj->nodes = new int[edges];
+		adj->weights = new FP_T[edges];
+		adj->capacity = edges;
+	}
+	int position = 0;
+	for (int i = 0; i < N; i++) {
+		adj->offsets[i] = position;
+		for (int j = 0; j < (int)m->size2; j++) {
+			FP_T value = MATRIX_ID(get)(m, i, j);
+			if (fp_nonzero(value)) {
+				adj->nodes[position] = j;
+				adj->weights[position] = value;
+				position++;
+			}
+		}
+	}
+	adj->offsets[N] = position;
+}
+
+/*
+ * Returns a view of an adjacency list for the kernels in kernels.h.
+ */
+bct_kernels::graph_view<FP_T> BCT_NAMESPACE::to_graph_view(const adjacency_list* adj) {
+	bct_kernels::graph_view<FP_T> view = { adj->size, adj->offsets, adj->nodes, adj->weights };
+	return view;
+}
@@ -9,28 +9,26 @@ FP_T BCT_NAMESPACE::assortativity_dir(const MATRIX_T* CIJ) {
 	if (safe_mode) check_status(CIJ, SQUARE | DIRECTED, "assortativity_dir");
 	
 	// [id,od,deg] = degrees_dir(CIJ);
-	VECTOR_T* deg = degrees_dir(CIJ);
-	
 	// [i,j] = find(CIJ>0);
-	MATRIX_T* CIJ_gt_0 = compare_elements(CIJ, fp_greater, 0.0);
-	MATRIX_T* CIJ_gt_0_ij = find_ij(CIJ_gt_0);
-	MATRIX_ID(free)(CIJ_gt_0);
-	
-	FP_T ret = assortativity(deg, CIJ_gt_0_ij);
-	VECTOR_ID(free)(deg);
-	MATRIX_ID(free)(CIJ_gt_0_ij);
+	basic_stats* stats = basic_stats_dir(CIJ);
+	FP_T ret = stats->assortativity;
+	basic_stats_free(stats);
 	return ret;
 }
 
 /*
  * Computes assortativity for an undirected graph.  Connection weights are
- * ignored.
+ * ignored.  Takes an optional degree vector (as returned by degrees_und) that
+ * is computed if not given.
  */
-FP_T BCT_NAMESPACE::assortativity_und(const MATRIX_T* CIJ) {
+FP_T BCT_NAMESPACE::assortativity_und(const MATRIX_T* CIJ, const VECTOR_T* deg) {
 	if (safe_mode) check_status(CIJ, SQUARE | UNDIRECTED, "assortativity_und");
 	
 	// [deg] = degrees_und(m);
-	VECTOR_T* deg = degrees_und(CIJ);
+	VECTOR_T* deg_temp = NULL;
+	if (deg == NULL) {
+		deg = deg_temp = degrees_und(CIJ);
+	}
 	
 	// [i,j] = find(triu(CIJ,1)>0);
 	MATRIX_T* triu_CIJ = triu(CIJ, 1);
@@ -40,7 +38,9 @@ FP_T BCT_NAMESPACE::assortativity_und(const MATRIX_T* CIJ) {
 	MATRIX_ID(free)(triu_CIJ_gt_0);
 	
 	FP_T ret = assortativity(deg, triu_CIJ_gt_0_ij);
-	VECTOR_ID(free)(deg);
+	if (deg_temp != NULL) {
+		VECTOR_ID(free)(deg_temp);
+	}
 	MATRIX_ID(free)(triu_CIJ_gt_0_ij);
 	return ret;
 }
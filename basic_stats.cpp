@@ -0,0 +1,167 @@
+#include <vector>
+
+#include "bct.h"
+
+namespace BCT_NAMESPACE {
+	
+	// Rows are split into a fixed number of blocks, independent of the number
+	// of threads, so that column sums are always added in the same order
+	const int basic_stats_blocks = 16;
+}
+
+/*
+ * Computes in-degree, out-degree, degree, in-strength, out-strength, strength,
+ * number of edges, density, joint degree distribution, and assortativity of a
+ * directed graph, reading the connection matrix only once.  Each value is the
+ * same as that returned by the corresponding function (degrees_dir,
+ * strengths_dir, nnz, density_dir, jdegree, and assortativity_dir), except that
+ * in-strengths may differ from strengths_dir by rounding.
+ *
+ * Blocks of rows are processed in parallel.  Within each row, counts and sums
+ * are accumulated in separate loops over contiguous memory so that the
+ * compiler can vectorize them.
+ */
+BCT_NAMESPACE::basic_stats* BCT_NAMESPACE::basic_stats_dir(const MATRIX_T* CIJ) {
+	if (safe_mode) check_status(CIJ, SQUARE, "basic_stats_dir");
+	int N = CIJ->size1;
+	int blocks = (N < basic_stats_blocks) ? N : basic_stats_blocks;
+	std::vector<int> od(N);
+	std::vector<FP_T> os(N);
+	std::vector<int> arcs(N);
+	std::vector<std::vector<int> > id_block(blocks);
+	std::vector<std::vector<FP_T> > is_block(blocks);
+	std::vector<std::vector<int> > arcs_block(blocks);
+	FP_T eps = epsilon;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+	for (int block = 0; block < blocks; block++) {
+		std::vector<int>& id_b = id_block[block];
+		std::vector<FP_T>& is_b = is_block[block];
+		std::vector<int>& arcs_b = arcs_block[block];
+		id_b.assign(N, 0);
+		is_b.assign(N, 0.0);
+		int* id_p = &id_b[0];
+		FP_T* is_p = &is_b[0];
+		int first = (int)((long)block * N / blocks);
+		int last = (int)((long)(block + 1) * N / blocks);
+		for (int i = first; i < last; i++) {
+			const FP_T* row = MATRIX_ID(const_ptr)(CIJ, i, 0);
+			
+			// id = sum(CIJ~=0,1); is = sum(CIJ,1);
+			int od_i = 0;
+			for (int j = 0; j < N; j++) {
+				FP_T value = row[j];
+				int nonzero = (value > eps) | (value < -eps);
+				id_p[j] += nonzero;
+				is_p[j] += value;
+				od_i += nonzero;
+			}
+			od[i] = od_i;
+			
+			// os = sum(CIJ,2);
+			// [i,j] = find(CIJ>0);
+			FP_T os_i = 0.0;
+			int arcs_i = 0;
+			for (int j = 0; j < N; j++) {
+				FP_T value = row[j];
+				os_i += value;
+				if (value >= eps) {
+					arcs_b.push_back(j);
+					arcs_i++;
+				}
+			}
+			os[i] = os_i;
+			arcs[i] = arcs_i;
+		}
+	}
+	
+	basic_stats* stats = new basic_stats;
+	stats->id = VECTOR_ID(alloc)(N);
+	stats->od = VECTOR_ID(alloc)(N);
+	stats->deg = VECTOR_ID(alloc)(N);
+	stats->is = VECTOR_ID(alloc)(N);
+	stats->os = VECTOR_ID(alloc)(N);
+	stats->str = VECTOR_ID(alloc)(N);
+	std::vector<int> id(N);
+	int max_degree = 0;
+	int edges = 0;
+	for (int j = 0; j < N; j++) {
+		int id_j = 0;
+		FP_T is_j = 0.0;
+		for (int block = 0; block < blocks; block++) {
+			id_j += id_block[block][j];
+			is_j += is_block[block][j];
+		}
+		id[j] = id_j;
+		
+		// deg = id+od; str = is+os;
+		VECTOR_ID(set)(stats->id, j, (FP_T)id_j);
+		VECTOR_ID(set)(stats->od, j, (FP_T)od[j]);
+		VECTOR_ID(set)(stats->deg, j, (FP_T)(id_j + od[j]));
+		VECTOR_ID(set)(stats->is, j, is_j);
+		VECTOR_ID(set)(stats->os, j, os[j]);
+		VECTOR_ID(set)(stats->str, j, is_j + os[j]);
+		if (id_j > max_degree) max_degree = id_j;
+		if (od[j] > max_degree) max_degree = od[j];
+		edges += od[j];
+	}
+	
+	// K = nnz(CIJ);
+	// kden = K/(N^2-N);
+	stats->edges = edges;
+	stats->density = (FP_T)edges / (FP_T)(N * (N - 1));
+	
+	// J = zeros(szJ);
+	// J(id(i)+1,od(i)+1) = J(id(i)+1,od(i)+1) + 1;
+	stats->J = zeros(max_degree + 1);
+	for (int i = 0; i < N; i++) {
+		MATRIX_ID(set)(stats->J, id[i], od[i], MATRIX_ID(get)(stats->J, id[i], od[i]) + 1.0);
+	}
+	
+	// r = (sum(degi.*degj)/K - (sum(0.5*(degi+degj))/K)^2)/(sum(0.5*(degi.^2+degj.^2))/K - (sum(0.5*(degi+degj))/K)^2);
+	FP_T sum_product = 0.0;
+	FP_T sum_degree = 0.0;
+	FP_T sum_square = 0.0;
+	int K = 0;
+	for (int block = 0; block < blocks; block++) {
+		const std::vector<int>& arcs_b = arcs_block[block];
+		int first = (int)((long)block * N / blocks);
+		int last = (int)((long)(block + 1) * N / blocks);
+		int position = 0;
+		for (int i = first; i < last; i++) {
+			FP_T deg_i = (FP_T)(id[i] + od[i]);
+			for (int k = 0; k < arcs[i]; k++) {
+				int j = arcs_b[position++];
+				FP_T deg_j = (FP_T)(id[j] + od[j]);
+				sum_product += deg_i * deg_j;
+				sum_degree += deg_i + deg_j;
+				sum_square += deg_i * deg_i + deg_j * deg_j;
+			}
+			K += arcs[i];
+		}
+	}
+	FP_T r1 = sum_product / (FP_T)K;
+	FP_T r2 = 0.5 * sum_degree / (FP_T)K;
+	r2 *= r2;
+	FP_T r3 = 0.5 * sum_square / (FP_T)K;
+	stats->assortativity = (r1 - r2) / (r3 - r2);
+	return stats;
+}
+
+/*
+ * Frees the statistics returned by basic_stats_dir.
+ */
+void BCT_NAMESPACE::basic_stats_free(basic_stats* stats) {
+	if (stats == NULL) {
+		return;
+	}
+	VECTOR_ID(free)(stats->deg);
+	VECTOR_ID(free)(stats->id);
+	VECTOR_ID(free)(stats->od);
+	VECTOR_ID(free)(stats->str);
+	VECTOR_ID(free)(stats->is);
+	VECTOR_ID(free)(stats->os);
+	MATRIX_ID(free)(stats->J);
+	delete stats;
+}
@@ -0,0 +1,488 @@
+#include <cstdio>
+#include <gsl/gsl_math.h>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "bct.h"
+
+namespace BCT_NAMESPACE {
+	
+	// Intermediates shared by several measures, which are computed for all
+	// graphs in a chunk before any measures.  BATCH_BINARY_DISTANCE_BIN is the
+	// result of distance_bin, computed only for binary graphs.
+	enum batch_intermediate {
+		BATCH_BASIC_STATS = 1,
+		BATCH_DISTANCE_BIN = 2,
+		BATCH_DISTANCE_WEI = 4,
+		BATCH_MODULES = 8,
+		BATCH_MODULE_STRENGTH = 16,
+		BATCH_TRIANGLES = 32,
+		BATCH_ADJACENCY_LIST = 64,
+		BATCH_DEGREES_UND = 128,
+		BATCH_STRENGTHS_UND = 256,
+		BATCH_BINARY_DISTANCE_BIN = 512
+	};
+	const int batch_intermediate_count = 10;
+	
+	// Intermediates that draw from the shared random number generator, which
+	// are computed in graph order on one thread
+	const int batch_serial = BATCH_MODULES;
+	
+	// Number of graphs whose intermediates are kept in memory at once
+	const int batch_chunk = 64;
+	
+	/*
+	 * A measure is either global, returning one value per graph, or nodal,
+	 * returning one value per node.  needs lists every intermediate it uses,
+	 * including those used by the context functions it calls, so that none is
+	 * left to be computed while measures are.
+	 */
+	struct batch_measure {
+		const char* name;
+		int needs;
+		FP_T (*global)(graph_context* context);
+		VECTOR_T* (*nodal)(graph_context* context);
+	};
+	
+	FP_T batch_assortativity_dir(graph_context* context);
+	FP_T batch_assortativity_und(graph_context* context);
+	VECTOR_T* batch_betweenness_bin(graph_context* context);
+	VECTOR_T* batch_betweenness_wei(graph_context* context);
+	FP_T batch_capped_charpath_lambda(graph_context* context);
+	FP_T batch_charpath_diameter(graph_context* context);
+	VECTOR_T* batch_charpath_ecc(graph_context* context);
+	FP_T batch_charpath_lambda(graph_context* context);
+	FP_T batch_charpath_lambda_wei(graph_context* context);
+	FP_T batch_charpath_radius(graph_context* context);
+	VECTOR_T* batch_clustering_coef_bd(graph_context* context);
+	VECTOR_T* batch_clustering_coef_bu(graph_context* context);
+	VECTOR_T* batch_clustering_coef_wd(graph_context* context);
+	VECTOR_T* batch_clustering_coef_wu(graph_context* context);
+	FP_T batch_connectivity_length(graph_context* context);
+	VECTOR_T* batch_degrees_dir(graph_context* context);
+	VECTOR_T* batch_degrees_und(graph_context* context);
+	FP_T batch_density_dir(graph_context* context);
+	FP_T batch_density_und(graph_context* context);
+	FP_T batch_efficiency_global(graph_context* context);
+	VECTOR_T* batch_efficiency_local(graph_context* context);
+	VECTOR_T* batch_eigenvector_centrality(graph_context* context);
+	FP_T batch_jdegree_bl(graph_context* context);
+	FP_T batch_jdegree_id(graph_context* context);
+	FP_T batch_jdegree_od(graph_context* context);
+	FP_T batch_modularity_und(graph_context* context);
+	VECTOR_T* batch_module_degree_zscore(graph_context* context);
+	FP_T batch_normalized_path_length(graph_context* context);
+	VECTOR_T* batch_participation_coef(graph_context* context);
+	VECTOR_T* batch_strengths_dir(graph_context* context);
+	VECTOR_T* batch_strengths_und(graph_context* context);
+	
+	/*
+	 * Measures are named after the functions that compute them.  The _wei
+	 * variants of charpath apply to distance_wei rather than distance_bin, and
+	 * community structure comes from modularity_und.
+	 */
+	const batch_measure batch_measure_table[] = {
+		{ "assortativity_dir", BATCH_BASIC_STATS, batch_assortativity_dir, NULL },
+		{ "assortativity_und", BATCH_DEGREES_UND, batch_assortativity_und, NULL },
+		{ "betweenness_bin", 0, NULL, batch_betweenness_bin },
+		{ "betweenness_wei", 0, NULL, batch_betweenness_wei },
+		{ "capped_charpath_lambda", BATCH_DISTANCE_WEI, batch_capped_charpath_lambda, NULL },
+		{ "charpath_diameter", BATCH_DISTANCE_BIN, batch_charpath_diameter, NULL },
+		{ "charpath_ecc", BATCH_DISTANCE_BIN, NULL, batch_charpath_ecc },
+		{ "charpath_lambda", BATCH_DISTANCE_BIN, batch_charpath_lambda, NULL },
+		{ "charpath_lambda_wei", BATCH_DISTANCE_WEI, batch_charpath_lambda_wei, NULL },
+		{ "charpath_radius", BATCH_DISTANCE_BIN, batch_charpath_radius, NULL },
+		{ "clustering_coef_bd", 0, NULL, batch_clustering_coef_bd },
+		{ "clustering_coef_bu", BATCH_ADJACENCY_LIST | BATCH_TRIANGLES, NULL, batch_clustering_coef_bu },
+		{ "clustering_coef_wd", 0, NULL, batch_clustering_coef_wd },
+		{ "clustering_coef_wu", 0, NULL, batch_clustering_coef_wu },
+		{ "connectivity_length", BATCH_DISTANCE_BIN, batch_connectivity_length, NULL },
+		{ "degrees_dir", BATCH_BASIC_STATS, NULL, batch_degrees_dir },
+		{ "degrees_und", BATCH_DEGREES_UND, NULL, batch_degrees_und },
+		{ "density_dir", BATCH_BASIC_STATS, batch_density_dir, NULL },
+		{ "density_und", 0, batch_density_und, NULL },
+		{ "efficiency_global", BATCH_BINARY_DISTANCE_BIN, batch_efficiency_global, NULL },
+		{ "efficiency_local", 0, NULL, batch_efficiency_local },
+		{ "eigenvector_centrality", 0, NULL, batch_eigenvector_centrality },
+		{ "jdegree_bl", BATCH_BASIC_STATS, batch_jdegree_bl, NULL },
+		{ "jdegree_id", BATCH_BASIC_STATS, batch_jdegree_id, NULL },
+		{ "jdegree_od", BATCH_BASIC_STATS, batch_jdegree_od, NULL },
+		{ "modularity_und", BATCH_MODULES, batch_modularity_und, NULL },
+		{ "module_degree_zscore", BATCH_ADJACENCY_LIST | BATCH_MODULES | BATCH_MODULE_STRENGTH, NULL, batch_module_degree_zscore },
+		{ "normalized_path_length", BATCH_DISTANCE_BIN, batch_normalized_path_length, NULL },
+		{ "participation_coef", BATCH_ADJACENCY_LIST | BATCH_BASIC_STATS | BATCH_MODULES | BATCH_MODULE_STRENGTH, NULL, batch_participation_coef },
+		{ "strengths_dir", 0, NULL, batch_strengths_dir },
+		{ "strengths_und", BATCH_STRENGTHS_UND, NULL, batch_strengths_und }
+	};
+	const int batch_measure_count = sizeof(batch_measure_table) / sizeof(batch_measure);
+	
+	const batch_measure* batch_find_measure(const std::string& name);
+	void batch_compute(graph_context* g, int intermediate);
+	void batch_fail(bool* failed, std::string* error, const char* what);
+}
+
+/*
+ * Returns the names of the measures that batch_run can compute.
+ */
+std::vector<std::string> BCT_NAMESPACE::batch_measures() {
+	std::vector<std::string> names;
+	for (int i = 0; i < batch_measure_count; i++) {
+		names.push_back(batch_measure_table[i].name);
+	}
+	return names;
+}
+
+/*
+ * Computes the named measure (one of those returned by batch_measures) using
+ * the quantities cached by a context.  Global measures are returned as a
+ * vector with one element.
+ */
+VECTOR_T* BCT_NAMESPACE::context_measure(graph_context* context, const std::string& measure) {
+	const batch_measure* selected = batch_find_measure(measure);
+	if (selected == NULL) {
+		throw bct_exception("Unknown measure " + measure);
+	}
+	if (selected->global != NULL) {
+		VECTOR_T* value = VECTOR_ID(alloc)(1);
+		VECTOR_ID(set)(value, 0, selected->global(context));
+		return value;
+	} else {
+		return selected->nodal(context);
+	}
+}
+
+/*
+ * Computes the given measures for every graph.  Work is split into (graph,
+ * intermediate) and (graph, measure) tasks that are scheduled across threads.
+ * Each graph is wrapped in a graph_context, so intermediates needed by more
+ * than one measure (distance matrices, degrees, triangles, and community
+ * structure) are computed once per graph, and graphs are processed in chunks
+ * so that only a limited number of contexts are held in memory at a time.
+ * Community structure is found with modularity_und, which draws random
+ * numbers, so it is computed one graph at a time in order; results are then
+ * reproducible for a given seed.  If any task throws, the remaining work is
+ * abandoned and a bct_exception with the first message is thrown.
+ *
+ * The result holds the number of nodes of each graph and one matrix per
+ * measure, with one row per graph.  Global measures have a single column;
+ * nodal measures have one column per node of the largest graph, padded with
+ * NaN for smaller graphs.
+ */
+BCT_NAMESPACE::batch_result* BCT_NAMESPACE::batch_run(const std::vector<MATRIX_T*>& graphs, const std::vector<std::string>& measures) {
+	int n_graphs = (int)graphs.size();
+	int n_measures = (int)measures.size();
+	std::vector<const batch_measure*> selected(n_measures);
+	int needs = 0;
+	for (int k = 0; k < n_measures; k++) {
+		selected[k] = batch_find_measure(measures[k]);
+		if (selected[k] == NULL) {
+			throw bct_exception("Unknown measure " + measures[k]);
+		}
+		needs |= selected[k]->needs;
+	}
+	std::vector<int> intermediates;
+	for (int i = 0; i < batch_intermediate_count; i++) {
+		if (needs & (1 << i)) {
+			intermediates.push_back(1 << i);
+		}
+	}
+	int n_intermediates = (int)intermediates.size();
+	int width = 0;
+	for (int i = 0; i < n_graphs; i++) {
+		if (safe_mode) check_status(graphs[i], SQUARE, "batch_run");
+		if ((int)graphs[i]->size1 > width) {
+			width = graphs[i]->size1;
+		}
+	}
+	
+	batch_result* result = new batch_result;
+	result->graphs = n_graphs;
+	for (int i = 0; i < n_graphs; i++) {
+		result->nodes.push_back(graphs[i]->size1);
+	}
+	result->measures = measures;
+	for (int k = 0; k < n_measures; k++) {
+		MATRIX_T* values = MATRIX_ID(alloc)((n_graphs > 0) ? n_graphs : 1, (selected[k]->nodal != NULL && width > 0) ? width : 1);
+		MATRIX_ID(set_all)(values, GSL_NAN);
+		result->values.push_back(values);
+	}
+	
+	// Exceptions cannot leave a parallel region, so the first one thrown by any
+	// task is kept and rethrown once the chunk's contexts are freed
+	bool failed = false;
+	std::string error;
+	std::vector<graph_context*> chunk(batch_chunk);
+	for (int first = 0; first < n_graphs && !failed; first += batch_chunk) {
+		int count = (n_graphs - first < batch_chunk) ? n_graphs - first : batch_chunk;
+		for (int i = 0; i < count; i++) {
+			chunk[i] = graph_context_alloc(graphs[first + i]);
+		}
+		
+		// Compute each intermediate of each graph once
+		try {
+			for (int i = 0; i < count; i++) {
+				for (int j = 0; j < n_intermediates; j++) {
+					if (intermediates[j] & batch_serial) {
+						batch_compute(chunk[i], intermediates[j]);
+					}
+				}
+			}
+		} catch (const std::exception& e) {
+			batch_fail(&failed, &error, e.what());
+		}
+		int tasks = failed ? 0 : count * n_intermediates;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+		for (int task = 0; task < tasks; task++) {
+			int intermediate = intermediates[task % n_intermediates];
+			if ((intermediate & batch_serial) == 0) {
+				try {
+					batch_compute(chunk[task / n_intermediates], intermediate);
+				} catch (const std::exception& e) {
+					batch_fail(&failed, &error, e.what());
+				}
+			}
+		}
+		
+		// Then compute every measure of every graph
+		tasks = failed ? 0 : count * n_measures;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+		for (int task = 0; task < tasks; task++) {
+			int i = task / n_measures;
+			int k = task % n_measures;
+			const batch_measure* measure = selected[k];
+			try {
+				if (measure->global != NULL) {
+					MATRIX_ID(set)(result->values[k], first + i, 0, measure->global(chunk[i]));
+				} else {
+					VECTOR_T* values = measure->nodal(chunk[i]);
+					if (values != NULL) {
+						for (int j = 0; j < (int)values->size; j++) {
+							MATRIX_ID(set)(result->values[k], first + i, j, VECTOR_ID(get)(values, j));
+						}
+						VECTOR_ID(free)(values);
+					}
+				}
+			} catch (const std::exception& e) {
+				batch_fail(&failed, &error, e.what());
+			}
+		}
+		
+		for (int i = 0; i < count; i++) {
+			graph_context_free(chunk[i]);
+		}
+	}
+	if (failed) {
+		batch_result_free(result);
+		throw bct_exception(error);
+	}
+	return result;
+}
+
+/*
+ * Computes the given comma-separated measures for every graph.
+ */
+BCT_NAMESPACE::batch_result* BCT_NAMESPACE::batch_run(const std::vector<MATRIX_T*>& graphs, const std::string& measures) {
+	std::vector<std::string> names;
+	std::string::size_type start = 0;
+	while (start <= measures.size()) {
+		std::string::size_type end = measures.find(',', start);
+		if (end == std::string::npos) {
+			end = measures.size();
+		}
+		std::string name = measures.substr(start, end - start);
+		std::string::size_type first = name.find_first_not_of(" \t");
+		std::string::size_type last = name.find_last_not_of(" \t");
+		if (first != std::string::npos) {
+			names.push_back(name.substr(first, last - first + 1));
+		}
+		start = end + 1;
+	}
+	return batch_run(graphs, names);
+}
+
+/*
+ * Computes the given comma-separated measures for every graph and writes the
+ * results to a file as by write_batch_result.
+ */
+void BCT_NAMESPACE::batch_run(const std::vector<MATRIX_T*>& graphs, const std::string& measures, const std::string& filename) {
+	batch_result* result = batch_run(graphs, measures);
+	try {
+		write_batch_result(result, filename);
+	} catch (...) {
+		batch_result_free(result);
+		throw;
+	}
+	batch_result_free(result);
+}
+
+/*
+ * Frees the result of batch_run.
+ */
+void BCT_NAMESPACE::batch_result_free(batch_result* result) {
+	if (result == NULL) {
+		return;
+	}
+	for (int k = 0; k < (int)result->values.size(); k++) {
+		MATRIX_ID(free)(result->values[k]);
+	}
+	delete result;
+}
+
+/*
+ * Writes the result of batch_run as comma-separated values in long format, with
+ * columns graph, measure, node, and value and one row per value.  Graphs and
+ * nodes are numbered from one, and the node is left empty for global measures.
+ * Padding for graphs smaller than the largest is not written, so each nodal
+ * measure of a graph has exactly one row per node of that graph.
+ */
+void BCT_NAMESPACE::write_batch_result(const batch_result* result, const std::string& filename) {
+	std::FILE* f = std::fopen(filename.c_str(), "w");
+	if (f == NULL) {
+		throw bct_exception("Cannot open " + filename);
+	}
+	std::fprintf(f, "graph,measure,node,value\n");
+	int digits = std::numeric_limits<FP_T>::digits10 + 2;
+	for (int i = 0; i < result->graphs; i++) {
+		for (int k = 0; k < (int)result->measures.size(); k++) {
+			const char* measure = result->measures[k].c_str();
+			if (batch_find_measure(result->measures[k])->nodal == NULL) {
+				std::fprintf(f, "%d,%s,,%.*Lg\n", i + 1, measure, digits, (long double)MATRIX_ID(get)(result->values[k], i, 0));
+			} else {
+				for (int j = 0; j < result->nodes[i]; j++) {
+					std::fprintf(f, "%d,%s,%d,%.*Lg\n", i + 1, measure, j + 1, digits, (long double)MATRIX_ID(get)(result->values[k], i, j));
+				}
+			}
+		}
+	}
+	if (std::fclose(f) != 0) {
+		throw bct_exception("Cannot write " + filename);
+	}
+}
+
+const BCT_NAMESPACE::batch_measure* BCT_NAMESPACE::batch_find_measure(const std::string& name) {
+	for (int i = 0; i < batch_measure_count; i++) {
+		if (name == batch_measure_table[i].name) {
+			return &batch_measure_table[i];
+		}
+	}
+	return NULL;
+}
+
+void BCT_NAMESPACE::batch_compute(graph_context* context, int intermediate) {
+	switch (intermediate) {
+		case BATCH_BASIC_STATS:
+			context_basic_stats(context);
+			break;
+		case BATCH_DISTANCE_BIN:
+			context_distance_bin(context);
+			break;
+		case BATCH_DISTANCE_WEI:
+			context_distance_wei(context);
+			break;
+		case BATCH_MODULES:
+			context_modules(context);
+			break;
+		case BATCH_MODULE_STRENGTH:
+			context_module_strength(context);
+			break;
+		case BATCH_TRIANGLES:
+			context_triangles(context);
+			break;
+		case BATCH_ADJACENCY_LIST:
+			context_adjacency_list(context);
+			break;
+		case BATCH_DEGREES_UND:
+			context_degrees_und(context);
+			break;
+		case BATCH_STRENGTHS_UND:
+			context_strengths_und(context);
+			break;
+		case BATCH_BINARY_DISTANCE_BIN:
+			if (matrix_status(context->W, BINARY) & BINARY) {
+				context_distance_bin(context);
+			}
+			break;
+	}
+}
+
+/*
+ * Records the message of an exception thrown by a batch_run task, unless one
+ * has already been recorded.
+ */
+void BCT_NAMESPACE::batch_fail(bool* failed, std::string* error, const char* what) {
+#ifdef _OPENMP
+#pragma omp critical(batch_fail)
+#endif
+	{
+		if (!*failed) {
+			*failed = true;
+			*error = what;
+		}
+	}
+}
+
+FP_T BCT_NAMESPACE::batch_assortativity_dir(graph_context* context) { return context_basic_stats(context)->assortativity; }
+FP_T BCT_NAMESPACE::batch_assortativity_und(graph_context* context) { return assortativity_und(context->W, context_degrees_und(context)); }
+VECTOR_T* BCT_NAMESPACE::batch_betweenness_bin(graph_context* context) { return betweenness_bin(context->W); }
+VECTOR_T* BCT_NAMESPACE::batch_betweenness_wei(graph_context* context) { return betweenness_wei(context->W); }
+FP_T BCT_NAMESPACE::batch_capped_charpath_lambda(graph_context* context) { return capped_charpath_lambda(context->W, context_distance_wei(context)); }
+VECTOR_T* BCT_NAMESPACE::batch_charpath_ecc(graph_context* context) { return charpath_ecc(context_distance_bin(context)); }
+FP_T BCT_NAMESPACE::batch_charpath_lambda(graph_context* context) { return charpath_lambda(context_distance_bin(context)); }
+FP_T BCT_NAMESPACE::batch_charpath_lambda_wei(graph_context* context) { return charpath_lambda(context_distance_wei(context)); }
+VECTOR_T* BCT_NAMESPACE::batch_clustering_coef_bd(graph_context* context) { return clustering_coef_bd(context->W); }
+VECTOR_T* BCT_NAMESPACE::batch_clustering_coef_bu(graph_context* context) { return clustering_coef_bu(context); }
+VECTOR_T* BCT_NAMESPACE::batch_clustering_coef_wd(graph_context* context) { return clustering_coef_wd(context->W); }
+VECTOR_T* BCT_NAMESPACE::batch_clustering_coef_wu(graph_context* context) { return clustering_coef_wu(context->W); }
+FP_T BCT_NAMESPACE::batch_connectivity_length(graph_context* context) { return connectivity_length(context_distance_bin(context)); }
+VECTOR_T* BCT_NAMESPACE::batch_degrees_dir(graph_context* context) { return copy(context_basic_stats(context)->deg); }
+VECTOR_T* BCT_NAMESPACE::batch_degrees_und(graph_context* context) { return copy(context_degrees_und(context)); }
+FP_T BCT_NAMESPACE::batch_density_dir(graph_context* context) { return context_basic_stats(context)->density; }
+FP_T BCT_NAMESPACE::batch_density_und(graph_context* context) { return density_und(context->W); }
+VECTOR_T* BCT_NAMESPACE::batch_efficiency_local(graph_context* context) { return efficiency_local(context->W); }
+VECTOR_T* BCT_NAMESPACE::batch_eigenvector_centrality(graph_context* context) { return eigenvector_centrality(context->W); }
+FP_T BCT_NAMESPACE::batch_jdegree_bl(graph_context* context) { return (FP_T)jdegree_bl(context_basic_stats(context)->J); }
+FP_T BCT_NAMESPACE::batch_jdegree_id(graph_context* context) { return (FP_T)jdegree_id(context_basic_stats(context)->J); }
+FP_T BCT_NAMESPACE::batch_jdegree_od(graph_context* context) { return (FP_T)jdegree_od(context_basic_stats(context)->J); }
+FP_T BCT_NAMESPACE::batch_normalized_path_length(graph_context* context) { return normalized_path_length(context_distance_bin(context)); }
+VECTOR_T* BCT_NAMESPACE::batch_module_degree_zscore(graph_context* context) { return module_degree_zscore(context); }
+VECTOR_T* BCT_NAMESPACE::batch_participation_coef(graph_context* context) { return participation_coef(context); }
+VECTOR_T* BCT_NAMESPACE::batch_strengths_dir(graph_context* context) { return strengths_dir(context->W); }
+VECTOR_T* BCT_NAMESPACE::batch_strengths_und(graph_context* context) { return copy(context_strengths_und(context)); }
+
+FP_T BCT_NAMESPACE::batch_charpath_diameter(graph_context* context) {
+	FP_T diameter;
+	VECTOR_T* ecc = charpath_ecc(context_distance_bin(context), NULL, &diameter);
+	VECTOR_ID(free)(ecc);
+	return diameter;
+}
+
+FP_T BCT_NAMESPACE::batch_charpath_radius(graph_context* context) {
+	FP_T radius;
+	VECTOR_T* ecc = charpath_ecc(context_distance_bin(context), &radius);
+	VECTOR_ID(free)(ecc);
+	return radius;
+}
+
+/*
+ * efficiency_global takes distances along inverted weights, which for a binary
+ * graph are the distances of distance_bin.  No cached distance matrix applies
+ * to a weighted graph, so its distances are computed one row at a time.
+ */
+FP_T BCT_NAMESPACE::batch_efficiency_global(graph_context* context) {
+	if (matrix_status(context->W, BINARY) & BINARY) {
+		return efficiency_global(context->W, context_distance_bin(context));
+	} else {
+		return efficiency_global(context->W);
+	}
+}
+
+FP_T BCT_NAMESPACE::batch_modularity_und(graph_context* context) {
+	FP_T Q;
+	context_modules(context, &Q);
+	return Q;
+}
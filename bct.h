@@ -28,9 +28,14 @@
 
 #ifndef SKIP
 
+#include <climits>
+#include <cstddef>
+#include <memory>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "kernels.h"
 #include "matlab/matlab.h"
 
 namespace BCT_NAMESPACE {
@@ -41,13 +46,99 @@ namespace BCT_NAMESPACE {
 		bct_exception(const std::string& what_arg) : std::runtime_error(what_arg) { }
 	};
 
+	// Sparse graph representation
+	struct adjacency_list {
+		int size;
+		int capacity;
+		int* offsets;
+		int* nodes;
+		FP_T* weights;
+	};
+	adjacency_list* adjacency_list_alloc(int size, int edges);
+	void adjacency_list_free(adjacency_list* adj);
+	adjacency_list* to_adjacency_list(const MATRIX_T* m);
+	void to_adjacency_list_into(const MATRIX_T* m, adjacency_list* adj);
+	bct_kernels::graph_view<FP_T> to_graph_view(const adjacency_list* adj);
+	
+	// Analysis contexts, defined below
+	struct graph_context;
+	
+	// Bit matrices
+	const int bit_matrix_word_bits = CHAR_BIT * sizeof(unsigned long);
+	struct bit_matrix {
+		int size1;
+		int size2;
+		int words;
+		unsigned long* data;
+	};
+	bit_matrix* bit_matrix_alloc(int size1, int size2);
+	void bit_matrix_free(bit_matrix* m);
+	bool bit_matrix_get(const bit_matrix* m, int i, int j);
+	void bit_matrix_set(bit_matrix* m, int i, int j, bool value);
+	MATRIX_T* bit_matrix_to_matrix(const bit_matrix* m);
+	int bit_count(unsigned long bits);
+	int lowest_bit(unsigned long bits);
+	
+	// Packed symmetric matrices
+	struct packed_matrix {
+		int size;
+		FP_T* data;
+	};
+	packed_matrix* packed_matrix_alloc(int size);
+	void packed_matrix_free(packed_matrix* m);
+	FP_T packed_matrix_get(const packed_matrix* m, int i, int j);
+	void packed_matrix_set(packed_matrix* m, int i, int j, FP_T value);
+	FP_T* packed_matrix_row(packed_matrix* m, int i);
+	const FP_T* packed_matrix_const_row(const packed_matrix* m, int i);
+	packed_matrix* to_packed_matrix(const MATRIX_T* m);
+	MATRIX_T* packed_matrix_to_matrix(const packed_matrix* m);
+	adjacency_list* to_adjacency_list(const packed_matrix* m);
+	
+	// Breadth-first search
+	struct breadth_workspace {
+		int size;
+		int* color;
+		int* queue;
+		int head;
+		int count;
+	};
+	breadth_workspace* breadth_workspace_alloc(int size);
+	void breadth_workspace_free(breadth_workspace* ws);
+	
+	// Dijkstra's algorithm
+	struct distance_wei_workspace {
+		int size;
+		ACC_T* D_row;
+		bct_kernels::dijkstra_workspace<ACC_T> dijkstra;
+		adjacency_list* L;
+	};
+	distance_wei_workspace* distance_wei_workspace_alloc(int size);
+	void distance_wei_workspace_free(distance_wei_workspace* ws);
+
 	// Density, degree, and assortativity
 	FP_T assortativity_dir(const MATRIX_T* CIJ);
-	FP_T assortativity_und(const MATRIX_T* CIJ);
+	FP_T assortativity_und(const MATRIX_T* CIJ, const VECTOR_T* deg = NULL);
+	struct basic_stats {
+		VECTOR_T* deg;
+		VECTOR_T* id;
+		VECTOR_T* od;
+		VECTOR_T* str;
+		VECTOR_T* is;
+		VECTOR_T* os;
+		int edges;
+		FP_T density;
+		MATRIX_T* J;
+		FP_T assortativity;
+	};
+	basic_stats* basic_stats_dir(const MATRIX_T* CIJ);
+	void basic_stats_free(basic_stats* stats);
 	VECTOR_T* degrees_dir(const MATRIX_T* CIJ, VECTOR_T** id = NULL, VECTOR_T** od = NULL);
 	VECTOR_T* degrees_und(const MATRIX_T* CIJ);
+	VECTOR_T* degrees_und(const packed_matrix* CIJ);
+	void degrees_und_into(const MATRIX_T* CIJ, VECTOR_T* deg);
 	FP_T density_dir(const MATRIX_T* CIJ);
 	FP_T density_und(const MATRIX_T* CIJ);
+	FP_T density_und(const packed_matrix* CIJ);
 	MATRIX_T* jdegree(const MATRIX_T* CIJ);
 	int jdegree_bl(const MATRIX_T* J);
 	int jdegree_id(const MATRIX_T* J);
@@ -57,35 +148,59 @@ namespace BCT_NAMESPACE {
 	MATRIX_T* matching_ind_out(const MATRIX_T* CIJ);
 	VECTOR_T* strengths_dir(const MATRIX_T* CIJ, VECTOR_T** is = NULL, VECTOR_T** os = NULL);
 	VECTOR_T* strengths_und(const MATRIX_T* CIJ);
+	VECTOR_T* strengths_und(const packed_matrix* CIJ);
+	void strengths_und_into(const MATRIX_T* CIJ, VECTOR_T* str);
 
 	// Clustering
 	VECTOR_T* clustering_coef_bd(const MATRIX_T* A);
 	VECTOR_T* clustering_coef_bu(const MATRIX_T* G);
+	VECTOR_T* clustering_coef_bu(graph_context* context);
 	VECTOR_T* clustering_coef_wd(const MATRIX_T* W);
 	VECTOR_T* clustering_coef_wu(const MATRIX_T* W);
+	VECTOR_T* clustering_coef_wu(const adjacency_list* W);
+	VECTOR_T* clustering_coef_wu(const packed_matrix* W);
+	void clustering_coef_wu_into(const MATRIX_T* W, VECTOR_T* C, adjacency_list* adj = NULL);
+	void clustering_coef_wu_into(const adjacency_list* W, VECTOR_T* C);
 	VECTOR_T* efficiency_local(const MATRIX_T* G);
 
 	// Paths, distances, and cycles
 	VECTOR_T* breadth(const MATRIX_T* CIJ, int source, VECTOR_T** branch = NULL);
+	void breadth(const adjacency_list* adj, int source, breadth_workspace* ws, FP_T* distance, int* branch = NULL);
+	MATRIX_T* breadth_batch(const MATRIX_T* CIJ, const VECTOR_T* sources, MATRIX_T** branch = NULL);
+	void breadth_batch(const adjacency_list* adj, const int* sources, int count, breadth_workspace* ws, FP_T* distance, int* branch = NULL);
 	MATRIX_T* breadthdist(const MATRIX_T* CIJ, MATRIX_T** D = NULL);
 	VECTOR_T* charpath_ecc(const MATRIX_T* D, FP_T* radius = NULL, FP_T* diameter = NULL);
+	VECTOR_T* charpath_ecc_m(const MATRIX_T* L, FP_T* radius = NULL, FP_T* diameter = NULL);
 	FP_T charpath_lambda(const MATRIX_T* D);
-	FP_T capped_charpath_lambda(const MATRIX_T* G);
+	FP_T charpath_lambda_m(const MATRIX_T* L);
+	FP_T capped_charpath_lambda(const MATRIX_T* G, const MATRIX_T* D = NULL);
 	FP_T connectivity_length(const MATRIX_T* D);
+	VECTOR_T* cycprob(const MATRIX_T* CIJ, const VECTOR_T* sources, int qmax, VECTOR_T** pcyc = NULL);
 	VECTOR_T* cycprob_fcyc(const std::vector<MATRIX_T*>& Pq);
 	VECTOR_T* cycprob_pcyc(const std::vector<MATRIX_T*>& Pq);
 	MATRIX_T* distance_bin(const MATRIX_T* G);
 	MATRIX_T* distance_wei(const MATRIX_T* G);
+	void distance_wei_into(const MATRIX_T* G, MATRIX_T* D, distance_wei_workspace* ws = NULL);
+	void distance_wei_into(const adjacency_list* L, MATRIX_T* D, distance_wei_workspace* ws = NULL);
+	void distance_wei_row(const adjacency_list* L, int source, VECTOR_T* D_row, distance_wei_workspace* ws = NULL);
 	FP_T efficiency_global(const MATRIX_T* G, const MATRIX_T* D = NULL);
 	std::vector<MATRIX_T*> findpaths(const MATRIX_T* CIJ, const VECTOR_T* sources, int qmax, VECTOR_T** plq = NULL, int* qstop = NULL, MATRIX_T** allpths = NULL, MATRIX_T** util = NULL);
+	typedef void (*findpaths_visitor)(const int* path, int q, void* data);
+	VECTOR_T* findpaths_plq(const MATRIX_T* CIJ, const VECTOR_T* sources, int qmax, int* qstop = NULL, MATRIX_T** util = NULL, VECTOR_T** ncyc = NULL);
+	int findpaths_stream(const MATRIX_T* CIJ, const VECTOR_T* sources, int qmax, findpaths_visitor visitor, void* data = NULL);
 	std::vector<MATRIX_T*> findwalks(const MATRIX_T* CIJ, VECTOR_T** wlq = NULL);
+	VECTOR_T* findwalks_wlq(const MATRIX_T* CIJ, int qmax, MATRIX_T** Wq_diag = NULL, bool log_scale = false);
 	FP_T normalized_path_length(const MATRIX_T* D, FP_T wmax = 1.0);
 	FP_T normalized_path_length_m(const MATRIX_T* G, FP_T wmax = 1.0);
+	bit_matrix* reachability(const MATRIX_T* CIJ);
+	bit_matrix* reachability(const adjacency_list* adj);
 	MATRIX_T* reachdist(const MATRIX_T* CIJ, MATRIX_T** D = NULL);
 
 	// Centrality
 	VECTOR_T* betweenness_bin(const MATRIX_T* G);
 	VECTOR_T* betweenness_wei(const MATRIX_T* G);
+	VECTOR_T* betweenness_wei(const adjacency_list* L);
+	void betweenness_wei_into(const adjacency_list* L, VECTOR_T* BC);
 	MATRIX_T* edge_betweenness_bin(const MATRIX_T* G, VECTOR_T** BC = NULL);
 	MATRIX_T* edge_betweenness_wei(const MATRIX_T* G, VECTOR_T** BC = NULL);
 	MATRIX_T* erange(const MATRIX_T* CIJ, FP_T* eta = NULL, MATRIX_T** Eshort = NULL, FP_T* fs = NULL);
@@ -118,7 +233,11 @@ namespace BCT_NAMESPACE {
 	FP_T modularity_und(const MATRIX_T* A, VECTOR_T** Ci = NULL);
 	FP_T modularity_louvain_und(const MATRIX_T* W, VECTOR_T** Ci = NULL, int N = 100);
 	VECTOR_T* module_degree_zscore(const MATRIX_T* A, const VECTOR_T* Ci);
+	VECTOR_T* module_degree_zscore(graph_context* context);
+	MATRIX_T* module_strength(const MATRIX_T* W, const VECTOR_T* Ci);
+	MATRIX_T* module_strength(const adjacency_list* adj, const VECTOR_T* Ci);
 	VECTOR_T* participation_coef(const MATRIX_T* A, const VECTOR_T* Ci);
+	VECTOR_T* participation_coef(graph_context* context);
 	
 	// Synthetic connection networks
 	MATRIX_T* makeevenCIJ(int N, int K, int sz_cl);
@@ -143,6 +262,7 @@ namespace BCT_NAMESPACE {
 	MATRIX_T* randmio_dir(const MATRIX_T* R, int ITER);
 	MATRIX_T* randmio_dir_connected(const MATRIX_T* R, int ITER);
 	MATRIX_T* randmio_und(const MATRIX_T* R, int ITER);
+	packed_matrix* randmio_und(const packed_matrix* R, int ITER);
 	MATRIX_T* randmio_und_connected(const MATRIX_T* R, int ITER);
 
 	// Data sets
@@ -153,6 +273,63 @@ namespace BCT_NAMESPACE {
 	MATRIX_T* get_macaque47();
 	MATRIX_T* get_macaque71();
 	
+	// Binary connectome files
+	struct connectome {
+		int size;
+		int edges;
+		MATRIX_T* m;
+		adjacency_list* adj;
+		void* data;
+		std::size_t length;
+	};
+	connectome* connectome_open(const std::string& filename);
+	void connectome_close(connectome* conn);
+	MATRIX_T* read_connectome(const std::string& filename);
+	void write_connectome(const MATRIX_T* m, const std::string& filename, bool sparse = false);
+	void write_connectome(const adjacency_list* adj, const std::string& filename);
+	
+	// Analysis contexts
+	struct graph_context {
+		const MATRIX_T* W;
+		adjacency_list* adj;
+		basic_stats* stats;
+		VECTOR_T* deg;
+		VECTOR_T* str;
+		VECTOR_T* triangles;
+		MATRIX_T* D_bin;
+		MATRIX_T* D_wei;
+		VECTOR_T* Ci;
+		FP_T Q;
+		MATRIX_T* S;
+		void* state;
+	};
+	graph_context* graph_context_alloc(const MATRIX_T* W);
+	void graph_context_free(graph_context* context);
+	const adjacency_list* context_adjacency_list(graph_context* context);
+	const basic_stats* context_basic_stats(graph_context* context);
+	const VECTOR_T* context_degrees_und(graph_context* context);
+	const VECTOR_T* context_strengths_und(graph_context* context);
+	const VECTOR_T* context_triangles(graph_context* context);
+	const MATRIX_T* context_distance_bin(graph_context* context);
+	const MATRIX_T* context_distance_wei(graph_context* context);
+	const VECTOR_T* context_modules(graph_context* context, FP_T* Q = NULL);
+	const MATRIX_T* context_module_strength(graph_context* context);
+	VECTOR_T* context_measure(graph_context* context, const std::string& measure);
+	
+	// Batch analysis
+	struct batch_result {
+		int graphs;
+		std::vector<int> nodes;
+		std::vector<std::string> measures;
+		std::vector<MATRIX_T*> values;
+	};
+	std::vector<std::string> batch_measures();
+	batch_result* batch_run(const std::vector<MATRIX_T*>& graphs, const std::vector<std::string>& measures);
+	batch_result* batch_run(const std::vector<MATRIX_T*>& graphs, const std::string& measures);
+	void batch_run(const std::vector<MATRIX_T*>& graphs, const std::string& measures, const std::string& filename);
+	void batch_result_free(batch_result* result);
+	void write_batch_result(const batch_result* result, const std::string& filename);
+	
 	// Matrix status checking
 	enum status {
 		SQUARE = 1, RECTANGULAR = 2,
@@ -175,14 +352,25 @@ namespace BCT_NAMESPACE {
 	bool is_signed(const MATRIX_T* m);
 	bool has_loops(const MATRIX_T* m);
 	bool has_no_loops(const MATRIX_T* m);
+	int matrix_status(const MATRIX_T* m);
+	int matrix_status(const MATRIX_T* m, int flags);
+	void cache_status(const MATRIX_T* m);
+	void uncache_status(const MATRIX_T* m);
+	void clear_status_cache();
 
 	// Matrix conversion
 	MATRIX_T* invert_elements(const MATRIX_T* m);
+	void invert_elements_in_place(MATRIX_T* m);
 	MATRIX_T* remove_loops(const MATRIX_T* m);
+	void remove_loops_in_place(MATRIX_T* m);
 	MATRIX_T* to_binary(const MATRIX_T* m);
+	void to_binary_in_place(MATRIX_T* m);
 	MATRIX_T* to_positive(const MATRIX_T* m);
+	void to_positive_in_place(MATRIX_T* m);
 	MATRIX_T* to_undirected_bin(const MATRIX_T* m);
+	void to_undirected_bin_in_place(MATRIX_T* m);
 	MATRIX_T* to_undirected_wei(const MATRIX_T* m);
+	void to_undirected_wei_in_place(MATRIX_T* m);
 	
 	// Utility
 	void gsl_error_handler(const char* reason, const char* file, int line, int gsl_errno);
@@ -193,15 +381,106 @@ namespace BCT_NAMESPACE {
 	void init();
 	int number_of_edges_dir(const MATRIX_T* m);
 	int number_of_edges_und(const MATRIX_T* m);
+	int number_of_edges_und(const packed_matrix* m);
 	int number_of_nodes(const MATRIX_T* m);
 	MATRIX_T* threshold_absolute(const MATRIX_T* W, FP_T thr);
 	MATRIX_T* threshold_proportional_dir(const MATRIX_T* W, FP_T p);
 	MATRIX_T* threshold_proportional_und(const MATRIX_T* W, FP_T p);
+	packed_matrix* threshold_proportional_und(const packed_matrix* W, FP_T p);
+	
+	// Threshold sweeps
+	typedef void (*threshold_sweep_hook)(int i, int j, FP_T weight, bool added, void* data);
+	struct threshold_sweep {
+		MATRIX_T* W_thr;
+		bool undirected;
+		int n_candidates;
+		int* rows;
+		int* columns;
+		FP_T* weights;
+		int edges;
+		VECTOR_T* deg;
+		VECTOR_T* str;
+		int* parent;
+		int components;
+		threshold_sweep_hook hook;
+		void* hook_data;
+	};
+	threshold_sweep* threshold_sweep_alloc(const MATRIX_T* W, bool undirected);
+	void threshold_sweep_free(threshold_sweep* sweep);
+	const MATRIX_T* threshold_sweep_edges(threshold_sweep* sweep, int edges);
+	const MATRIX_T* threshold_sweep_absolute(threshold_sweep* sweep, FP_T thr);
+	const MATRIX_T* threshold_sweep_proportional(threshold_sweep* sweep, FP_T p);
+	FP_T threshold_sweep_density(const threshold_sweep* sweep);
+	int threshold_sweep_components(threshold_sweep* sweep);
 	
 	// Debugging
 	void printf(const VECTOR_T* v, const std::string& format);
 	void printf(const MATRIX_T* m, const std::string& format);
 	void printf(const gsl_permutation* p, const std::string& format);
+
+#if __cplusplus >= 201103L
+	// Owning handles and non-owning views (C++11)
+	struct deleter {
+		void operator()(VECTOR_T* v) const { VECTOR_ID(free)(v); }
+		void operator()(MATRIX_T* m) const { MATRIX_ID(free)(m); }
+		void operator()(gsl_permutation* p) const { gsl_permutation_free(p); }
+		void operator()(adjacency_list* adj) const { adjacency_list_free(adj); }
+		void operator()(bit_matrix* m) const { bit_matrix_free(m); }
+		void operator()(packed_matrix* m) const { packed_matrix_free(m); }
+		void operator()(breadth_workspace* ws) const { breadth_workspace_free(ws); }
+		void operator()(distance_wei_workspace* ws) const { distance_wei_workspace_free(ws); }
+		void operator()(basic_stats* stats) const { basic_stats_free(stats); }
+		void operator()(connectome* conn) const { connectome_close(conn); }
+		void operator()(graph_context* context) const { graph_context_free(context); }
+		void operator()(batch_result* result) const { batch_result_free(result); }
+		void operator()(threshold_sweep* sweep) const { threshold_sweep_free(sweep); }
+	};
+	template<class T> using handle = std::unique_ptr<T, deleter>;
+	typedef handle<VECTOR_T> vector_handle;
+	typedef handle<MATRIX_T> matrix_handle;
+	
+	// Takes ownership of a result: matrix_handle D = own(distance_wei(G));
+	template<class T> handle<T> own(T* p) { return handle<T>(p); }
+	inline std::vector<matrix_handle> own(std::vector<MATRIX_T*> m) {
+		std::vector<matrix_handle> handles;
+		handles.reserve(m.size());
+		for (std::size_t i = 0; i < m.size(); i++) {
+			handles.push_back(matrix_handle(m[i]));
+		}
+		return handles;
+	}
+	
+	// Passes a handle as an optional output, which it owns once the call
+	// returns: vector_handle BC; own(edge_betweenness_wei(G, output(BC)));
+	template<class T> class output_handle {
+	public:
+		explicit output_handle(handle<T>& h) : h(&h), p(NULL) { }
+		output_handle(output_handle&& other) : h(other.h), p(other.p) { other.h = NULL; }
+		output_handle& operator=(const output_handle&) = delete;
+		~output_handle() { if (h != NULL) h->reset(p); }
+		operator T**() { return &p; }
+	private:
+		handle<T>* h;
+		T* p;
+	};
+	template<class T> output_handle<T> output(handle<T>& h) { return output_handle<T>(h); }
+	
+	// Refers to a matrix, vector, or other object without owning it, so that one
+	// parameter accepts raw pointers and handles alike
+	template<class T> class view {
+	public:
+		view(const T* p) : p(p) { }
+		view(const handle<T>& h) : p(h.get()) { }
+		view(handle<T>&&) = delete;
+		const T* get() const { return p; }
+		operator const T*() const { return p; }
+		const T* operator->() const { return p; }
+	private:
+		const T* p;
+	};
+	typedef view<VECTOR_T> vector_view;
+	typedef view<MATRIX_T> matrix_view;
+#endif
 }
 
 #endif
@@ -15,6 +15,19 @@
 %apply int* OUTPUT { int* qstop, int* K };
 %apply double* OUTPUT { double* radius, double* diameter, double* eta, double* fs };
 
+// Batch results are returned as a dictionary of matrices, one per measure, with
+// one row per graph
+%typemap(out) bct::batch_result* {
+	PyObject* values = PyDict_New();
+	for (int k = 0; k < (int)$1->measures.size(); k++) {
+		PyObject* value = SWIG_NewPointerObj($1->values[k], $descriptor(gsl_matrix*), 0);
+		PyDict_SetItemString(values, $1->measures[k].c_str(), value);
+		Py_DECREF(value);
+	}
+	delete $1;
+	%append_output(values);
+}
+
 %typemap(in, numinputs = 0) gsl_vector** (gsl_vector* temp) { $1 = &temp; }
 %typemap(argout) gsl_vector** { %append_output(SWIG_NewPointerObj(*$1, $descriptor(gsl_vector*), 0)); }
 
@@ -25,9 +38,10 @@ namespace bct {
 
 	// Density, degree, and assortativity
 	double assortativity_dir(const gsl_matrix* CIJ);
-	double assortativity_und(const gsl_matrix* CIJ);
+	double assortativity_und(const gsl_matrix* CIJ, const gsl_vector* deg = NULL);
 	gsl_vector* degrees_dir(const gsl_matrix* CIJ, gsl_vector** id, gsl_vector** od);
 	gsl_vector* degrees_und(const gsl_matrix* CIJ);
+	void degrees_und_into(const gsl_matrix* CIJ, gsl_vector* deg);
 	double density_dir(const gsl_matrix* CIJ);
 	double density_und(const gsl_matrix* CIJ);
 	gsl_matrix* jdegree(const gsl_matrix* CIJ);
@@ -39,28 +53,37 @@ namespace bct {
 	gsl_matrix* matching_ind_out(const gsl_matrix* CIJ);
 	gsl_vector* strengths_dir(const gsl_matrix* CIJ, gsl_vector** _is, gsl_vector** os);
 	gsl_vector* strengths_und(const gsl_matrix* CIJ);
+	void strengths_und_into(const gsl_matrix* CIJ, gsl_vector* str);
 
 	// Clustering
 	gsl_vector* clustering_coef_bd(const gsl_matrix* A);
 	gsl_vector* clustering_coef_bu(const gsl_matrix* G);
 	gsl_vector* clustering_coef_wd(const gsl_matrix* W);
 	gsl_vector* clustering_coef_wu(const gsl_matrix* W);
+	void clustering_coef_wu_into(const gsl_matrix* W, gsl_vector* C);
 	gsl_vector* efficiency_local(const gsl_matrix* G);
 
 	// Paths, distances, and cycles
 	gsl_vector* breadth(const gsl_matrix* CIJ, int source, gsl_vector** branch);
+	gsl_matrix* breadth_batch(const gsl_matrix* CIJ, const gsl_vector* sources, gsl_matrix** branch);
 	gsl_matrix* breadthdist(const gsl_matrix* CIJ, gsl_matrix** D);
 	gsl_vector* charpath_ecc(const gsl_matrix* D, double* radius, double* diameter);
+	gsl_vector* charpath_ecc_m(const gsl_matrix* L, double* radius, double* diameter);
 	double charpath_lambda(const gsl_matrix* D);
-	double capped_charpath_lambda(const gsl_matrix* G);
+	double charpath_lambda_m(const gsl_matrix* L);
+	double capped_charpath_lambda(const gsl_matrix* G, const gsl_matrix* D = NULL);
 	double connectivity_length(const gsl_matrix* D);
+	gsl_vector* cycprob(const gsl_matrix* CIJ, const gsl_vector* sources, int qmax, gsl_vector** pcyc);
 	gsl_vector* cycprob_fcyc(const std::vector<gsl_matrix*>& Pq);
 	gsl_vector* cycprob_pcyc(const std::vector<gsl_matrix*>& Pq);
 	gsl_matrix* distance_bin(const gsl_matrix* G);
 	gsl_matrix* distance_wei(const gsl_matrix* G); 
+	void distance_wei_into(const gsl_matrix* G, gsl_matrix* D);
 	double efficiency_global(const gsl_matrix* G, const gsl_matrix* D = NULL);
 	std::vector<gsl_matrix*> findpaths(const gsl_matrix* CIJ, const gsl_vector* sources, int qmax, gsl_vector** plq, int* qstop, gsl_matrix** allpths, gsl_matrix** util);
+	gsl_vector* findpaths_plq(const gsl_matrix* CIJ, const gsl_vector* sources, int qmax, int* qstop, gsl_matrix** util, gsl_vector** ncyc);
 	std::vector<gsl_matrix*> findwalks(const gsl_matrix* CIJ, gsl_vector** wlq);
+	gsl_vector* findwalks_wlq(const gsl_matrix* CIJ, int qmax, gsl_matrix** Wq_diag, bool log_scale = false);
 	double normalized_path_length(const gsl_matrix* D, double wmax = 1.0);
 	double normalized_path_length_m(const gsl_matrix* G, double wmax = 1.0);
 	gsl_matrix* reachdist(const gsl_matrix* CIJ, gsl_matrix** D);
@@ -100,6 +123,7 @@ namespace bct {
 	double modularity_und(const gsl_matrix* A, gsl_vector** Ci);
 	double modularity_louvain_und(const gsl_matrix* W, gsl_vector** Ci, int N = 100);
 	gsl_vector* module_degree_zscore(const gsl_matrix* A, const gsl_vector* Ci);
+	gsl_matrix* module_strength(const gsl_matrix* W, const gsl_vector* Ci);
 	gsl_vector* participation_coef(const gsl_matrix* A, const gsl_vector* Ci);
 	
 	// Synthetic connection networks
@@ -135,6 +159,16 @@ namespace bct {
 	gsl_matrix* get_macaque47();
 	gsl_matrix* get_macaque71();
 	
+	// Binary connectome files
+	gsl_matrix* read_connectome(const std::string& filename);
+	void write_connectome(const gsl_matrix* m, const std::string& filename, bool sparse = false);
+	
+	// Batch analysis; graphs is a vector made with to_gsl3dm, and graphs are
+	// analyzed in parallel when the library is built with OpenMP (see
+	// openmp_flags in Makefile.vars)
+	batch_result* batch_run(const std::vector<gsl_matrix*>& graphs, const std::string& measures);
+	void batch_run(const std::vector<gsl_matrix*>& graphs, const std::string& measures, const std::string& filename);
+	
 	// Matrix status checking
 	enum status {
 		SQUARE = 1, RECTANGULAR = 2,
@@ -157,14 +191,25 @@ namespace bct {
 	bool is_signed(const gsl_matrix* m);
 	bool has_loops(const gsl_matrix* m);
 	bool has_no_loops(const gsl_matrix* m);
+	int matrix_status(const gsl_matrix* m);
+	int matrix_status(const gsl_matrix* m, int flags);
+	void cache_status(const gsl_matrix* m);
+	void uncache_status(const gsl_matrix* m);
+	void clear_status_cache();
 	
 	// Matrix conversion
 	gsl_matrix* invert_elements(const gsl_matrix* m);
+	void invert_elements_in_place(gsl_matrix* m);
 	gsl_matrix* remove_loops(const gsl_matrix* m);
+	void remove_loops_in_place(gsl_matrix* m);
 	gsl_matrix* to_binary(const gsl_matrix* m);
+	void to_binary_in_place(gsl_matrix* m);
 	gsl_matrix* to_positive(const gsl_matrix* m);
+	void to_positive_in_place(gsl_matrix* m);
 	gsl_matrix* to_undirected_bin(const gsl_matrix* m);
+	void to_undirected_bin_in_place(gsl_matrix* m);
 	gsl_matrix* to_undirected_wei(const gsl_matrix* m);
+	void to_undirected_wei_in_place(gsl_matrix* m);
 	
 	// Utility
 	void gsl_error_handler(const char* reason, const char* file, int line, int gsl_errno);
@@ -365,6 +410,9 @@ namespace matlab {
 	gsl_matrix* permute_rows(const gsl_permutation* p, const gsl_matrix* m);
 }
 
+// The conversion functions use the Python API, so they keep the GIL
+%exception;
+
 PyObject* from_gsl(const gsl_vector* v);
 PyObject* from_gsl(const gsl_matrix* m);
 PyObject* from_gsl(const std::vector<gsl_matrix*>& m);
@@ -15,39 +15,75 @@
 %apply int* OUTPUT { int* qstop, int* K };
 %apply double* OUTPUT { double* radius, double* diameter, double* eta, double* fs };
 
+// Arguments are NumPy arrays (or lists) viewed in place as GSL vectors and
+// matrices; an array of doubles in C order is not copied.  Non-const arguments
+// are written through to the array.  Results are returned as NumPy arrays that
+// own the GSL allocation.
 %typemap(typecheck) gsl_vector* { $1 = is_gslv($input) ? 1 : 0; }
-%typemap(in) gsl_vector* { $1 = to_gslv($input); }
-%typemap(freearg) gsl_vector* { bct::gsl_free($1); }
-%typemap(out) gsl_vector* { %append_output(from_gsl($1)); bct::gsl_free($1); }
+%typemap(in) const gsl_vector* (PyArrayObject* array = NULL) { array = to_carray($input, 1, false); $1 = view_gslv(array); if ($1 == NULL) SWIG_fail; }
+%typemap(in) gsl_vector* (PyArrayObject* array = NULL) { array = to_carray($input, 1, true); $1 = view_gslv(array); if ($1 == NULL) SWIG_fail; }
+%typemap(freearg) gsl_vector* { bct::gsl_free($1); release_carray(array$argnum); }
+%typemap(out) gsl_vector* { PyObject* array = to_ndarray($1); if (array == NULL) SWIG_fail; %append_output(array); }
 
 %typemap(typecheck) gsl_matrix* { $1 = is_gslm($input) ? 1 : 0; }
-%typemap(in) gsl_matrix* { $1 = to_gslm($input); }
-%typemap(freearg) gsl_matrix* { bct::gsl_free($1); }
-%typemap(out) gsl_matrix* { %append_output(from_gsl($1)); bct::gsl_free($1); }
+%typemap(in) const gsl_matrix* (PyArrayObject* array = NULL) { array = to_carray($input, 2, false); $1 = view_gslm(array); if ($1 == NULL) SWIG_fail; }
+%typemap(in) gsl_matrix* (PyArrayObject* array = NULL) { array = to_carray($input, 2, true); $1 = view_gslm(array); if ($1 == NULL) SWIG_fail; }
+%typemap(freearg) gsl_matrix* { bct::gsl_free($1); release_carray(array$argnum); }
+%typemap(out) gsl_matrix* { PyObject* array = to_ndarray($1); if (array == NULL) SWIG_fail; %append_output(array); }
 
 %typemap(typecheck) std::vector<gsl_matrix*> { $1 = is_gsl3dm($input) ? 1 : 0; }
 %typemap(in) std::vector<gsl_matrix*> { $1 = to_gsl3dm($input); }
 %typemap(freearg) std::vector<gsl_matrix*> { bct::gsl_free($1); }
-%typemap(out) std::vector<gsl_matrix*> { %append_output(from_gsl($1)); bct::gsl_free($1); }
+%typemap(out) std::vector<gsl_matrix*> { PyObject* array = to_ndarray($1); if (array == NULL) SWIG_fail; %append_output(array); }
+
+// Sequences of matrices taken by const reference (batch_run, cycprob_fcyc, and
+// cycprob_pcyc) are copied into a temporary vector for the call
+%typemap(typecheck) const std::vector<gsl_matrix*>& { $1 = is_gsl3dm($input) ? 1 : 0; }
+%typemap(in) const std::vector<gsl_matrix*>& (std::vector<gsl_matrix*> temp) { temp = to_gsl3dm($input); $1 = &temp; if (PyErr_Occurred() != NULL) SWIG_fail; }
+%typemap(freearg) const std::vector<gsl_matrix*>& { bct::gsl_free(*$1); }
 
 %typemap(typecheck) gsl_permutation* { $1 = is_gslp($input) ? 1 : 0; }
 %typemap(in) gsl_permutation* { $1 = to_gslp($input); }
 %typemap(freearg) gsl_permutation* { bct::gsl_free($1); }
 %typemap(out) gsl_permutation* { %append_output(from_gsl($1)); bct::gsl_free($1); }
 
+// Batch results are returned as a dictionary of arrays, one per measure, with
+// one row per graph
+%typemap(out) bct::batch_result* {
+	PyObject* values = PyDict_New();
+	for (int k = 0; k < (int)$1->measures.size(); k++) {
+		PyObject* value = NULL;
+		if (values != NULL) {
+			value = to_ndarray($1->values[k]);
+		} else {
+			gsl_matrix_free($1->values[k]);
+		}
+		$1->values[k] = NULL;
+		if (value == NULL || PyDict_SetItemString(values, $1->measures[k].c_str(), value) != 0) {
+			Py_XDECREF(values);
+			values = NULL;
+		}
+		Py_XDECREF(value);
+	}
+	delete $1;
+	if (values == NULL) SWIG_fail;
+	%append_output(values);
+}
+
 %typemap(in, numinputs = 0) gsl_vector** (gsl_vector* temp) { $1 = &temp; }
-%typemap(argout) gsl_vector** { %append_output(from_gsl(*$1)); bct::gsl_free(*$1); }
+%typemap(argout) gsl_vector** { PyObject* array = to_ndarray(*$1); if (array == NULL) SWIG_fail; %append_output(array); }
 
 %typemap(in, numinputs = 0) gsl_matrix** (gsl_matrix* temp) { $1 = &temp; }
-%typemap(argout) gsl_matrix** { %append_output(from_gsl(*$1)); bct::gsl_free(*$1); }
+%typemap(argout) gsl_matrix** { PyObject* array = to_ndarray(*$1); if (array == NULL) SWIG_fail; %append_output(array); }
 
 namespace bct {
 
 	// Density, degree, and assortativity
 	double assortativity_dir(const gsl_matrix* CIJ);
-	double assortativity_und(const gsl_matrix* CIJ);
+	double assortativity_und(const gsl_matrix* CIJ, const gsl_vector* deg = NULL);
 	gsl_vector* degrees_dir(const gsl_matrix* CIJ, gsl_vector** id, gsl_vector** od);
 	gsl_vector* degrees_und(const gsl_matrix* CIJ);
+	void degrees_und_into(const gsl_matrix* CIJ, gsl_vector* deg);
 	double density_dir(const gsl_matrix* CIJ);
 	double density_und(const gsl_matrix* CIJ);
 	gsl_matrix* jdegree(const gsl_matrix* CIJ);
@@ -59,28 +95,37 @@ namespace bct {
 	gsl_matrix* matching_ind_out(const gsl_matrix* CIJ);
 	gsl_vector* strengths_dir(const gsl_matrix* CIJ, gsl_vector** _is, gsl_vector** os);
 	gsl_vector* strengths_und(const gsl_matrix* CIJ);
+	void strengths_und_into(const gsl_matrix* CIJ, gsl_vector* str);
 
 	// Clustering
 	gsl_vector* clustering_coef_bd(const gsl_matrix* A);
 	gsl_vector* clustering_coef_bu(const gsl_matrix* G);
 	gsl_vector* clustering_coef_wd(const gsl_matrix* W);
 	gsl_vector* clustering_coef_wu(const gsl_matrix* W);
+	void clustering_coef_wu_into(const gsl_matrix* W, gsl_vector* C);
 	gsl_vector* efficiency_local(const gsl_matrix* G);
 
 	// Paths, distances, and cycles
 	gsl_vector* breadth(const gsl_matrix* CIJ, int source, gsl_vector** branch);
+	gsl_matrix* breadth_batch(const gsl_matrix* CIJ, const gsl_vector* sources, gsl_matrix** branch);
 	gsl_matrix* breadthdist(const gsl_matrix* CIJ, gsl_matrix** D);
 	gsl_vector* charpath_ecc(const gsl_matrix* D, double* radius, double* diameter);
+	gsl_vector* charpath_ecc_m(const gsl_matrix* L, double* radius, double* diameter);
 	double charpath_lambda(const gsl_matrix* D);
-	double capped_charpath_lambda(const gsl_matrix* G);
+	double charpath_lambda_m(const gsl_matrix* L);
+	double capped_charpath_lambda(const gsl_matrix* G, const gsl_matrix* D = NULL);
 	double connectivity_length(const gsl_matrix* D);
+	gsl_vector* cycprob(const gsl_matrix* CIJ, const gsl_vector* sources, int qmax, gsl_vector** pcyc);
 	gsl_vector* cycprob_fcyc(const std::vector<gsl_matrix*>& Pq);
 	gsl_vector* cycprob_pcyc(const std::vector<gsl_matrix*>& Pq);
 	gsl_matrix* distance_bin(const gsl_matrix* G);
 	gsl_matrix* distance_wei(const gsl_matrix* G); 
+	void distance_wei_into(const gsl_matrix* G, gsl_matrix* D);
 	double efficiency_global(const gsl_matrix* G, const gsl_matrix* D = NULL);
 	std::vector<gsl_matrix*> findpaths(const gsl_matrix* CIJ, const gsl_vector* sources, int qmax, gsl_vector** plq, int* qstop, gsl_matrix** allpths, gsl_matrix** util);
+	gsl_vector* findpaths_plq(const gsl_matrix* CIJ, const gsl_vector* sources, int qmax, int* qstop, gsl_matrix** util, gsl_vector** ncyc);
 	std::vector<gsl_matrix*> findwalks(const gsl_matrix* CIJ, gsl_vector** wlq);
+	gsl_vector* findwalks_wlq(const gsl_matrix* CIJ, int qmax, gsl_matrix** Wq_diag, bool log_scale = false);
 	double normalized_path_length(const gsl_matrix* D, double wmax = 1.0);
 	double normalized_path_length_m(const gsl_matrix* G, double wmax = 1.0);
 	gsl_matrix* reachdist(const gsl_matrix* CIJ, gsl_matrix** D);
@@ -120,6 +165,7 @@ namespace bct {
 	double modularity_und(const gsl_matrix* A, gsl_vector** Ci);
 	double modularity_louvain_und(const gsl_matrix* W, gsl_vector** Ci, int N = 100);
 	gsl_vector* module_degree_zscore(const gsl_matrix* A, const gsl_vector* Ci);
+	gsl_matrix* module_strength(const gsl_matrix* W, const gsl_vector* Ci);
 	gsl_vector* participation_coef(const gsl_matrix* A, const gsl_vector* Ci);
 	
 	// Synthetic connection networks
@@ -155,6 +201,15 @@ namespace bct {
 	gsl_matrix* get_macaque47();
 	gsl_matrix* get_macaque71();
 	
+	// Binary connectome files
+	gsl_matrix* read_connectome(const std::string& filename);
+	void write_connectome(const gsl_matrix* m, const std::string& filename, bool sparse = false);
+	
+	// Batch analysis; graphs are analyzed in parallel when the library is built
+	// with OpenMP (see openmp_flags in Makefile.vars)
+	batch_result* batch_run(const std::vector<gsl_matrix*>& graphs, const std::string& measures);
+	void batch_run(const std::vector<gsl_matrix*>& graphs, const std::string& measures, const std::string& filename);
+	
 	// Matrix status checking
 	enum status {
 		SQUARE = 1, RECTANGULAR = 2,
@@ -177,14 +232,25 @@ namespace bct {
 	bool is_signed(const gsl_matrix* m);
 	bool has_loops(const gsl_matrix* m);
 	bool has_no_loops(const gsl_matrix* m);
+	int matrix_status(const gsl_matrix* m);
+	int matrix_status(const gsl_matrix* m, int flags);
+	void cache_status(const gsl_matrix* m);
+	void uncache_status(const gsl_matrix* m);
+	void clear_status_cache();
 	
 	// Matrix conversion
 	gsl_matrix* invert_elements(const gsl_matrix* m);
+	void invert_elements_in_place(gsl_matrix* m);
 	gsl_matrix* remove_loops(const gsl_matrix* m);
+	void remove_loops_in_place(gsl_matrix* m);
 	gsl_matrix* to_binary(const gsl_matrix* m);
+	void to_binary_in_place(gsl_matrix* m);
 	gsl_matrix* to_positive(const gsl_matrix* m);
+	void to_positive_in_place(gsl_matrix* m);
 	gsl_matrix* to_undirected_bin(const gsl_matrix* m);
+	void to_undirected_bin_in_place(gsl_matrix* m);
 	gsl_matrix* to_undirected_wei(const gsl_matrix* m);
+	void to_undirected_wei_in_place(gsl_matrix* m);
 	
 	// Utility
 	void gsl_error_handler(const char* reason, const char* file, int line, int gsl_errno);
@@ -0,0 +1,905 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "../bct.h"
+
+/*
+ * Times the measures in bct.h on synthetic graphs generated by the library.
+ * Each graph family is generated over a grid of sizes and densities, every
+ * measure that accepts a graph is run with warmup and repeats, and the results
+ * are written as JSON so that they can be compared between releases.
+ */
+namespace bct_bench {
+	
+	// Quantities that some measures take instead of the graph itself, computed
+	// once per graph outside of the timed region
+	struct input {
+		const MATRIX_T* W;
+		bool undirected;
+		FP_T density;
+		MATRIX_T* D;
+		VECTOR_T* Ci;
+		VECTOR_T* sources;
+		BCT_NAMESPACE::adjacency_list* adj;
+		BCT_NAMESPACE::packed_matrix* packed;
+		std::vector<MATRIX_T*> graphs;
+		std::vector<std::string> measures;
+		
+		// Outputs and scratch space for the _into functions, allocated once
+		// so that only the measure itself is timed
+		VECTOR_T* vector_out;
+		MATRIX_T* matrix_out;
+		BCT_NAMESPACE::adjacency_list* adj_scratch;
+		BCT_NAMESPACE::distance_wei_workspace* ws;
+		BCT_NAMESPACE::breadth_workspace* breadth_ws;
+		int* source_nodes;
+		
+		// The graph written as dense and sparse connectome files
+		std::string dense_file;
+		std::string sparse_file;
+	};
+	
+	// Path length used by measures that enumerate paths, walks, or cycles
+	const int qmax = 3;
+	
+	// Rewiring iterations per edge for randmio_* and latmio_*
+	const int rewiring_iterations = 1;
+	
+	// Densest graph that is rewired; rewiring retries until it finds a pair of
+	// edges that can be swapped, which may never happen in a dense graph
+	const FP_T max_rewiring_density = 0.5;
+	
+	// Proportion of weights kept by threshold_proportional_*, and the number
+	// of proportions visited by threshold_sweep
+	const FP_T threshold_p = 0.5;
+	const int sweep_steps = 10;
+	
+	// Minimum duration of a timed sample; cheap measures are run several times
+	// per sample so that timer resolution does not dominate
+	const double min_sample_ns = 1.0e6;
+	
+	/*
+	 * A measure is run on every graph whose status includes the flags it
+	 * requires (see matrix_status).
+	 */
+	struct benchmark {
+		const char* name;
+		int requires;
+		void (*run)(const input* in);
+	};
+	
+	/*
+	 * A family is generated with a target density, except for makefractalCIJ,
+	 * whose density is set by its hierarchy and is only reported.
+	 */
+	struct family {
+		const char* name;
+		bool sweeps_density;
+		MATRIX_T* (*generate)(int N, FP_T density);
+	};
+	
+	struct options {
+		std::vector<int> sizes;
+		std::vector<FP_T> densities;
+		std::vector<std::string> measures;
+		std::vector<std::string> families;
+		int warmup;
+		int repeats;
+		double max_op_s;
+		unsigned long seed;
+		std::string filename;
+	};
+
+#define BENCH_SCALAR(function_name, argument) \
+	void function_name(const input* in) { \
+		BCT_NAMESPACE::function_name(in->argument); \
+	}
+#define BENCH_VECTOR(function_name, argument) \
+	void function_name(const input* in) { \
+		VECTOR_ID(free)(BCT_NAMESPACE::function_name(in->argument)); \
+	}
+#define BENCH_MATRIX(function_name, argument) \
+	void function_name(const input* in) { \
+		MATRIX_ID(free)(BCT_NAMESPACE::function_name(in->argument)); \
+	}
+#define BENCH_REWIRING(function_name) \
+	void function_name(const input* in) { \
+		check_rewirable(in); \
+		MATRIX_ID(free)(BCT_NAMESPACE::function_name(in->W, rewiring_iterations)); \
+	}
+	
+	void check_rewirable(const input* in);
+	
+	BENCH_SCALAR(assortativity_dir, W)
+	BENCH_SCALAR(assortativity_und, W)
+	BENCH_VECTOR(betweenness_bin, W)
+	BENCH_VECTOR(betweenness_wei, W)
+	BENCH_MATRIX(breadthdist, W)
+	BENCH_SCALAR(capped_charpath_lambda, W)
+	BENCH_VECTOR(charpath_ecc, D)
+	BENCH_VECTOR(charpath_ecc_m, W)
+	BENCH_SCALAR(charpath_lambda, D)
+	BENCH_SCALAR(charpath_lambda_m, W)
+	BENCH_VECTOR(clustering_coef_bd, W)
+	BENCH_VECTOR(clustering_coef_bu, W)
+	BENCH_VECTOR(clustering_coef_wd, W)
+	BENCH_VECTOR(clustering_coef_wu, W)
+	BENCH_SCALAR(connectivity_length, D)
+	BENCH_VECTOR(degrees_dir, W)
+	BENCH_VECTOR(degrees_und, W)
+	BENCH_SCALAR(density_dir, W)
+	BENCH_SCALAR(density_und, W)
+	BENCH_MATRIX(distance_bin, W)
+	BENCH_MATRIX(distance_wei, W)
+	BENCH_MATRIX(edge_betweenness_bin, W)
+	BENCH_MATRIX(edge_betweenness_wei, W)
+	BENCH_SCALAR(efficiency_global, W)
+	BENCH_VECTOR(efficiency_local, W)
+	BENCH_VECTOR(eigenvector_centrality, W)
+	BENCH_MATRIX(erange, W)
+	BENCH_MATRIX(jdegree, W)
+	BENCH_REWIRING(latmio_dir)
+	BENCH_REWIRING(latmio_dir_connected)
+	BENCH_REWIRING(latmio_und)
+	BENCH_REWIRING(latmio_und_connected)
+	BENCH_MATRIX(matching_ind, W)
+	BENCH_SCALAR(modularity_dir, W)
+	BENCH_SCALAR(modularity_louvain_und, W)
+	BENCH_SCALAR(modularity_und, W)
+	BENCH_VECTOR(motif3funct_bin, W)
+	BENCH_MATRIX(motif3funct_wei, W)
+	BENCH_VECTOR(motif3struct_bin, W)
+	BENCH_MATRIX(motif3struct_wei, W)
+	BENCH_VECTOR(motif4funct_bin, W)
+	BENCH_MATRIX(motif4funct_wei, W)
+	BENCH_VECTOR(motif4struct_bin, W)
+	BENCH_MATRIX(motif4struct_wei, W)
+	BENCH_SCALAR(normalized_path_length, D)
+	BENCH_SCALAR(normalized_path_length_m, W)
+	BENCH_MATRIX(reachdist, W)
+	BENCH_REWIRING(randmio_dir)
+	BENCH_REWIRING(randmio_dir_connected)
+	BENCH_REWIRING(randmio_und)
+	BENCH_REWIRING(randmio_und_connected)
+	BENCH_VECTOR(strengths_dir, W)
+	BENCH_VECTOR(strengths_und, W)
+
+#undef BENCH_SCALAR
+#undef BENCH_VECTOR
+#undef BENCH_MATRIX
+#undef BENCH_REWIRING
+
+	void basic_stats_dir(const input* in);
+	void batch_run(const input* in);
+	void betweenness_wei_adj(const input* in);
+	void betweenness_wei_into(const input* in);
+	void breadth(const input* in);
+	void breadth_adj(const input* in);
+	void breadth_batch(const input* in);
+	void breadth_batch_adj(const input* in);
+	void clustering_coef_wu_adj(const input* in);
+	void clustering_coef_wu_into(const input* in);
+	void clustering_coef_wu_into_adj(const input* in);
+	void clustering_coef_wu_packed(const input* in);
+	void connectome_open(const input* in);
+	void connectome_open_sparse(const input* in);
+	void context_measures(const input* in);
+	void cycprob(const input* in);
+	void degrees_und_into(const input* in);
+	void degrees_und_packed(const input* in);
+	void density_und_packed(const input* in);
+	void distance_wei_into(const input* in);
+	void distance_wei_into_adj(const input* in);
+	void findpaths(const input* in);
+	void findpaths_plq(const input* in);
+	void findwalks(const input* in);
+	void findwalks_wlq(const input* in);
+	void module_degree_zscore(const input* in);
+	void module_strength(const input* in);
+	void module_strength_adj(const input* in);
+	void participation_coef(const input* in);
+	void randmio_und_packed(const input* in);
+	void reachability(const input* in);
+	void reachability_adj(const input* in);
+	void read_connectome(const input* in);
+	void strengths_und_into(const input* in);
+	void strengths_und_packed(const input* in);
+	void threshold_absolute(const input* in);
+	void threshold_proportional_dir(const input* in);
+	void threshold_proportional_und(const input* in);
+	void threshold_proportional_und_packed(const input* in);
+	void threshold_sweep(const input* in);
+	
+	const int S = BCT_NAMESPACE::SQUARE;
+	const int U = BCT_NAMESPACE::UNDIRECTED;
+	const int D = BCT_NAMESPACE::DIRECTED;
+	const int B = BCT_NAMESPACE::BINARY;
+	const int W = BCT_NAMESPACE::WEIGHTED;
+	const int P = BCT_NAMESPACE::POSITIVE;
+	
+	const benchmark benchmark_table[] = {
+		{ "assortativity_dir", S | D, assortativity_dir },
+		{ "assortativity_und", S | U, assortativity_und },
+		{ "basic_stats_dir", S, basic_stats_dir },
+		{ "batch_run", S, batch_run },
+		{ "betweenness_bin", S | B, betweenness_bin },
+		{ "betweenness_wei", S | W | P, betweenness_wei },
+		{ "betweenness_wei_adj", S | W | P, betweenness_wei_adj },
+		{ "betweenness_wei_into", S | W | P, betweenness_wei_into },
+		{ "breadth", S, breadth },
+		{ "breadth_adj", S, breadth_adj },
+		{ "breadth_batch", S, breadth_batch },
+		{ "breadth_batch_adj", S, breadth_batch_adj },
+		{ "breadthdist", S, breadthdist },
+		{ "capped_charpath_lambda", S, capped_charpath_lambda },
+		{ "charpath_ecc", S, charpath_ecc },
+		{ "charpath_ecc_m", S, charpath_ecc_m },
+		{ "charpath_lambda", S, charpath_lambda },
+		{ "charpath_lambda_m", S, charpath_lambda_m },
+		{ "clustering_coef_bd", S | B | D, clustering_coef_bd },
+		{ "clustering_coef_bu", S | B | U, clustering_coef_bu },
+		{ "clustering_coef_wd", S | W | D, clustering_coef_wd },
+		{ "clustering_coef_wu", S | W | U, clustering_coef_wu },
+		{ "clustering_coef_wu_adj", S | W | U, clustering_coef_wu_adj },
+		{ "clustering_coef_wu_into", S | W | U, clustering_coef_wu_into },
+		{ "clustering_coef_wu_into_adj", S | W | U, clustering_coef_wu_into_adj },
+		{ "clustering_coef_wu_packed", S | W | U, clustering_coef_wu_packed },
+		{ "connectivity_length", S, connectivity_length },
+		{ "connectome_open", S, connectome_open },
+		{ "connectome_open_sparse", S, connectome_open_sparse },
+		{ "context_measures", S, context_measures },
+		{ "cycprob", S, cycprob },
+		{ "degrees_dir", S | D, degrees_dir },
+		{ "degrees_und", S | U, degrees_und },
+		{ "degrees_und_into", S | U, degrees_und_into },
+		{ "degrees_und_packed", S | U, degrees_und_packed },
+		{ "density_dir", S | D, density_dir },
+		{ "density_und", S | U, density_und },
+		{ "density_und_packed", S | U, density_und_packed },
+		{ "distance_bin", S | B, distance_bin },
+		{ "distance_wei", S | W | P, distance_wei },
+		{ "distance_wei_into", S | W | P, distance_wei_into },
+		{ "distance_wei_into_adj", S | W | P, distance_wei_into_adj },
+		{ "edge_betweenness_bin", S | B, edge_betweenness_bin },
+		{ "edge_betweenness_wei", S | W | P, edge_betweenness_wei },
+		{ "efficiency_global", S, efficiency_global },
+		{ "efficiency_local", S, efficiency_local },
+		{ "eigenvector_centrality", S | U, eigenvector_centrality },
+		{ "erange", S | B, erange },
+		{ "findpaths", S, findpaths },
+		{ "findpaths_plq", S, findpaths_plq },
+		{ "findwalks", S, findwalks },
+		{ "findwalks_wlq", S, findwalks_wlq },
+		{ "jdegree", S, jdegree },
+		{ "latmio_dir", S | D, latmio_dir },
+		{ "latmio_dir_connected", S | D, latmio_dir_connected },
+		{ "latmio_und", S | U, latmio_und },
+		{ "latmio_und_connected", S | U, latmio_und_connected },
+		{ "matching_ind", S, matching_ind },
+		{ "modularity_dir", S | D, modularity_dir },
+		{ "modularity_louvain_und", S | U, modularity_louvain_und },
+		{ "modularity_und", S | U, modularity_und },
+		{ "module_degree_zscore", S | B, module_degree_zscore },
+		{ "module_strength", S, module_strength },
+		{ "module_strength_adj", S, module_strength_adj },
+		{ "motif3funct_bin", S | B, motif3funct_bin },
+		{ "motif3funct_wei", S | W, motif3funct_wei },
+		{ "motif3struct_bin", S | B, motif3struct_bin },
+		{ "motif3struct_wei", S | W, motif3struct_wei },
+		{ "motif4funct_bin", S | B, motif4funct_bin },
+		{ "motif4funct_wei", S | W, motif4funct_wei },
+		{ "motif4struct_bin", S | B, motif4struct_bin },
+		{ "motif4struct_wei", S | W, motif4struct_wei },
+		{ "normalized_path_length", S, normalized_path_length },
+		{ "normalized_path_length_m", S, normalized_path_length_m },
+		{ "participation_coef", S | B, participation_coef },
+		{ "randmio_dir", S | D, randmio_dir },
+		{ "randmio_dir_connected", S | D, randmio_dir_connected },
+		{ "randmio_und", S | U, randmio_und },
+		{ "randmio_und_connected", S | U, randmio_und_connected },
+		{ "randmio_und_packed", S | U, randmio_und_packed },
+		{ "reachability", S, reachability },
+		{ "reachability_adj", S, reachability_adj },
+		{ "reachdist", S, reachdist },
+		{ "read_connectome", S, read_connectome },
+		{ "strengths_dir", S | D, strengths_dir },
+		{ "strengths_und", S | U, strengths_und },
+		{ "strengths_und_into", S | U, strengths_und_into },
+		{ "strengths_und_packed", S | U, strengths_und_packed },
+		{ "threshold_absolute", S, threshold_absolute },
+		{ "threshold_proportional_dir", S, threshold_proportional_dir },
+		{ "threshold_proportional_und", S | U, threshold_proportional_und },
+		{ "threshold_proportional_und_packed", S | U, threshold_proportional_und_packed },
+		{ "threshold_sweep", S, threshold_sweep }
+	};
+	const int benchmark_count = sizeof(benchmark_table) / sizeof(benchmark);
+	
+	MATRIX_T* makefractalCIJ(int N, FP_T density);
+	MATRIX_T* makelatticeCIJ(int N, FP_T density);
+	MATRIX_T* makerandCIJ_bd(int N, FP_T density);
+	MATRIX_T* makerandCIJ_bu(int N, FP_T density);
+	MATRIX_T* makerandCIJ_wd(int N, FP_T density);
+	MATRIX_T* makerandCIJ_wu(int N, FP_T density);
+	MATRIX_T* makeringlatticeCIJ(int N, FP_T density);
+	
+	const family family_table[] = {
+		{ "makefractalCIJ", false, makefractalCIJ },
+		{ "makelatticeCIJ", true, makelatticeCIJ },
+		{ "makerandCIJ_bd", true, makerandCIJ_bd },
+		{ "makerandCIJ_bu", true, makerandCIJ_bu },
+		{ "makerandCIJ_wd", true, makerandCIJ_wd },
+		{ "makerandCIJ_wu", true, makerandCIJ_wu },
+		{ "makeringlatticeCIJ", true, makeringlatticeCIJ }
+	};
+	const int family_count = sizeof(family_table) / sizeof(family);
+	
+	int edges_dir(int N, FP_T density);
+	bool selected(const std::vector<std::string>& names, const std::string& name);
+	std::vector<std::string> split(const std::string& list);
+	bool parse_options(int argc, char* argv[], options* opts);
+	void usage();
+	double now_ns();
+	void reset_peak_rss();
+	long peak_rss_kb();
+	const char* precision();
+}
+
+int main(int argc, char* argv[]) {
+	using namespace bct_bench;
+	options opts;
+	if (!parse_options(argc, argv, &opts)) {
+		usage();
+		return 1;
+	}
+	FILE* f = stdout;
+	if (!opts.filename.empty()) {
+		f = std::fopen(opts.filename.c_str(), "w");
+		if (f == NULL) {
+			std::fprintf(stderr, "bench: Could not open %s\n", opts.filename.c_str());
+			return 1;
+		}
+	}
+	
+	// Input checks would otherwise be timed along with each measure
+	BCT_NAMESPACE::set_safe_mode(false);
+	
+	// Each graph is also written to connectome files, which are read back by
+	// the connectome measures
+	char connectome_file[] = "/tmp/bct_bench_XXXXXX";
+	int fd = mkstemp(connectome_file);
+	if (fd == -1) {
+		std::fprintf(stderr, "bench: Could not create a temporary file\n");
+		return 1;
+	}
+	close(fd);
+	
+	std::fprintf(f, "{\n");
+	std::fprintf(f, "\t\"precision\": \"%s\",\n", precision());
+	std::fprintf(f, "\t\"seed\": %lu,\n", opts.seed);
+	std::fprintf(f, "\t\"warmup\": %d,\n", opts.warmup);
+	std::fprintf(f, "\t\"repeats\": %d,\n", opts.repeats);
+	std::fprintf(f, "\t\"max_op_s\": %g,\n", opts.max_op_s);
+	std::fprintf(f, "\t\"results\": [");
+	bool first = true;
+	for (int i_family = 0; i_family < family_count; i_family++) {
+		const family& fam = family_table[i_family];
+		if (!selected(opts.families, fam.name)) {
+			continue;
+		}
+		int n_densities = fam.sweeps_density ? (int)opts.densities.size() : 1;
+		
+		// Measures that exceed the time limit on a graph are skipped for
+		// larger graphs of the same family and density
+		std::vector<std::vector<bool> > too_slow(benchmark_count, std::vector<bool>(n_densities, false));
+		for (int i_size = 0; i_size < (int)opts.sizes.size(); i_size++) {
+			for (int i_density = 0; i_density < n_densities; i_density++) {
+				
+				// Each graph gets its own seed, so it does not depend on
+				// which other graphs or measures are selected
+				unsigned long seed = opts.seed + (i_family * opts.sizes.size() + i_size) * opts.densities.size() + i_density;
+				MATLAB_NAMESPACE::seed_rng(MATLAB_NAMESPACE::get_rng(), seed);
+				MATRIX_T* W = fam.generate(opts.sizes[i_size], opts.densities[i_density]);
+				int N = W->size1;
+				int status = BCT_NAMESPACE::matrix_status(W);
+				bool undirected = (status & U) != 0;
+				int edges = undirected ? BCT_NAMESPACE::number_of_edges_und(W) : BCT_NAMESPACE::number_of_edges_dir(W);
+				FP_T density = undirected ? BCT_NAMESPACE::density_und(W) : BCT_NAMESPACE::density_dir(W);
+				
+				input in;
+				in.W = W;
+				in.undirected = undirected;
+				in.density = density;
+				in.D = (status & B) ? BCT_NAMESPACE::distance_bin(W) : BCT_NAMESPACE::distance_wei(W);
+				in.Ci = NULL;
+				if (undirected) {
+					BCT_NAMESPACE::modularity_und(W, &in.Ci);
+				} else {
+					BCT_NAMESPACE::modularity_dir(W, &in.Ci);
+				}
+				in.sources = MATLAB_NAMESPACE::sequence(0, N - 1);
+				in.adj = BCT_NAMESPACE::to_adjacency_list(W);
+				in.packed = undirected ? BCT_NAMESPACE::to_packed_matrix(W) : NULL;
+				in.graphs.assign(1, W);
+				in.measures = BCT_NAMESPACE::batch_measures();
+				in.vector_out = VECTOR_ID(alloc)(N);
+				in.matrix_out = MATRIX_ID(alloc)(N, N);
+				in.adj_scratch = BCT_NAMESPACE::adjacency_list_alloc(N, 0);
+				in.ws = BCT_NAMESPACE::distance_wei_workspace_alloc(N);
+				in.breadth_ws = BCT_NAMESPACE::breadth_workspace_alloc(N);
+				in.source_nodes = new int[N];
+				for (int i = 0; i < N; i++) {
+					in.source_nodes[i] = i;
+				}
+				in.dense_file = connectome_file;
+				in.sparse_file = in.dense_file + ".sparse";
+				BCT_NAMESPACE::write_connectome(W, in.dense_file);
+				BCT_NAMESPACE::write_connectome(W, in.sparse_file, true);
+				
+				for (int i_benchmark = 0; i_benchmark < benchmark_count; i_benchmark++) {
+					const benchmark& bench = benchmark_table[i_benchmark];
+					if ((status & bench.requires) != bench.requires || !selected(opts.measures, bench.name)) {
+						continue;
+					}
+					if (too_slow[i_benchmark][i_density]) {
+						std::fprintf(stderr, "%s N=%d density=%g %s skipped (over time limit)\n", fam.name, N, (double)density, bench.name);
+						continue;
+					}
+					std::fprintf(stderr, "%s N=%d density=%g %s\n", fam.name, N, (double)density, bench.name);
+					std::vector<double> samples;
+					long rss = 0;
+					try {
+						reset_peak_rss();
+						
+						// The last warmup run decides how many runs make up
+						// each sample
+						double elapsed = 0.0;
+						for (int i = 0; i < opts.warmup; i++) {
+							double start = now_ns();
+							bench.run(&in);
+							elapsed = now_ns() - start;
+						}
+						too_slow[i_benchmark][i_density] = elapsed > opts.max_op_s * 1.0e9;
+						int runs = (elapsed >= min_sample_ns) ? 1 : (int)std::ceil(min_sample_ns / std::max(elapsed, 1.0));
+						for (int i = 0; i < opts.repeats; i++) {
+							double start = now_ns();
+							for (int j = 0; j < runs; j++) {
+								bench.run(&in);
+							}
+							samples.push_back((now_ns() - start) / runs);
+						}
+						rss = peak_rss_kb();
+					} catch (BCT_NAMESPACE::bct_exception& e) {
+						std::fprintf(stderr, "bench: %s failed: %s\n", bench.name, e.what());
+						continue;
+					}
+					std::sort(samples.begin(), samples.end());
+					int size = samples.size();
+					double median = (size % 2 == 1) ? samples[size / 2] : 0.5 * (samples[size / 2 - 1] + samples[size / 2]);
+					
+					std::fprintf(f, first ? "\n" : ",\n");
+					first = false;
+					std::fprintf(f, "\t\t{ \"measure\": \"%s\", \"family\": \"%s\", ", bench.name, fam.name);
+					std::fprintf(f, "\"nodes\": %d, \"edges\": %d, \"density\": %.6g, ", N, edges, (double)density);
+					std::fprintf(f, "\"ns_per_op\": %.1f, \"ns_per_op_min\": %.1f, \"ns_per_op_max\": %.1f, ", median, samples[0], samples[size - 1]);
+					std::fprintf(f, "\"edges_per_s\": %.6g, \"peak_rss_kb\": %ld }", edges / (median * 1.0e-9), rss);
+					std::fflush(f);
+				}
+				
+				MATRIX_ID(free)(W);
+				MATRIX_ID(free)(in.D);
+				VECTOR_ID(free)(in.Ci);
+				VECTOR_ID(free)(in.sources);
+				BCT_NAMESPACE::adjacency_list_free(in.adj);
+				if (in.packed != NULL) {
+					BCT_NAMESPACE::packed_matrix_free(in.packed);
+				}
+				VECTOR_ID(free)(in.vector_out);
+				MATRIX_ID(free)(in.matrix_out);
+				BCT_NAMESPACE::adjacency_list_free(in.adj_scratch);
+				BCT_NAMESPACE::distance_wei_workspace_free(in.ws);
+				BCT_NAMESPACE::breadth_workspace_free(in.breadth_ws);
+				delete[] in.source_nodes;
+				std::remove(in.sparse_file.c_str());
+			}
+		}
+	}
+	std::remove(connectome_file);
+	std::fprintf(f, "\n\t]\n}\n");
+	if (f != stdout) {
+		std::fclose(f);
+	}
+	return 0;
+}
+
+void bct_bench::basic_stats_dir(const input* in) {
+	BCT_NAMESPACE::basic_stats_free(BCT_NAMESPACE::basic_stats_dir(in->W));
+}
+
+/*
+ * Runs every batch measure on the graph through batch_run, which shares the
+ * quantities that several measures need.
+ */
+void bct_bench::batch_run(const input* in) {
+	BCT_NAMESPACE::batch_result_free(BCT_NAMESPACE::batch_run(in->graphs, in->measures));
+}
+
+void bct_bench::betweenness_wei_adj(const input* in) {
+	VECTOR_ID(free)(BCT_NAMESPACE::betweenness_wei(in->adj));
+}
+
+void bct_bench::betweenness_wei_into(const input* in) {
+	BCT_NAMESPACE::betweenness_wei_into(in->adj, in->vector_out);
+}
+
+void bct_bench::breadth(const input* in) {
+	VECTOR_ID(free)(BCT_NAMESPACE::breadth(in->W, 0));
+}
+
+void bct_bench::breadth_adj(const input* in) {
+	BCT_NAMESPACE::breadth(in->adj, 0, in->breadth_ws, in->vector_out->data);
+}
+
+void bct_bench::breadth_batch(const input* in) {
+	MATRIX_ID(free)(BCT_NAMESPACE::breadth_batch(in->W, in->sources));
+}
+
+void bct_bench::breadth_batch_adj(const input* in) {
+	BCT_NAMESPACE::breadth_batch(in->adj, in->source_nodes, in->adj->size, in->breadth_ws, in->matrix_out->data);
+}
+
+/*
+ * Rewiring measures are not run on graphs too dense to rewire.
+ */
+void bct_bench::check_rewirable(const input* in) {
+	if (in->density > max_rewiring_density) {
+		throw BCT_NAMESPACE::bct_exception("graph is too dense to rewire");
+	}
+}
+
+void bct_bench::clustering_coef_wu_adj(const input* in) {
+	VECTOR_ID(free)(BCT_NAMESPACE::clustering_coef_wu(in->adj));
+}
+
+void bct_bench::clustering_coef_wu_into(const input* in) {
+	BCT_NAMESPACE::clustering_coef_wu_into(in->W, in->vector_out, in->adj_scratch);
+}
+
+void bct_bench::clustering_coef_wu_into_adj(const input* in) {
+	BCT_NAMESPACE::clustering_coef_wu_into(in->adj, in->vector_out);
+}
+
+void bct_bench::clustering_coef_wu_packed(const input* in) {
+	VECTOR_ID(free)(BCT_NAMESPACE::clustering_coef_wu(in->packed));
+}
+
+void bct_bench::connectome_open(const input* in) {
+	BCT_NAMESPACE::connectome_close(BCT_NAMESPACE::connectome_open(in->dense_file));
+}
+
+void bct_bench::connectome_open_sparse(const input* in) {
+	BCT_NAMESPACE::connectome_close(BCT_NAMESPACE::connectome_open(in->sparse_file));
+}
+
+/*
+ * Runs every batch measure on the graph through a single context, including
+ * the cost of building and freeing it.
+ */
+void bct_bench::context_measures(const input* in) {
+	BCT_NAMESPACE::graph_context* context = BCT_NAMESPACE::graph_context_alloc(in->W);
+	for (int i = 0; i < (int)in->measures.size(); i++) {
+		VECTOR_ID(free)(BCT_NAMESPACE::context_measure(context, in->measures[i]));
+	}
+	BCT_NAMESPACE::graph_context_free(context);
+}
+
+void bct_bench::cycprob(const input* in) {
+	VECTOR_ID(free)(BCT_NAMESPACE::cycprob(in->W, in->sources, qmax));
+}
+
+void bct_bench::degrees_und_into(const input* in) {
+	BCT_NAMESPACE::degrees_und_into(in->W, in->vector_out);
+}
+
+void bct_bench::degrees_und_packed(const input* in) {
+	VECTOR_ID(free)(BCT_NAMESPACE::degrees_und(in->packed));
+}
+
+void bct_bench::density_und_packed(const input* in) {
+	BCT_NAMESPACE::density_und(in->packed);
+}
+
+void bct_bench::distance_wei_into(const input* in) {
+	BCT_NAMESPACE::distance_wei_into(in->W, in->matrix_out, in->ws);
+}
+
+void bct_bench::distance_wei_into_adj(const input* in) {
+	BCT_NAMESPACE::distance_wei_into(in->adj, in->matrix_out, in->ws);
+}
+
+void bct_bench::findpaths(const input* in) {
+	std::vector<MATRIX_T*> Pq = BCT_NAMESPACE::findpaths(in->W, in->sources, qmax);
+	BCT_NAMESPACE::gsl_free(Pq);
+}
+
+void bct_bench::findpaths_plq(const input* in) {
+	VECTOR_ID(free)(BCT_NAMESPACE::findpaths_plq(in->W, in->sources, qmax));
+}
+
+/*
+ * findwalks computes walks of every length up to the number of nodes.
+ */
+void bct_bench::findwalks(const input* in) {
+	std::vector<MATRIX_T*> Wq = BCT_NAMESPACE::findwalks(in->W);
+	BCT_NAMESPACE::gsl_free(Wq);
+}
+
+void bct_bench::findwalks_wlq(const input* in) {
+	VECTOR_ID(free)(BCT_NAMESPACE::findwalks_wlq(in->W, qmax));
+}
+
+void bct_bench::module_degree_zscore(const input* in) {
+	VECTOR_ID(free)(BCT_NAMESPACE::module_degree_zscore(in->W, in->Ci));
+}
+
+void bct_bench::module_strength(const input* in) {
+	MATRIX_ID(free)(BCT_NAMESPACE::module_strength(in->W, in->Ci));
+}
+
+void bct_bench::module_strength_adj(const input* in) {
+	MATRIX_ID(free)(BCT_NAMESPACE::module_strength(in->adj, in->Ci));
+}
+
+void bct_bench::participation_coef(const input* in) {
+	VECTOR_ID(free)(BCT_NAMESPACE::participation_coef(in->W, in->Ci));
+}
+
+void bct_bench::randmio_und_packed(const input* in) {
+	check_rewirable(in);
+	BCT_NAMESPACE::packed_matrix_free(BCT_NAMESPACE::randmio_und(in->packed, rewiring_iterations));
+}
+
+void bct_bench::reachability(const input* in) {
+	BCT_NAMESPACE::bit_matrix_free(BCT_NAMESPACE::reachability(in->W));
+}
+
+void bct_bench::reachability_adj(const input* in) {
+	BCT_NAMESPACE::bit_matrix_free(BCT_NAMESPACE::reachability(in->adj));
+}
+
+void bct_bench::read_connectome(const input* in) {
+	MATRIX_ID(free)(BCT_NAMESPACE::read_connectome(in->dense_file));
+}
+
+void bct_bench::strengths_und_into(const input* in) {
+	BCT_NAMESPACE::strengths_und_into(in->W, in->vector_out);
+}
+
+void bct_bench::strengths_und_packed(const input* in) {
+	VECTOR_ID(free)(BCT_NAMESPACE::strengths_und(in->packed));
+}
+
+/*
+ * Keeps connections with weights of at least half the largest weight.
+ */
+void bct_bench::threshold_absolute(const input* in) {
+	MATRIX_ID(free)(BCT_NAMESPACE::threshold_absolute(in->W, 0.5 * MATRIX_ID(max)(in->W)));
+}
+
+void bct_bench::threshold_proportional_dir(const input* in) {
+	MATRIX_ID(free)(BCT_NAMESPACE::threshold_proportional_dir(in->W, threshold_p));
+}
+
+void bct_bench::threshold_proportional_und(const input* in) {
+	MATRIX_ID(free)(BCT_NAMESPACE::threshold_proportional_und(in->W, threshold_p));
+}
+
+void bct_bench::threshold_proportional_und_packed(const input* in) {
+	BCT_NAMESPACE::packed_matrix_free(BCT_NAMESPACE::threshold_proportional_und(in->packed, threshold_p));
+}
+
+/*
+ * Sorts the edges once and visits proportions from 1 / sweep_steps to 1.
+ */
+void bct_bench::threshold_sweep(const input* in) {
+	BCT_NAMESPACE::threshold_sweep* sweep = BCT_NAMESPACE::threshold_sweep_alloc(in->W, in->undirected);
+	for (int i = 1; i <= sweep_steps; i++) {
+		BCT_NAMESPACE::threshold_sweep_proportional(sweep, (FP_T)i / sweep_steps);
+	}
+	BCT_NAMESPACE::threshold_sweep_free(sweep);
+}
+
+/*
+ * Generates a fractal graph with the power of 2 nearest to N nodes, clusters
+ * of 4 nodes, and a density that halves at each level of the hierarchy.
+ */
+MATRIX_T* bct_bench::makefractalCIJ(int N, FP_T) {
+	int mx_lvl = std::max(2, (int)std::floor(std::log((double)N) / std::log(2.0) + 0.5));
+	return BCT_NAMESPACE::makefractalCIJ(mx_lvl, 2.0, 2);
+}
+
+MATRIX_T* bct_bench::makelatticeCIJ(int N, FP_T density) {
+	return BCT_NAMESPACE::makelatticeCIJ(N, edges_dir(N, density));
+}
+
+MATRIX_T* bct_bench::makerandCIJ_bd(int N, FP_T density) {
+	return BCT_NAMESPACE::makerandCIJ_bd(N, edges_dir(N, density));
+}
+
+MATRIX_T* bct_bench::makerandCIJ_bu(int N, FP_T density) {
+	return BCT_NAMESPACE::makerandCIJ_bu(N, std::max(1, edges_dir(N, density) / 2));
+}
+
+MATRIX_T* bct_bench::makerandCIJ_wd(int N, FP_T density) {
+	return BCT_NAMESPACE::makerandCIJ_wd(N, edges_dir(N, density), 0.1, 1.0);
+}
+
+MATRIX_T* bct_bench::makerandCIJ_wu(int N, FP_T density) {
+	return BCT_NAMESPACE::makerandCIJ_wu(N, std::max(1, edges_dir(N, density) / 2), 0.1, 1.0);
+}
+
+MATRIX_T* bct_bench::makeringlatticeCIJ(int N, FP_T density) {
+	return BCT_NAMESPACE::makeringlatticeCIJ(N, edges_dir(N, density));
+}
+
+/*
+ * Returns the number of directed edges in a graph with N nodes, no loops, and
+ * the given density.
+ */
+int bct_bench::edges_dir(int N, FP_T density) {
+	return std::max(1, (int)(density * N * (N - 1) + 0.5));
+}
+
+/*
+ * Returns whether a name is in a list given on the command line.  An empty
+ * list selects every name.
+ */
+bool bct_bench::selected(const std::vector<std::string>& names, const std::string& name) {
+	return names.empty() || std::find(names.begin(), names.end(), name) != names.end();
+}
+
+/*
+ * Splits a comma-separated list.
+ */
+std::vector<std::string> bct_bench::split(const std::string& list) {
+	std::vector<std::string> items;
+	std::string::size_type start = 0;
+	while (start <= list.size()) {
+		std::string::size_type end = list.find(',', start);
+		if (end == std::string::npos) {
+			end = list.size();
+		}
+		if (end > start) {
+			items.push_back(list.substr(start, end - start));
+		}
+		start = end + 1;
+	}
+	return items;
+}
+
+bool bct_bench::parse_options(int argc, char* argv[], options* opts) {
+	opts->sizes.push_back(32);
+	opts->sizes.push_back(64);
+	opts->sizes.push_back(128);
+	opts->densities.push_back(0.05);
+	opts->densities.push_back(0.1);
+	opts->densities.push_back(0.2);
+	opts->warmup = 1;
+	opts->repeats = 5;
+	opts->max_op_s = 1.0;
+	opts->seed = 1;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg.size() != 2 || arg[0] != '-' || i + 1 == argc) {
+			return false;
+		}
+		std::string value = argv[++i];
+		std::vector<std::string> items = split(value);
+		switch (arg[1]) {
+			case 'n':
+				opts->sizes.clear();
+				for (int j = 0; j < (int)items.size(); j++) {
+					opts->sizes.push_back(std::atoi(items[j].c_str()));
+					if (opts->sizes.back() < 4) {
+						return false;
+					}
+				}
+				break;
+			case 'd':
+				opts->densities.clear();
+				for (int j = 0; j < (int)items.size(); j++) {
+					opts->densities.push_back(std::atof(items[j].c_str()));
+					if (opts->densities.back() <= 0.0 || opts->densities.back() > 1.0) {
+						return false;
+					}
+				}
+				break;
+			case 'm': opts->measures = items; break;
+			case 'f': opts->families = items; break;
+			case 'w': opts->warmup = std::atoi(value.c_str()); break;
+			case 'r': opts->repeats = std::atoi(value.c_str()); break;
+			case 't': opts->max_op_s = std::atof(value.c_str()); break;
+			case 's': opts->seed = std::strtoul(value.c_str(), NULL, 10); break;
+			case 'o': opts->filename = value; break;
+			default: return false;
+		}
+	}
+	std::sort(opts->sizes.begin(), opts->sizes.end());
+	return !opts->sizes.empty() && !opts->densities.empty() && opts->warmup >= 1 && opts->repeats >= 1;
+}
+
+void bct_bench::usage() {
+	std::fprintf(stderr, "Usage: bench [-n sizes] [-d densities] [-m measures] [-f families]\n");
+	std::fprintf(stderr, "             [-w warmup] [-r repeats] [-t seconds] [-s seed] [-o file]\n");
+	std::fprintf(stderr, "Lists are comma-separated.  Defaults are -n 32,64,128 -d 0.05,0.1,0.2\n");
+	std::fprintf(stderr, "-w 1 -r 5 -t 1 -s 1, with every measure and family, written to stdout.\n");
+	std::fprintf(stderr, "At least one warmup run is needed to size the timed samples.  A measure\n");
+	std::fprintf(stderr, "whose warmup run takes longer than -t seconds is not run on larger graphs\n");
+	std::fprintf(stderr, "of the same family and density.\n");
+}
+
+double bct_bench::now_ns() {
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1.0e9 + t.tv_nsec;
+}
+
+/*
+ * Resets the peak resident set size, so that it is reported separately for
+ * each measure.  Only Linux supports this; elsewhere the peak is that of the
+ * whole run so far.
+ */
+void bct_bench::reset_peak_rss() {
+#ifdef __linux__
+	FILE* f = std::fopen("/proc/self/clear_refs", "w");
+	if (f != NULL) {
+		std::fputs("5", f);
+		std::fclose(f);
+	}
+#endif
+}
+
+/*
+ * Returns the peak resident set size in kilobytes.
+ */
+long bct_bench::peak_rss_kb() {
+#ifdef __linux__
+	FILE* f = std::fopen("/proc/self/status", "r");
+	if (f != NULL) {
+		char line[256];
+		long kb = -1;
+		while (std::fgets(line, sizeof(line), f) != NULL) {
+			if (std::sscanf(line, "VmHWM: %ld kB", &kb) == 1) {
+				break;
+			}
+		}
+		std::fclose(f);
+		if (kb >= 0) {
+			return kb;
+		}
+	}
+#endif
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+	return usage.ru_maxrss / 1024;
+#else
+	return usage.ru_maxrss;
+#endif
+}
+
+const char* bct_bench::precision() {
+#if defined GSL_FLOAT
+	return "float";
+#elif defined GSL_LONG_DOUBLE
+	return "long double";
+#else
+	return "double";
+#endif
+}
@@ -1,7 +1,12 @@
 #include <gsl/gsl_math.h>
+#include <vector>
 
 #include "bct.h"
 
+namespace BCT_NAMESPACE {
+	bool betweenness_wei_equal(ACC_T x, ACC_T y);
+}
+
 /*
  * Computes node betweenness for a weighted graph.
  */
@@ -12,6 +17,34 @@ VECTOR_T* BCT_NAMESPACE::betweenness_wei(const MATRIX_T* G) {
 	return BC;
 }
 
+/*
+ * Computes node betweenness for a weighted graph given as an adjacency list of
+ * lengths.  This is Brandes' algorithm, which needs O(N + E) memory per source
+ * instead of the O(N^2) used by the matrix version, with path counts and
+ * dependencies accumulated in ACC_T.  Results may differ from the matrix
+ * version by rounding.
+ */
+VECTOR_T* BCT_NAMESPACE::betweenness_wei(const adjacency_list* L) {
+	VECTOR_T* BC = VECTOR_ID(alloc)(L->size);
+	betweenness_wei_into(L, BC);
+	return BC;
+}
+
+/*
+ * Computes node betweenness for a weighted graph, given as an adjacency list of
+ * lengths, into an existing vector with one element per node.
+ */
+void BCT_NAMESPACE::betweenness_wei_into(const adjacency_list* L, VECTOR_T* BC) {
+	if ((int)BC->size != L->size) {
+		throw bct_exception("betweenness_wei_into: BC must have one element per node");
+	}
+	std::vector<ACC_T> BC_acc(L->size + 1);
+	bct_kernels::betweenness_wei(to_graph_view(L), betweenness_wei_equal, &BC_acc[0]);
+	for (int i = 0; i < L->size; i++) {
+		VECTOR_ID(set)(BC, i, (FP_T)BC_acc[i]);
+	}
+}
+
 /*
  * Computes node and edge betweenness for a weighted graph.
  */
@@ -198,3 +231,10 @@ MATRIX_T* BCT_NAMESPACE::edge_betweenness_wei(const MATRIX_T* G, VECTOR_T** BC)
 	
 	return EBC;
 }
+
+/*
+ * Compares path lengths as the matrix version does (Duw==D(w)).
+ */
+bool BCT_NAMESPACE::betweenness_wei_equal(ACC_T x, ACC_T y) {
+	return fp_equal((FP_T)x, (FP_T)y);
+}
@@ -0,0 +1,94 @@
+#include <climits>
+
+#include "bct.h"
+
+/*
+ * Allocates a bit matrix with every bit cleared.  Each row is stored in its own
+ * run of words so that whole rows can be combined a word at a time.
+ */
+BCT_NAMESPACE::bit_matrix* BCT_NAMESPACE::bit_matrix_alloc(int size1, int size2) {
+	bit_matrix* m = new bit_matrix;
+	m->size1 = size1;
+	m->size2 = size2;
+	m->words = (size2 + bit_matrix_word_bits - 1) / bit_matrix_word_bits;
+	m->data = new unsigned long[(size1 * m->words > 0) ? size1 * m->words : 1];
+	for (int i = 0; i < size1 * m->words; i++) {
+		m->data[i] = 0;
+	}
+	return m;
+}
+
+/*
+ * Frees a bit matrix.
+ */
+void BCT_NAMESPACE::bit_matrix_free(bit_matrix* m) {
+	if (m == NULL) {
+		return;
+	}
+	delete[] m->data;
+	delete m;
+}
+
+/*
+ * Returns the bit at (i,j).
+ */
+bool BCT_NAMESPACE::bit_matrix_get(const bit_matrix* m, int i, int j) {
+	return (m->data[i * m->words + j / bit_matrix_word_bits] >> (j % bit_matrix_word_bits)) & 1UL;
+}
+
+/*
+ * Sets or clears the bit at (i,j).
+ */
+void BCT_NAMESPACE::bit_matrix_set(bit_matrix* m, int i, int j, bool value) {
+	unsigned long mask = 1UL << (j % bit_matrix_word_bits);
+	if (value) {
+		m->data[i * m->words + j / bit_matrix_word_bits] |= mask;
+	} else {
+		m->data[i * m->words + j / bit_matrix_word_bits] &= ~mask;
+	}
+}
+
+/*
+ * Converts a bit matrix to a binary matrix.
+ */
+MATRIX_T* BCT_NAMESPACE::bit_matrix_to_matrix(const bit_matrix* m) {
+	MATRIX_T* ret = zeros(m->size1, m->size2);
+	for (int i = 0; i < m->size1; i++) {
+		for (int j = 0; j < m->size2; j++) {
+			if (bit_matrix_get(m, i, j)) {
+				MATRIX_ID(set)(ret, i, j, 1.0);
+			}
+		}
+	}
+	return ret;
+}
+
+/*
+ * Returns the number of set bits in a word.
+ */
+int BCT_NAMESPACE::bit_count(unsigned long bits) {
+#ifdef __GNUC__
+	return __builtin_popcountl(bits);
+#else
+	int count = 0;
+	for (; bits != 0; bits &= bits - 1) {
+		count++;
+	}
+	return count;
+#endif
+}
+
+/*
+ * Returns the index of the lowest set bit in a nonzero word.
+ */
+int BCT_NAMESPACE::lowest_bit(unsigned long bits) {
+#ifdef __GNUC__
+	return __builtin_ctzl(bits);
+#else
+	int index = 0;
+	for (; (bits & 1UL) == 0; bits >>= 1) {
+		index++;
+	}
+	return index;
+#endif
+}
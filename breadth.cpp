@@ -2,6 +2,14 @@
 
 #include "bct.h"
 
+namespace BCT_NAMESPACE {
+	
+	// % colors: white, gray, black
+	const int white = 0;
+	const int gray = 1;
+	const int black = 2;
+}
+
 /*
  * Performs a breadth-first search starting at the source node.  Because C++
  * indexing is zero-based, a value of 0 at branch(i) could mean either that node
@@ -14,100 +22,181 @@ VECTOR_T* BCT_NAMESPACE::breadth(const MATRIX_T* CIJ, int source, VECTOR_T** bra
 	// N = size(CIJ,1);
 	int N = CIJ->size1;
 	
-	// % colors: white, gray, black
-	int white = 0;
-	int gray = 1;
-	int black = 2;
+	adjacency_list* adj = to_adjacency_list(CIJ);
+	breadth_workspace* ws = breadth_workspace_alloc(N);
+	VECTOR_T* distance = VECTOR_ID(alloc)(N);
+	int* _branch = (branch != NULL) ? new int[N] : NULL;
+	breadth(adj, source, ws, distance->data, _branch);
+	if (branch != NULL) {
+		*branch = VECTOR_ID(alloc)(N);
+		for (int i = 0; i < N; i++) {
+			VECTOR_ID(set)(*branch, i, (FP_T)_branch[i]);
+		}
+		delete[] _branch;
+	}
+	breadth_workspace_free(ws);
+	adjacency_list_free(adj);
+	return distance;
+}
+
+/*
+ * Performs a breadth-first search over an adjacency list without allocating
+ * memory.  The queue and colors are kept in the given workspace, which may be
+ * reused for any number of searches on graphs of the same size; a workspace of
+ * any other size is rejected.  distance (and branch, if not NULL) must have
+ * room for adj->size elements and are filled in as by the matrix version of
+ * breadth.
+ */
+void BCT_NAMESPACE::breadth(const adjacency_list* adj, int source, breadth_workspace* ws, FP_T* distance, int* branch) {
+	if (ws->size != adj->size) {
+		throw bct_exception("breadth: ws must have one element per node");
+	}
+	int N = adj->size;
 	
 	// color = zeros(1,N);
-	VECTOR_T* color = zeros_vector(N);
-	
 	// distance = inf*ones(1,N);
-	VECTOR_T* distance = VECTOR_ID(alloc)(N);
-	VECTOR_ID(set_all)(distance, GSL_POSINF);
-	
 	// branch = zeros(1,N);
-	if (branch != NULL) {
-		*branch = zeros_vector(N);
+	for (int i = 0; i < N; i++) {
+		ws->color[i] = white;
+		distance[i] = GSL_POSINF;
+		if (branch != NULL) {
+			branch[i] = 0;
+		}
 	}
 	
 	// color(source) = gray;
-	VECTOR_ID(set)(color, source, (FP_T)gray);
+	ws->color[source] = gray;
 	
 	// distance(source) = 0;
-	VECTOR_ID(set)(distance, source, 0.0);
+	distance[source] = 0.0;
 	
 	// branch(source) = -1;
 	if (branch != NULL) {
-		VECTOR_ID(set)(*branch, source, -1.0);
+		branch[source] = -1;
 	}
 	
 	// Q = source;
-	VECTOR_T* Q = VECTOR_ID(alloc)(1);
-	VECTOR_ID(set)(Q, 0, (FP_T)source);
+	ws->head = 0;
+	ws->queue[0] = source;
+	ws->count = 1;
 	
 	// while ~isempty(Q)
-	while (Q != NULL) {
+	while (ws->count > 0) {
 		
 		// u = Q(1);
-		int u = (int)VECTOR_ID(get)(Q, 0);
+		// Q = Q(2:length(Q));
+		int u = ws->queue[ws->head];
+		ws->head = (ws->head + 1 == N) ? 0 : ws->head + 1;
+		ws->count--;
 		
 		// ns = find(CIJ(u,:));
-		VECTOR_ID(const_view) CIJ_row_u = MATRIX_ID(const_row)(CIJ, u);
-		VECTOR_T* ns = find(&CIJ_row_u.vector);
-		
 		// for v=ns
-		if (ns != NULL) {
-			for (int i_ns = 0; i_ns < (int)ns->size; i_ns++) {
-				int v = (int)VECTOR_ID(get)(ns, i_ns);
+		for (int k = adj->offsets[u]; k < adj->offsets[u + 1]; k++) {
+			int v = adj->nodes[k];
+			
+			// if (distance(v)==0)
+			if (distance[v] == 0.0) {
 				
-				// if (distance(v)==0)
-				if ((int)VECTOR_ID(get)(distance, v) == 0) {
-					
-					// distance(v) = distance(u)+1;
-					VECTOR_ID(set)(distance, v, VECTOR_ID(get)(distance, u) + 1.0);
-				}
+				// distance(v) = distance(u)+1;
+				distance[v] = distance[u] + 1.0;
+			}
+			
+			// if (color(v)==white)
+			if (ws->color[v] == white) {
+				
+				// color(v) = gray;
+				ws->color[v] = gray;
 				
-				// if (color(v)==white)
-				if ((int)VECTOR_ID(get)(color, v) == white) {
-					
-					// color(v) = gray;
-					VECTOR_ID(set)(color, v, (FP_T)gray);
-					
-					// distance(v) = distance(u)+1;
-					VECTOR_ID(set)(distance, v, VECTOR_ID(get)(distance, u) + 1.0);
-					
-					// branch(v) = u;
-					if (branch != NULL) {
-						VECTOR_ID(set)(*branch, v, (FP_T)u);
-					}
-					
-					// Q = [Q v];
-					VECTOR_T* temp = concatenate(Q, (FP_T)v);
-					VECTOR_ID(free)(Q);
-					Q = temp;
+				// distance(v) = distance(u)+1;
+				distance[v] = distance[u] + 1.0;
+				
+				// branch(v) = u;
+				if (branch != NULL) {
+					branch[v] = u;
 				}
+				
+				// Q = [Q v];
+				int tail = ws->head + ws->count;
+				ws->queue[(tail >= N) ? tail - N : tail] = v;
+				ws->count++;
 			}
-			
-			VECTOR_ID(free)(ns);
-		}
-		
-		// Q = Q(2:length(Q));
-		VECTOR_T* Q_cols = sequence(1, length(Q) - 1);
-		if (Q_cols != NULL) {
-			VECTOR_T* temp = ordinal_index(Q, Q_cols);
-			VECTOR_ID(free)(Q);
-			VECTOR_ID(free)(Q_cols);
-			Q = temp;
-		} else {
-			VECTOR_ID(free)(Q);
-			Q = NULL;
 		}
 		
 		// color(u) = black;
-		VECTOR_ID(set)(color, u, (FP_T)black);
+		ws->color[u] = black;
 	}
-	
-	VECTOR_ID(free)(color);
+}
+
+/*
+ * Performs a breadth-first search from each of the given sources.  Row i of the
+ * returned matrix (and of branch, if given) holds the result of breadth for
+ * sources(i).  The graph is converted and the search workspace allocated only
+ * once for all sources.
+ */
+MATRIX_T* BCT_NAMESPACE::breadth_batch(const MATRIX_T* CIJ, const VECTOR_T* sources, MATRIX_T** branch) {
+	if (safe_mode) check_status(CIJ, SQUARE, "breadth_batch");
+	int N = CIJ->size1;
+	int count = (int)sources->size;
+	adjacency_list* adj = to_adjacency_list(CIJ);
+	breadth_workspace* ws = breadth_workspace_alloc(N);
+	MATRIX_T* distance = MATRIX_ID(alloc)(count, N);
+	int* _branch = (branch != NULL) ? new int[N] : NULL;
+	if (branch != NULL) {
+		*branch = MATRIX_ID(alloc)(count, N);
+	}
+	for (int i = 0; i < count; i++) {
+		breadth(adj, (int)VECTOR_ID(get)(sources, i), ws, MATRIX_ID(ptr)(distance, i, 0), _branch);
+		if (branch != NULL) {
+			for (int j = 0; j < N; j++) {
+				MATRIX_ID(set)(*branch, i, j, (FP_T)_branch[j]);
+			}
+		}
+	}
+	delete[] _branch;
+	breadth_workspace_free(ws);
+	adjacency_list_free(adj);
 	return distance;
 }
+
+/*
+ * Performs a breadth-first search from each of count sources without
+ * allocating memory.  distance (and branch, if not NULL) must have room for
+ * count rows of adj->size elements, stored contiguously.
+ */
+void BCT_NAMESPACE::breadth_batch(const adjacency_list* adj, const int* sources, int count, breadth_workspace* ws, FP_T* distance, int* branch) {
+	if (ws->size != adj->size) {
+		throw bct_exception("breadth_batch: ws must have one element per node");
+	}
+	int N = adj->size;
+	for (int i = 0; i < count; i++) {
+		std::size_t offset = (std::size_t)i * N;
+		breadth(adj, sources[i], ws, &distance[offset], (branch != NULL) ? &branch[offset] : NULL);
+	}
+}
+
+/*
+ * Allocates a workspace for breadth-first searches on graphs with the given
+ * number of nodes.  Each node is enqueued at most once per search, so the queue
+ * is a ring buffer with one slot per node.
+ */
+BCT_NAMESPACE::breadth_workspace* BCT_NAMESPACE::breadth_workspace_alloc(int size) {
+	breadth_workspace* ws = new breadth_workspace;
+	ws->size = size;
+	ws->color = new int[(size > 0) ? size : 1];
+	ws->queue = new int[(size > 0) ? size : 1];
+	ws->head = 0;
+	ws->count = 0;
+	return ws;
+}
+
+/*
+ * Frees a breadth-first search workspace.
+ */
+void BCT_NAMESPACE::breadth_workspace_free(breadth_workspace* ws) {
+	if (ws == NULL) {
+		return;
+	}
+	delete[] ws->color;
+	delete[] ws->queue;
+	delete ws;
+}
@@ -3,7 +3,9 @@
 #include "bct.h"
 
 /*
- * Computes reachability and distance matrices using breadth-first search.
+ * Computes reachability and distance matrices using breadth-first search.  The
+ * graph is converted to an adjacency list once, and each thread reuses a single
+ * search workspace, writing distances directly into the rows of D.
  */
 MATRIX_T* BCT_NAMESPACE::breadthdist(const MATRIX_T* CIJ, MATRIX_T** D) {
 	if (safe_mode) check_status(CIJ, SQUARE, "breadthdist");
@@ -12,24 +14,40 @@ MATRIX_T* BCT_NAMESPACE::breadthdist(const MATRIX_T* CIJ, MATRIX_T** D) {
 	int N = CIJ->size1;
 	
 	// D = zeros(N);
-	MATRIX_T* _D = zeros(N);
-	
-	// for i=1:N
-	for (int i = 0; i < N; i++) {
+	MATRIX_T* _D = MATRIX_ID(alloc)(N, N);
+	adjacency_list* adj = to_adjacency_list(CIJ);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+	{
+		breadth_workspace* ws = breadth_workspace_alloc(N);
 		
-		// D(i,:) = breadth(CIJ,i);
-		VECTOR_T* distance = breadth(CIJ, i);
-		MATRIX_ID(set_row)(_D, i, distance);
-		VECTOR_ID(free)(distance);
+		// for i=1:N
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 16)
+#endif
+		for (int i = 0; i < N; i++) {
+			
+			// D(i,:) = breadth(CIJ,i);
+			breadth(adj, i, ws, MATRIX_ID(ptr)(_D, i, 0));
+		}
+		breadth_workspace_free(ws);
 	}
+	adjacency_list_free(adj);
 	
 	// D(D==0) = Inf;
-	MATRIX_T* D_eq_0 = compare_elements(_D, fp_equal, 0.0);
-	logical_index_assign(_D, D_eq_0, GSL_POSINF);
-	MATRIX_ID(free)(D_eq_0);
-	
 	// R = double(D~=Inf);
-	MATRIX_T* R = compare_elements(_D, fp_not_equal, GSL_POSINF);
+	MATRIX_T* R = MATRIX_ID(alloc)(N, N);
+	for (int i = 0; i < N; i++) {
+		for (int j = 0; j < N; j++) {
+			FP_T value = MATRIX_ID(get)(_D, i, j);
+			if (value == 0.0) {
+				MATRIX_ID(set)(_D, i, j, GSL_POSINF);
+				value = GSL_POSINF;
+			}
+			MATRIX_ID(set)(R, i, j, (value == GSL_POSINF) ? 0.0 : 1.0);
+		}
+	}
 	
 	if (D != NULL) *D = _D; else MATRIX_ID(free)(_D);
 	return R;
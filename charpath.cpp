@@ -3,9 +3,10 @@
 #include "bct.h"
 
 /*
- * WARNING: BCT_NAMESPACE::charpath_lambda takes a distance matrix, but
- * BCT_NAMESPACE::capped_charpath_lambda takes a connection matrix.  Both should be
- * lengths, not weights (called distances in CalcMetric).
+ * WARNING: BCT_NAMESPACE::charpath_lambda and BCT_NAMESPACE::charpath_ecc take
+ * a distance matrix, but BCT_NAMESPACE::capped_charpath_lambda and the _m
+ * variants take a connection matrix.  All should be lengths, not weights
+ * (called distances in CalcMetric).
  */
 
 /*
@@ -25,9 +26,47 @@ FP_T BCT_NAMESPACE::charpath_lambda(const MATRIX_T* D) {
 }
 
 /*
- * Given a connection matrix, computes capped characteristic path length.
+ * Given a connection matrix, computes characteristic path length.  Distances
+ * are computed one row at a time, so the distance matrix is never stored.
  */
-FP_T BCT_NAMESPACE::capped_charpath_lambda(const MATRIX_T* L) {
+FP_T BCT_NAMESPACE::charpath_lambda_m(const MATRIX_T* L) {
+	if (safe_mode) check_status(L, SQUARE, "charpath_lambda_m");
+	int N = L->size1;
+	adjacency_list* adj = to_adjacency_list(L);
+	FP_T sum_D = 0.0;
+	long finite_D = 0;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+	{
+		VECTOR_T* D_row = VECTOR_ID(alloc)(N);
+		distance_wei_workspace* ws = distance_wei_workspace_alloc(N);
+#ifdef _OPENMP
+#pragma omp for reduction(+:sum_D, finite_D)
+#endif
+		for (int i = 0; i < N; i++) {
+			distance_wei_row(adj, i, D_row, ws);
+			for (int j = 0; j < N; j++) {
+				FP_T d = VECTOR_ID(get)(D_row, j);
+				if (gsl_isinf(d) == 0) {
+					sum_D += d;
+					finite_D++;
+				}
+			}
+		}
+		VECTOR_ID(free)(D_row);
+		distance_wei_workspace_free(ws);
+	}
+	adjacency_list_free(adj);
+	return sum_D / (FP_T)finite_D;
+}
+
+/*
+ * Given a connection matrix, computes capped characteristic path length.  Takes
+ * an optional distance matrix (as returned by distance_wei) that is computed
+ * one row at a time if not given.
+ */
+FP_T BCT_NAMESPACE::capped_charpath_lambda(const MATRIX_T* L, const MATRIX_T* D) {
 	if (safe_mode) check_status(L, SQUARE, "capped_charpath_lambda");
 	int N = L->size1;
 	int nonzeros = 0;
@@ -45,20 +84,45 @@ FP_T BCT_NAMESPACE::capped_charpath_lambda(const MATRIX_T* L) {
 		}
 	}
 	lmean /= nonzeros;
-	MATRIX_T* D = distance_wei(L);
 	FP_T dmax = (FP_T)N * lmean;
 	FP_T dmean = 0.0;
-	for (int i = 0; i < N; i++) {
-		for (int j = 0; j < N; j++) {
-			if (i == j) {
-				continue;
+	if (D != NULL) {
+		for (int i = 0; i < N; i++) {
+			for (int j = 0; j < N; j++) {
+				if (i == j) {
+					continue;
+				}
+				FP_T d = MATRIX_ID(get)(D, i, j);
+				dmean += (d < dmax) ? d : dmax;
+			}
+		}
+		return dmean / (N * (N - 1));
+	}
+	adjacency_list* adj = to_adjacency_list(L);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+	{
+		VECTOR_T* D_row = VECTOR_ID(alloc)(N);
+		distance_wei_workspace* ws = distance_wei_workspace_alloc(N);
+#ifdef _OPENMP
+#pragma omp for reduction(+:dmean)
+#endif
+		for (int i = 0; i < N; i++) {
+			distance_wei_row(adj, i, D_row, ws);
+			for (int j = 0; j < N; j++) {
+				if (i == j) {
+					continue;
+				}
+				FP_T d = VECTOR_ID(get)(D_row, j);
+				dmean += (d < dmax) ? d : dmax;
 			}
-			FP_T d = MATRIX_ID(get)(D, i, j);
-			dmean += (d < dmax) ? d : dmax;
 		}
+		VECTOR_ID(free)(D_row);
+		distance_wei_workspace_free(ws);
 	}
+	adjacency_list_free(adj);
 	dmean /= N * (N - 1);
-	MATRIX_ID(free)(D);
 	return dmean;
 }
 
@@ -88,3 +152,46 @@ VECTOR_T* BCT_NAMESPACE::charpath_ecc(const MATRIX_T* D, FP_T* radius, FP_T* dia
 	
 	return ecc;
 }
+
+/*
+ * Given a connection matrix, computes eccentricity, radius, and diameter.
+ * Each row of distances is reduced to its eccentricity as soon as it is
+ * computed, so the distance matrix is never stored.
+ */
+VECTOR_T* BCT_NAMESPACE::charpath_ecc_m(const MATRIX_T* L, FP_T* radius, FP_T* diameter) {
+	if (safe_mode) check_status(L, SQUARE, "charpath_ecc_m");
+	int N = L->size1;
+	adjacency_list* adj = to_adjacency_list(L);
+	VECTOR_T* ecc = zeros_vector(N);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+	{
+		VECTOR_T* D_row = VECTOR_ID(alloc)(N);
+		distance_wei_workspace* ws = distance_wei_workspace_alloc(N);
+#ifdef _OPENMP
+#pragma omp for
+#endif
+		for (int i = 0; i < N; i++) {
+			distance_wei_row(adj, i, D_row, ws);
+			FP_T ecc_i = 0.0;
+			for (int j = 0; j < N; j++) {
+				FP_T d = VECTOR_ID(get)(D_row, j);
+				if (gsl_isinf(d) == 0 && d > ecc_i) {
+					ecc_i = d;
+				}
+			}
+			VECTOR_ID(set)(ecc, i, ecc_i);
+		}
+		VECTOR_ID(free)(D_row);
+		distance_wei_workspace_free(ws);
+	}
+	adjacency_list_free(adj);
+	if (radius != NULL) {
+		*radius = min(ecc);
+	}
+	if (diameter != NULL) {
+		*diameter = max(ecc);
+	}
+	return ecc;
+}
@@ -43,3 +43,22 @@ VECTOR_T* BCT_NAMESPACE::clustering_coef_bu(const MATRIX_T* G) {
 	
 	return C;
 }
+
+/*
+ * Computes the clustering coefficient for a binary undirected graph using the
+ * adjacency list and triangle counts cached by a context.
+ */
+VECTOR_T* BCT_NAMESPACE::clustering_coef_bu(graph_context* context) {
+	if (safe_mode) check_status(context->W, SQUARE | BINARY | UNDIRECTED, "clustering_coef_bu");
+	const adjacency_list* adj = context_adjacency_list(context);
+	const VECTOR_T* triangles = context_triangles(context);
+	int n = adj->size;
+	VECTOR_T* C = zeros_vector(n);
+	for (int u = 0; u < n; u++) {
+		int k = adj->offsets[u + 1] - adj->offsets[u];
+		if (k >= 2) {
+			VECTOR_ID(set)(C, u, 2.0 * VECTOR_ID(get)(triangles, u) / (FP_T)(k * (k - 1)));
+		}
+	}
+	return C;
+}
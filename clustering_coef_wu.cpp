@@ -1,38 +1,84 @@
-#include <gsl/gsl_math.h>
+#include <vector>
 
 #include "bct.h"
 
+namespace BCT_NAMESPACE {
+	bool clustering_coef_wu_zero(ACC_T x);
+}
+
 /*
  * Computes the clustering coefficient for a weighted undirected graph.
  */
 VECTOR_T* BCT_NAMESPACE::clustering_coef_wu(const MATRIX_T* W) {
 	if (safe_mode) check_status(W, SQUARE | WEIGHTED | UNDIRECTED, "clustering_coef_wu");
-	
-	// K=sum(W~=0,2);
-	MATRIX_T* W_neq_0 = compare_elements(W, fp_not_equal, 0.0);
-	VECTOR_T* K = sum(W_neq_0, 2);
-	MATRIX_ID(free)(W_neq_0);
-	
-	// cyc3=diag((W.^(1/3))^3);
-	MATRIX_T* W_pow_1_3 = pow_elements(W, 1.0 / 3.0);
-	MATRIX_T* W_pow_1_3_pow_3 = pow(W_pow_1_3, 3);
-	MATRIX_ID(free)(W_pow_1_3);
-	VECTOR_ID(view) cyc3 = MATRIX_ID(diagonal)(W_pow_1_3_pow_3);
-	
-	// K(cyc3==0)=inf;
-	VECTOR_T* cyc3_eq_0 = compare_elements(&cyc3.vector, fp_equal, 0.0);
-	logical_index_assign(K, cyc3_eq_0, GSL_POSINF);
-	VECTOR_ID(free)(cyc3_eq_0);
-	
-	// C=cyc3./(K.*(K-1));
-	VECTOR_T* K_sub_1 = copy(K);
-	VECTOR_ID(add_constant)(K_sub_1, -1.0);
-	VECTOR_ID(mul)(K, K_sub_1);
-	VECTOR_ID(free)(K_sub_1);
-	VECTOR_T* C = copy(&cyc3.vector);
-	MATRIX_ID(free)(W_pow_1_3_pow_3);
-	VECTOR_ID(div)(C, K);
-	VECTOR_ID(free)(K);
-	
+	adjacency_list* adj = to_adjacency_list(W);
+	VECTOR_T* C = clustering_coef_wu(adj);
+	adjacency_list_free(adj);
+	return C;
+}
+
+/*
+ * Computes the clustering coefficient for a weighted undirected graph into an
+ * existing vector with one element per node.  If adj is given, the graph is
+ * converted into it with to_adjacency_list_into instead of into a new list, so
+ * that repeated calls do not allocate.
+ */
+void BCT_NAMESPACE::clustering_coef_wu_into(const MATRIX_T* W, VECTOR_T* C, adjacency_list* adj) {
+	if (safe_mode) check_status(W, SQUARE | WEIGHTED | UNDIRECTED, "clustering_coef_wu_into");
+	if (C->size != W->size1) {
+		throw bct_exception("clustering_coef_wu_into: C must have one element per node");
+	}
+	if (adj != NULL) {
+		to_adjacency_list_into(W, adj);
+		clustering_coef_wu_into(adj, C);
+		return;
+	}
+	adjacency_list* _adj = to_adjacency_list(W);
+	clustering_coef_wu_into(_adj, C);
+	adjacency_list_free(_adj);
+}
+
+/*
+ * Computes the clustering coefficient for a weighted undirected graph given as
+ * an adjacency list.  Only the neighbors of each node's neighbors are visited,
+ * instead of cubing the whole matrix, and triangles are accumulated in ACC_T.
+ */
+VECTOR_T* BCT_NAMESPACE::clustering_coef_wu(const adjacency_list* W) {
+	VECTOR_T* C = VECTOR_ID(alloc)(W->size);
+	clustering_coef_wu_into(W, C);
+	return C;
+}
+
+/*
+ * Computes the clustering coefficient for a weighted undirected graph given as
+ * an adjacency list into an existing vector with one element per node.
+ */
+void BCT_NAMESPACE::clustering_coef_wu_into(const adjacency_list* W, VECTOR_T* C) {
+	if ((int)C->size != W->size) {
+		throw bct_exception("clustering_coef_wu_into: C must have one element per node");
+	}
+	std::vector<ACC_T> C_acc(W->size + 1);
+	bct_kernels::clustering_coef_wu(to_graph_view(W), clustering_coef_wu_zero, &C_acc[0]);
+	for (int i = 0; i < W->size; i++) {
+		VECTOR_ID(set)(C, i, (FP_T)C_acc[i]);
+	}
+}
+
+/*
+ * Computes the clustering coefficient for a weighted undirected graph stored as
+ * a packed symmetric matrix.
+ */
+VECTOR_T* BCT_NAMESPACE::clustering_coef_wu(const packed_matrix* W) {
+	adjacency_list* adj = to_adjacency_list(W);
+	VECTOR_T* C = clustering_coef_wu(adj);
+	adjacency_list_free(adj);
 	return C;
 }
+
+/*
+ * Returns whether a sum of weighted triangles is zero, as compared in the
+ * MATLAB version (cyc3==0).
+ */
+bool BCT_NAMESPACE::clustering_coef_wu_zero(ACC_T x) {
+	return fp_equal((FP_T)x, 0.0);
+}
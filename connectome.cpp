@@ -0,0 +1,416 @@
+#include <climits>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bct.h"
+
+/*
+ * Binary connectome files consist of a 64-byte header followed by either a
+ * dense payload (all N*N weights in row-major order) or a sparse payload in
+ * compressed sparse row form (N+1 row offsets, then the column of each edge,
+ * then the weight of each edge).  Offsets and columns are 32-bit integers;
+ * weights are stored as float, double, or long double.  Every array begins on
+ * a 64-byte boundary so that it can be used in place once the file is mapped
+ * into memory.  Numbers are stored in the byte order of the machine that wrote
+ * the file, which is recorded in the header and checked when reading.
+ */
+namespace BCT_NAMESPACE {
+	struct connectome_header {
+		char magic[4];
+		uint32_t byte_order;
+		uint32_t version;
+		uint32_t type;
+		uint32_t type_size;
+		uint32_t format;
+		uint64_t size;
+		uint64_t edges;
+		char reserved[24];
+	};
+	struct connectome_layout {
+		std::size_t offsets;
+		std::size_t nodes;
+		std::size_t weights;
+		std::size_t length;
+	};
+	const char connectome_magic[4] = { 'B', 'C', 'T', 'C' };
+	const uint32_t connectome_byte_order = 0x01020304;
+	const uint32_t connectome_version = 1;
+	const std::size_t connectome_alignment = 64;
+	enum { CONNECTOME_FLOAT = 1, CONNECTOME_DOUBLE = 2, CONNECTOME_LONG_DOUBLE = 3 };
+	enum { CONNECTOME_DENSE = 0, CONNECTOME_SPARSE = 1 };
+	
+	uint32_t connectome_type();
+	bool connectome_get_layout(const connectome_header& header, connectome_layout* layout);
+	bool connectome_add(std::size_t a, std::size_t b, std::size_t* sum);
+	bool connectome_multiply(std::size_t a, std::size_t b, std::size_t* product);
+	bool connectome_align(std::size_t* position);
+	bool connectome_check_sparse(const connectome_header& header, const connectome_layout& layout, const char* bytes);
+	const connectome_header* connectome_map(const std::string& filename, void** data, std::size_t* length, connectome_layout* layout);
+	FP_T connectome_weight(const char* weights, uint32_t type, std::size_t index);
+	void connectome_write(const connectome_header& header, const void* const* arrays, const std::size_t* sizes, const std::string& filename);
+}
+
+/*
+ * Writes a square matrix to a binary connectome file.  If sparse is true, only
+ * nonzero entries are stored; otherwise all entries are stored.
+ */
+void BCT_NAMESPACE::write_connectome(const MATRIX_T* m, const std::string& filename, bool sparse) {
+	if (safe_mode) check_status(m, SQUARE, "write_connectome");
+	if (sparse) {
+		adjacency_list* adj = to_adjacency_list(m);
+		try {
+			write_connectome(adj, filename);
+		} catch (...) {
+			adjacency_list_free(adj);
+			throw;
+		}
+		adjacency_list_free(adj);
+		return;
+	}
+	int N = m->size1;
+	connectome_header header;
+	std::memset(&header, 0, sizeof(connectome_header));
+	header.format = CONNECTOME_DENSE;
+	header.size = N;
+	header.edges = nnz(m);
+	
+	// Matrices that are not stored contiguously are copied first
+	std::vector<FP_T> values;
+	const FP_T* data = m->data;
+	if ((int)m->tda != N) {
+		values.resize((std::size_t)N * N + 1);
+		for (int i = 0; i < N; i++) {
+			for (int j = 0; j < N; j++) {
+				values[(std::size_t)i * N + j] = MATRIX_ID(get)(m, i, j);
+			}
+		}
+		data = &values[0];
+	}
+	const void* payload[] = { data };
+	std::size_t payload_size[] = { (std::size_t)N * N * sizeof(FP_T) };
+	connectome_write(header, payload, payload_size, filename);
+}
+
+/*
+ * Writes an adjacency list to a sparse binary connectome file.
+ */
+void BCT_NAMESPACE::write_connectome(const adjacency_list* adj, const std::string& filename) {
+	int N = adj->size;
+	connectome_header header;
+	std::memset(&header, 0, sizeof(connectome_header));
+	header.format = CONNECTOME_SPARSE;
+	header.size = N;
+	header.edges = adj->offsets[N];
+	std::vector<int32_t> offsets(adj->offsets, adj->offsets + N + 1);
+	std::vector<int32_t> nodes(adj->nodes, adj->nodes + header.edges);
+	nodes.push_back(0);
+	const void* payload[] = { &offsets[0], &nodes[0], adj->weights };
+	std::size_t payload_size[] = {
+		(N + 1) * sizeof(int32_t),
+		(std::size_t)header.edges * sizeof(int32_t),
+		(std::size_t)header.edges * sizeof(FP_T)
+	};
+	connectome_write(header, payload, payload_size, filename);
+}
+
+/*
+ * Maps a binary connectome file into memory without copying it.  A dense file
+ * is exposed as conn->m and a sparse file as conn->adj; the other is NULL.
+ * The row offsets and columns of a sparse file are read once to check that
+ * they describe a valid graph.  Both point directly into the mapping, which is
+ * private to this process, so they are valid until connectome_close is called
+ * and must not be freed with gsl_matrix_free or adjacency_list_free.  The file
+ * must store weights with the same precision as this library; use
+ * read_connectome to load files of any precision.
+ */
+BCT_NAMESPACE::connectome* BCT_NAMESPACE::connectome_open(const std::string& filename) {
+	void* data;
+	std::size_t length;
+	connectome_layout layout;
+	const connectome_header* header = connectome_map(filename, &data, &length, &layout);
+	if (header->type != connectome_type()) {
+		munmap(data, length);
+		throw bct_exception(filename + " does not store weights with the precision of this library");
+	}
+	char* bytes = (char*)data;
+	connectome* conn = new connectome;
+	conn->size = header->size;
+	conn->edges = header->edges;
+	conn->m = NULL;
+	conn->adj = NULL;
+	conn->data = data;
+	conn->length = length;
+	if (header->format == CONNECTOME_DENSE) {
+		MATRIX_ID(view) view = MATRIX_ID(view_array)((FP_T*)(bytes + layout.weights), conn->size, conn->size);
+		conn->m = new MATRIX_T(view.matrix);
+	} else {
+		conn->adj = new adjacency_list;
+		conn->adj->size = conn->size;
+		conn->adj->capacity = conn->edges;
+		conn->adj->offsets = (int*)(bytes + layout.offsets);
+		conn->adj->nodes = (int*)(bytes + layout.nodes);
+		conn->adj->weights = (FP_T*)(bytes + layout.weights);
+	}
+	return conn;
+}
+
+/*
+ * Unmaps a binary connectome file.
+ */
+void BCT_NAMESPACE::connectome_close(connectome* conn) {
+	if (conn == NULL) {
+		return;
+	}
+	delete conn->m;
+	delete conn->adj;
+	munmap(conn->data, conn->length);
+	delete conn;
+}
+
+/*
+ * Reads a binary connectome file of any precision and format into a newly
+ * allocated matrix.
+ */
+MATRIX_T* BCT_NAMESPACE::read_connectome(const std::string& filename) {
+	void* data;
+	std::size_t length;
+	connectome_layout layout;
+	const connectome_header* header = connectome_map(filename, &data, &length, &layout);
+	const char* bytes = (const char*)data;
+	int N = header->size;
+	MATRIX_T* m = zeros(N);
+	if (header->format == CONNECTOME_DENSE) {
+		for (int i = 0; i < N; i++) {
+			for (int j = 0; j < N; j++) {
+				FP_T value = connectome_weight(bytes + layout.weights, header->type, (std::size_t)i * N + j);
+				MATRIX_ID(set)(m, i, j, value);
+			}
+		}
+	} else {
+		const int32_t* offsets = (const int32_t*)(bytes + layout.offsets);
+		const int32_t* nodes = (const int32_t*)(bytes + layout.nodes);
+		for (int i = 0; i < N; i++) {
+			for (int k = offsets[i]; k < offsets[i + 1]; k++) {
+				FP_T value = connectome_weight(bytes + layout.weights, header->type, k);
+				MATRIX_ID(set)(m, i, nodes[k], value);
+			}
+		}
+	}
+	munmap(data, length);
+	return m;
+}
+
+/*
+ * Returns the type code for weights of this library's precision.
+ */
+uint32_t BCT_NAMESPACE::connectome_type() {
+	if (sizeof(FP_T) == sizeof(float)) {
+		return CONNECTOME_FLOAT;
+	} else if (sizeof(FP_T) == sizeof(double)) {
+		return CONNECTOME_DOUBLE;
+	} else {
+		return CONNECTOME_LONG_DOUBLE;
+	}
+}
+
+/*
+ * Computes where each array of the payload begins and where the file ends.
+ * Returns false if the file would be larger than can be addressed.
+ */
+bool BCT_NAMESPACE::connectome_get_layout(const connectome_header& header, connectome_layout* layout) {
+	std::size_t N = header.size;
+	std::size_t edges = header.edges;
+	std::size_t position = sizeof(connectome_header);
+	std::size_t size;
+	if (header.format == CONNECTOME_DENSE) {
+		layout->offsets = position;
+		layout->nodes = position;
+		layout->weights = position;
+		if (!connectome_multiply(N, N, &size) ||
+			!connectome_multiply(size, header.type_size, &size) ||
+			!connectome_add(position, size, &position)) {
+			return false;
+		}
+	} else {
+		layout->offsets = position;
+		if (!connectome_multiply(N + 1, sizeof(int32_t), &size) ||
+			!connectome_add(position, size, &position) ||
+			!connectome_align(&position)) {
+			return false;
+		}
+		layout->nodes = position;
+		if (!connectome_multiply(edges, sizeof(int32_t), &size) ||
+			!connectome_add(position, size, &position) ||
+			!connectome_align(&position)) {
+			return false;
+		}
+		layout->weights = position;
+		if (!connectome_multiply(edges, header.type_size, &size) ||
+			!connectome_add(position, size, &position)) {
+			return false;
+		}
+	}
+	layout->length = position;
+	return true;
+}
+
+/*
+ * Adds or multiplies two sizes, returning false on overflow.
+ */
+bool BCT_NAMESPACE::connectome_add(std::size_t a, std::size_t b, std::size_t* sum) {
+	if (a > (std::size_t)-1 - b) {
+		return false;
+	}
+	*sum = a + b;
+	return true;
+}
+
+bool BCT_NAMESPACE::connectome_multiply(std::size_t a, std::size_t b, std::size_t* product) {
+	if (b != 0 && a > (std::size_t)-1 / b) {
+		return false;
+	}
+	*product = a * b;
+	return true;
+}
+
+/*
+ * Rounds a position up to the alignment, returning false on overflow.
+ */
+bool BCT_NAMESPACE::connectome_align(std::size_t* position) {
+	if (!connectome_add(*position, connectome_alignment - 1, position)) {
+		return false;
+	}
+	*position = *position / connectome_alignment * connectome_alignment;
+	return true;
+}
+
+/*
+ * Checks that the row offsets of a sparse payload start at 0, never decrease,
+ * and end at the number of edges, and that every column is a node.
+ */
+bool BCT_NAMESPACE::connectome_check_sparse(const connectome_header& header, const connectome_layout& layout, const char* bytes) {
+	int N = header.size;
+	int edges = header.edges;
+	const int32_t* offsets = (const int32_t*)(bytes + layout.offsets);
+	const int32_t* nodes = (const int32_t*)(bytes + layout.nodes);
+	if (offsets[0] != 0 || offsets[N] != edges) {
+		return false;
+	}
+	for (int i = 0; i < N; i++) {
+		if (offsets[i + 1] < offsets[i]) {
+			return false;
+		}
+	}
+	for (int k = 0; k < edges; k++) {
+		if (nodes[k] < 0 || nodes[k] >= N) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * Maps a binary connectome file into memory and validates its header and, for
+ * sparse files, the structure of its payload.  The layout of the payload is
+ * returned in layout.
+ */
+const BCT_NAMESPACE::connectome_header* BCT_NAMESPACE::connectome_map(const std::string& filename, void** data, std::size_t* length, connectome_layout* layout) {
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd == -1) {
+		throw bct_exception("Cannot open " + filename);
+	}
+	struct stat info;
+	if (fstat(fd, &info) == -1 || info.st_size < (off_t)sizeof(connectome_header)) {
+		close(fd);
+		throw bct_exception(filename + " is not a binary connectome file");
+	}
+	*length = info.st_size;
+	
+	// A private writable mapping lets the matrix be modified without copying
+	// pages that are never written and without changing the file
+	*data = mmap(NULL, *length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (*data == MAP_FAILED) {
+		throw bct_exception("Cannot map " + filename);
+	}
+	const connectome_header* header = (const connectome_header*)*data;
+	std::string error;
+	if (std::memcmp(header->magic, connectome_magic, 4) != 0) {
+		error = filename + " is not a binary connectome file";
+	} else if (header->byte_order != connectome_byte_order) {
+		error = filename + " was written with a different byte order";
+	} else if (header->version != connectome_version) {
+		error = filename + " has an unsupported version";
+	} else if (header->format != CONNECTOME_DENSE && header->format != CONNECTOME_SPARSE) {
+		error = filename + " has an unknown format";
+	} else if ((header->type != CONNECTOME_FLOAT || header->type_size != sizeof(float)) &&
+			   (header->type != CONNECTOME_DOUBLE || header->type_size != sizeof(double)) &&
+			   (header->type != CONNECTOME_LONG_DOUBLE || header->type_size != sizeof(long double))) {
+		error = filename + " has an unsupported weight type";
+	} else if (header->size > INT_MAX || (header->format == CONNECTOME_SPARSE && header->edges > INT_MAX) ||
+			   !connectome_get_layout(*header, layout)) {
+		error = filename + " is too large";
+	} else if (layout->length > *length) {
+		error = filename + " is truncated";
+	} else if (header->format == CONNECTOME_SPARSE && !connectome_check_sparse(*header, *layout, (const char*)*data)) {
+		error = filename + " has invalid row offsets or columns";
+	}
+	if (!error.empty()) {
+		munmap(*data, *length);
+		throw bct_exception(error);
+	}
+	return header;
+}
+
+/*
+ * Returns a weight from a payload of the given type.
+ */
+FP_T BCT_NAMESPACE::connectome_weight(const char* weights, uint32_t type, std::size_t index) {
+	if (type == CONNECTOME_FLOAT) {
+		return (FP_T)((const float*)weights)[index];
+	} else if (type == CONNECTOME_DOUBLE) {
+		return (FP_T)((const double*)weights)[index];
+	} else {
+		return (FP_T)((const long double*)weights)[index];
+	}
+}
+
+/*
+ * Writes a header followed by the given arrays, each padded to the alignment.
+ */
+void BCT_NAMESPACE::connectome_write(const connectome_header& header, const void* const* arrays, const std::size_t* sizes, const std::string& filename) {
+	connectome_header h = header;
+	std::memcpy(h.magic, connectome_magic, 4);
+	h.byte_order = connectome_byte_order;
+	h.version = connectome_version;
+	h.type = connectome_type();
+	h.type_size = sizeof(FP_T);
+	std::FILE* f = std::fopen(filename.c_str(), "wb");
+	if (f == NULL) {
+		throw bct_exception("Cannot open " + filename);
+	}
+	int count = (h.format == CONNECTOME_DENSE) ? 1 : 3;
+	bool ok = std::fwrite(&h, sizeof(connectome_header), 1, f) == 1;
+	std::size_t position = sizeof(connectome_header);
+	char padding[connectome_alignment] = { 0 };
+	for (int i = 0; i < count && ok; i++) {
+		std::size_t aligned = (position + connectome_alignment - 1) / connectome_alignment * connectome_alignment;
+		if (aligned > position) {
+			ok = std::fwrite(padding, 1, aligned - position, f) == aligned - position;
+		}
+		if (ok && sizes[i] > 0) {
+			ok = std::fwrite(arrays[i], 1, sizes[i], f) == sizes[i];
+		}
+		position = aligned + sizes[i];
+	}
+	if (std::fclose(f) != 0 || !ok) {
+		throw bct_exception("Cannot write " + filename);
+	}
+}
@@ -6,18 +6,25 @@
  * Returns a copy of the given matrix with each nonzero element inverted.
  */
 MATRIX_T* BCT_NAMESPACE::invert_elements(const MATRIX_T* m) {
-	MATRIX_T* inv_m = MATRIX_ID(alloc)(m->size1, m->size2);
+	MATRIX_T* inv_m = copy(m);
+	invert_elements_in_place(inv_m);
+	return inv_m;
+}
+
+/*
+ * Inverts each nonzero element of the given matrix in place.
+ */
+void BCT_NAMESPACE::invert_elements_in_place(MATRIX_T* m) {
 	for (int i = 0; i < (int)m->size1; i++) {
 		for (int j = 0; j < (int)m->size2; j++) {
 			FP_T value = MATRIX_ID(get)(m, i, j);
 			if (fp_nonzero(value)) {
-				MATRIX_ID(set)(inv_m, i, j, 1.0 / value);
+				MATRIX_ID(set)(m, i, j, 1.0 / value);
 			} else {
-				MATRIX_ID(set)(inv_m, i, j, 0.0);
+				MATRIX_ID(set)(m, i, j, 0.0);
 			}
 		}
 	}
-	return inv_m;
 }
 
 /*
@@ -25,11 +32,18 @@ MATRIX_T* BCT_NAMESPACE::invert_elements(const MATRIX_T* m) {
  */
 MATRIX_T* BCT_NAMESPACE::remove_loops(const MATRIX_T* m) {
 	MATRIX_T* nl_m = copy(m);
-	VECTOR_ID(view) diag_nl_m = MATRIX_ID(diagonal)(nl_m);
-	VECTOR_ID(set_zero)(&diag_nl_m.vector);
+	remove_loops_in_place(nl_m);
 	return nl_m;
 }
 
+/*
+ * Removes loops from the given matrix in place.
+ */
+void BCT_NAMESPACE::remove_loops_in_place(MATRIX_T* m) {
+	VECTOR_ID(view) diag_m = MATRIX_ID(diagonal)(m);
+	VECTOR_ID(set_zero)(&diag_m.vector);
+}
+
 /*
  * Returns a binary copy of the given matrix.
  */
@@ -37,17 +51,35 @@ MATRIX_T* BCT_NAMESPACE::to_binary(const MATRIX_T* m) {
 	return compare_elements(m, fp_not_equal, 0.0);
 }
 
+/*
+ * Converts the given matrix to binary in place.
+ */
+void BCT_NAMESPACE::to_binary_in_place(MATRIX_T* m) {
+	for (int i = 0; i < (int)m->size1; i++) {
+		for (int j = 0; j < (int)m->size2; j++) {
+			MATRIX_ID(set)(m, i, j, fp_not_equal(MATRIX_ID(get)(m, i, j), 0.0) ? 1.0 : 0.0);
+		}
+	}
+}
+
 /*
  * Returns a positive copy of the given matrix.
  */
 MATRIX_T* BCT_NAMESPACE::to_positive(const MATRIX_T* m) {
-	MATRIX_T* pos_m = MATRIX_ID(alloc)(m->size1, m->size2);
+	MATRIX_T* pos_m = copy(m);
+	to_positive_in_place(pos_m);
+	return pos_m;
+}
+
+/*
+ * Converts the given matrix to positive in place.
+ */
+void BCT_NAMESPACE::to_positive_in_place(MATRIX_T* m) {
 	for (int i = 0; i < (int)m->size1; i++) {
 		for (int j = 0; j < (int)m->size2; j++) {
-			MATRIX_ID(set)(pos_m, i, j, std::abs(MATRIX_ID(get)(m, i, j)));
+			MATRIX_ID(set)(m, i, j, std::abs(MATRIX_ID(get)(m, i, j)));
 		}
 	}
-	return pos_m;
 }
 
 /*
@@ -56,18 +88,25 @@ MATRIX_T* BCT_NAMESPACE::to_positive(const MATRIX_T* m) {
  * are set to one.  Otherwise, both are set to zero.
  */
 MATRIX_T* BCT_NAMESPACE::to_undirected_bin(const MATRIX_T* m) {
-	MATRIX_T* und_m = MATRIX_ID(calloc)(m->size1, m->size2);
+	MATRIX_T* und_m = copy(m);
+	to_undirected_bin_in_place(und_m);
+	return und_m;
+}
+
+/*
+ * Converts the given binary matrix to undirected in place, as
+ * to_undirected_bin does.
+ */
+void BCT_NAMESPACE::to_undirected_bin_in_place(MATRIX_T* m) {
 	for (int i = 0; i < (int)m->size1; i++) {
 		for (int j = i; j < (int)m->size2; j++) {
 			FP_T value_ij = MATRIX_ID(get)(m, i, j);
 			FP_T value_ji = MATRIX_ID(get)(m, j, i);
-			if (fp_nonzero(value_ij) || fp_nonzero(value_ji)) {
-				MATRIX_ID(set)(und_m, i, j, 1.0);
-				MATRIX_ID(set)(und_m, j, i, 1.0);
-			}
+			FP_T value = (fp_nonzero(value_ij) || fp_nonzero(value_ji)) ? 1.0 : 0.0;
+			MATRIX_ID(set)(m, i, j, value);
+			MATRIX_ID(set)(m, j, i, value);
 		}
 	}
-	return und_m;
 }
 
 /*
@@ -75,17 +114,26 @@ MATRIX_T* BCT_NAMESPACE::to_undirected_bin(const MATRIX_T* m) {
  * nodes, m(i, j) and m(j, i) are both set to the average of their two values.
  */
 MATRIX_T* BCT_NAMESPACE::to_undirected_wei(const MATRIX_T* m) {
-	MATRIX_T* und_m = MATRIX_ID(calloc)(m->size1, m->size2);
+	MATRIX_T* und_m = copy(m);
+	to_undirected_wei_in_place(und_m);
+	return und_m;
+}
+
+/*
+ * Converts the given weighted matrix to undirected in place, as
+ * to_undirected_wei does.
+ */
+void BCT_NAMESPACE::to_undirected_wei_in_place(MATRIX_T* m) {
 	for (int i = 0; i < (int)m->size1; i++) {
 		for (int j = i; j < (int)m->size2; j++) {
 			FP_T value_ij = MATRIX_ID(get)(m, i, j);
 			FP_T value_ji = MATRIX_ID(get)(m, j, i);
+			FP_T average = 0.0;
 			if (fp_nonzero(value_ij) || fp_nonzero(value_ji)) {
-				FP_T average = (value_ij + value_ji) / 2.0;
-				MATRIX_ID(set)(und_m, i, j, average);
-				MATRIX_ID(set)(und_m, j, i, average);
+				average = (value_ij + value_ji) / 2.0;
 			}
+			MATRIX_ID(set)(m, i, j, average);
+			MATRIX_ID(set)(m, j, i, average);
 		}
 	}
-	return und_m;
 }
@@ -1,5 +1,54 @@
 #include "bct.h"
 
+/*
+ * Computes fcyc and pcyc (see below) directly from a connection matrix,
+ * enumerating paths as findpaths does but keeping only the number of paths and
+ * cycles of each length instead of the full Pq matrices.  Returns fcyc.
+ */
+VECTOR_T* BCT_NAMESPACE::cycprob(const MATRIX_T* CIJ, const VECTOR_T* sources, int qmax, VECTOR_T** pcyc) {
+	if (safe_mode) check_status(CIJ, SQUARE, "cycprob");
+	
+	// sum(sum(Pq(:,:,q))) and sum(diag(Pq(:,:,q)))
+	VECTOR_T* ncyc;
+	VECTOR_T* plq = findpaths_plq(CIJ, sources, qmax, NULL, NULL, &ncyc);
+	
+	// fcyc = zeros(1,size(Pq,3));
+	VECTOR_T* fcyc = zeros_vector(qmax + 1);
+	
+	// for q=1:size(Pq,3)
+	for (int q = 1; q <= qmax; q++) {
+		
+		// if(sum(sum(Pq(:,:,q)))>0)
+		if (VECTOR_ID(get)(plq, q) > 0.0) {
+			
+			// fcyc(q) = sum(diag(Pq(:,:,q)))/sum(sum(Pq(:,:,q)));
+			VECTOR_ID(set)(fcyc, q, VECTOR_ID(get)(ncyc, q) / VECTOR_ID(get)(plq, q));
+		}
+	}
+	
+	if (pcyc != NULL) {
+		
+		// pcyc = zeros(1,size(Pq,3));
+		*pcyc = zeros_vector(qmax + 1);
+		
+		// for q=2:size(Pq,3)
+		for (int q = 2; q <= qmax; q++) {
+			
+			// if((sum(sum(Pq(:,:,q-1)))-sum(diag(Pq(:,:,q-1))))>0)
+			FP_T open_paths = VECTOR_ID(get)(plq, q - 1) - VECTOR_ID(get)(ncyc, q - 1);
+			if (open_paths > 0.0) {
+				
+				// pcyc(q) = sum(diag(Pq(:,:,q)))/(sum(sum(Pq(:,:,q-1)))-sum(diag(Pq(:,:,q-1))));
+				VECTOR_ID(set)(*pcyc, q, VECTOR_ID(get)(ncyc, q) / open_paths);
+			}
+		}
+	}
+	
+	VECTOR_ID(free)(plq);
+	VECTOR_ID(free)(ncyc);
+	return fcyc;
+}
+
 /*
  * Computes the fraction of all paths that are cycles.
  */
@@ -1,5 +1,11 @@
+#include <vector>
+
 #include "bct.h"
 
+namespace BCT_NAMESPACE {
+	void degrees_und_fill(const MATRIX_T* CIJ, VECTOR_T* deg);
+}
+
 /*
  * Computes degree for an undirected graph.  Connection weights are ignored.
  */
@@ -9,7 +15,52 @@ VECTOR_T* BCT_NAMESPACE::degrees_und(const MATRIX_T* CIJ) {
 	// CIJ = double(CIJ~=0);
 	// deg = sum(CIJ);
 	VECTOR_T* deg = VECTOR_ID(alloc)(CIJ->size2);
+	degrees_und_fill(CIJ, deg);
+	return deg;
+}
+
+/*
+ * Computes degree for an undirected graph into an existing vector with one
+ * element per node.
+ */
+void BCT_NAMESPACE::degrees_und_into(const MATRIX_T* CIJ, VECTOR_T* deg) {
+	if (safe_mode) check_status(CIJ, SQUARE | UNDIRECTED, "degrees_und_into");
+	if (deg->size != CIJ->size2) {
+		throw bct_exception("degrees_und_into: deg must have one element per node");
+	}
+	degrees_und_fill(CIJ, deg);
+}
 
+/*
+ * Computes degree for an undirected graph stored as a packed symmetric matrix.
+ * Each element of the upper triangle is read once and counted for both of its
+ * nodes.
+ */
+VECTOR_T* BCT_NAMESPACE::degrees_und(const packed_matrix* CIJ) {
+	int N = CIJ->size;
+	std::vector<int> deg(N, 0);
+	for (int i = 0; i < N; i++) {
+		const FP_T* row = packed_matrix_const_row(CIJ, i);
+		for (int j = i; j < N; j++) {
+			if (fp_nonzero(row[j - i])) {
+				deg[i]++;
+				if (j != i) {
+					deg[j]++;
+				}
+			}
+		}
+	}
+	VECTOR_T* deg_v = VECTOR_ID(alloc)(N);
+	for (int i = 0; i < N; i++) {
+		VECTOR_ID(set)(deg_v, i, (FP_T)deg[i]);
+	}
+	return deg_v;
+}
+
+/*
+ * Counts the nonzero elements in each column of CIJ.
+ */
+void BCT_NAMESPACE::degrees_und_fill(const MATRIX_T* CIJ, VECTOR_T* deg) {
 #ifdef _OPENMP
 #pragma omp parallel for shared(deg)
 #endif
@@ -17,5 +68,4 @@ VECTOR_T* BCT_NAMESPACE::degrees_und(const MATRIX_T* CIJ) {
 		VECTOR_ID(const_view) CIJ_col_i = MATRIX_ID(const_column)(CIJ, i);
 		VECTOR_ID(set)(deg, i, nnz(&CIJ_col_i.vector));
 	}
-	return deg;
 }
@@ -10,10 +10,18 @@ FP_T BCT_NAMESPACE::density_und(const MATRIX_T* CIJ) {
 	int N = CIJ->size1;
 	
 	// K = nnz(triu(CIJ));
-	MATRIX_T* triu_CIJ = triu(CIJ);
-	int K = nnz(triu_CIJ);
-	MATRIX_ID(free)(triu_CIJ);
+	int K = number_of_edges_und(CIJ);
 	
 	// kden = K/((N^2-N)/2);
 	return (FP_T)K / ((FP_T)(N * (N - 1)) / 2.0);
 }
+
+/*
+ * Computes density for an undirected graph stored as a packed symmetric
+ * matrix.  Connection weights are ignored.
+ */
+FP_T BCT_NAMESPACE::density_und(const packed_matrix* CIJ) {
+	int N = CIJ->size;
+	int K = number_of_edges_und(CIJ);
+	return (FP_T)K / ((FP_T)(N * (N - 1)) / 2.0);
+}
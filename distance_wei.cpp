@@ -1,107 +1,139 @@
-#include <gsl/gsl_math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "bct.h"
 
 /*
- * Computes the distance matrix for a weighted graph.
+ * Computes the distance matrix for a weighted graph.  Connection lengths must be
+ * positive.
  */
 MATRIX_T* BCT_NAMESPACE::distance_wei(const MATRIX_T* G) {
-	if (safe_mode) check_status(G, SQUARE | WEIGHTED, "distance_wei");
-	
-	// n=length(G);
+	if (safe_mode) check_status(G, SQUARE | WEIGHTED | POSITIVE, "distance_wei");
 	int n = length(G);
-	
-	// D=zeros(n); D(~eye(n))=inf;
 	MATRIX_T* D = MATRIX_ID(alloc)(n, n);
-	MATRIX_ID(set_all)(D, GSL_POSINF);
-	VECTOR_ID(view) diag_D = MATRIX_ID(diagonal)(D);
-	VECTOR_ID(set_all)(&diag_D.vector, 0.0);
+	adjacency_list* L = to_adjacency_list(G);
+	distance_wei_into(L, D);
+	adjacency_list_free(L);
+	return D;
+}
+
+/*
+ * Computes the distance matrix for a weighted graph into an existing n x n
+ * matrix, so that repeated calls do not allocate a new result each time.  If a
+ * workspace is given, the graph is converted into its adjacency list, which is
+ * reused from call to call.
+ */
+void BCT_NAMESPACE::distance_wei_into(const MATRIX_T* G, MATRIX_T* D, distance_wei_workspace* ws) {
+	if (safe_mode) check_status(G, SQUARE | WEIGHTED | POSITIVE, "distance_wei_into");
+	if (D->size1 != G->size1 || D->size2 != G->size1) {
+		throw bct_exception("distance_wei_into: D must be n x n");
+	}
+	if (ws == NULL) {
+		adjacency_list* L = to_adjacency_list(G);
+		distance_wei_into(L, D);
+		adjacency_list_free(L);
+		return;
+	}
+	if (ws->size != length(G)) {
+		throw bct_exception("distance_wei_into: ws must have one element per node");
+	}
+	if (ws->L == NULL) {
+		ws->L = adjacency_list_alloc(ws->size, 0);
+	}
+	to_adjacency_list_into(G, ws->L);
+	distance_wei_into(ws->L, D, ws);
+}
+
+/*
+ * Computes the distance matrix for a weighted graph, given as an adjacency
+ * list of lengths, into an existing n x n matrix.  Each row is found with
+ * Dijkstra's algorithm, as in distance_wei_row; path lengths are summed along
+ * each path from the source, as in the MATLAB version.  Each thread allocates
+ * one workspace for all of its rows, except that the first thread uses ws if
+ * it is given, so a call made on a single thread allocates nothing.
+ */
+void BCT_NAMESPACE::distance_wei_into(const adjacency_list* L, MATRIX_T* D, distance_wei_workspace* ws) {
+	int n = L->size;
+	if ((int)D->size1 != n || (int)D->size2 != n) {
+		throw bct_exception("distance_wei_into: D must be n x n");
+	}
+	if (ws != NULL && ws->size != n) {
+		throw bct_exception("distance_wei_into: ws must have one element per node");
+	}
 	
-	// for u=1:n
-	for (int u = 0; u < n; u++) {
-		
-		// S=true(1,n);
-		VECTOR_T* S = VECTOR_ID(alloc)(n);
-		VECTOR_ID(set_all)(S, 1.0);
-		
-		// G1=G;
-		MATRIX_T* G1 = copy(G);
-		
-		// V=u;
-		VECTOR_T* V = VECTOR_ID(alloc)(1);
-		VECTOR_ID(set)(V, 0, (FP_T)u);
-		
-		// while 1
-		while (true) {
-			
-			// S(V)=0;
-			ordinal_index_assign(S, V, 0.0);
-			
-			// G1(:,V)=0;
-			VECTOR_T* G1_rows = sequence(0, G1->size1 - 1);
-			ordinal_index_assign(G1, G1_rows, V, 0.0);
-			VECTOR_ID(free)(G1_rows);
-			
-			// for v=V
-			for (int i_V = 0; i_V < (int)V->size; i_V++) {
-				int v = (int)VECTOR_ID(get)(V, i_V);
-				
-				// W=find(G1(v,:));
-				VECTOR_ID(view) G1_row_v = MATRIX_ID(row)(G1, v);
-				VECTOR_T* W = find(&G1_row_v.vector);
-				if (W != NULL) {
-					
-					// D(u,W)=min([D(u,W);D(u,v)+G1(v,W)]);
-					VECTOR_T* DG1_row = VECTOR_ID(alloc)(1);
-					VECTOR_ID(set)(DG1_row, 0, (FP_T)u);
-					MATRIX_T* D_u_W = ordinal_index(D, DG1_row, W);
-					FP_T D_u_v = MATRIX_ID(get)(D, u, v);
-					VECTOR_ID(set)(DG1_row, 0, (FP_T)v);
-					MATRIX_T* G1_v_W = ordinal_index(G1, DG1_row, W);
-					MATRIX_ID(add_constant)(G1_v_W, D_u_v);
-					MATRIX_T* cat = concatenate_columns(D_u_W, G1_v_W);
-					MATRIX_ID(free)(D_u_W);
-					MATRIX_ID(free)(G1_v_W);
-					VECTOR_T* min_cat_v = min(cat);
-					MATRIX_ID(free)(cat);
-					MATRIX_T* min_cat = to_row_matrix(min_cat_v);
-					VECTOR_ID(free)(min_cat_v);
-					VECTOR_ID(set)(DG1_row, 0, (FP_T)u);
-					ordinal_index_assign(D, DG1_row, W, min_cat);
-					VECTOR_ID(free)(W);
-					VECTOR_ID(free)(DG1_row);
-					MATRIX_ID(free)(min_cat);
-				}
-			}
-			
-			// minD=min(D(u,S));
-			// if isempty(minD)||isinf(minD), break, end;
-			VECTOR_T* D_row = VECTOR_ID(alloc)(1);
-			VECTOR_ID(set)(D_row, 0, (FP_T)u);
-			MATRIX_T* D_u_S = ord_log_index(D, D_row, S);
-			VECTOR_ID(free)(D_row);
-			if (D_u_S == NULL) {
-				break;
-			} else {
-				FP_T minD = MATRIX_ID(min)(D_u_S);
-				MATRIX_ID(free)(D_u_S);
-				if (gsl_isinf(minD) == 1) {
-					break;
-				}
-				
-				// V=find(D(u,:)==minD);
-				VECTOR_ID(free)(V);
-				VECTOR_ID(view) D_row_u = MATRIX_ID(row)(D, u);
-				VECTOR_T* D_row_u_eq_minD = compare_elements(&D_row_u.vector, fp_equal, minD);
-				V = find(D_row_u_eq_minD);
-				VECTOR_ID(free)(D_row_u_eq_minD);
+#ifdef _OPENMP
+#pragma omp parallel shared(D)
+#endif
+	{
+#ifdef _OPENMP
+		bool own_ws = ws == NULL || omp_get_thread_num() != 0;
+#else
+		bool own_ws = ws == NULL;
+#endif
+		distance_wei_workspace* thread_ws = own_ws ? distance_wei_workspace_alloc(n) : ws;
+#ifdef _OPENMP
+#pragma omp for
+#endif
+		for (int u = 0; u < n; u++) {
+			bct_kernels::distance_wei_row(to_graph_view(L), u, thread_ws->D_row, &thread_ws->dijkstra);
+			for (int v = 0; v < n; v++) {
+				MATRIX_ID(set)(D, u, v, (FP_T)thread_ws->D_row[v]);
 			}
 		}
-		
-		VECTOR_ID(free)(S);
-		MATRIX_ID(free)(G1);
-		VECTOR_ID(free)(V);
+		if (own_ws) {
+			distance_wei_workspace_free(thread_ws);
+		}
 	}
-	
-	return D;
+}
+
+/*
+ * Computes a single row of the distance matrix for a weighted graph, given as
+ * an adjacency list of lengths.  This is Dijkstra's algorithm with a binary
+ * heap, so it needs O(N + E) memory instead of the O(N^2) used by the
+ * full distance matrix.  Distances are accumulated in ACC_T.  D_row must have one
+ * element per node.  A workspace may be given to avoid allocating memory on
+ * each call; it must not be shared between threads.
+ */
+void BCT_NAMESPACE::distance_wei_row(const adjacency_list* L, int source, VECTOR_T* D_row, distance_wei_workspace* ws) {
+	if ((int)D_row->size != L->size) {
+		throw bct_exception("distance_wei_row: D_row must have one element per node");
+	}
+	if (ws != NULL && ws->size != L->size) {
+		throw bct_exception("distance_wei_row: ws must have one element per node");
+	}
+	distance_wei_workspace* _ws = (ws != NULL) ? ws : distance_wei_workspace_alloc(L->size);
+	bct_kernels::distance_wei_row(to_graph_view(L), source, _ws->D_row, &_ws->dijkstra);
+	for (int i = 0; i < L->size; i++) {
+		VECTOR_ID(set)(D_row, i, (FP_T)_ws->D_row[i]);
+	}
+	if (ws == NULL) {
+		distance_wei_workspace_free(_ws);
+	}
+}
+
+/*
+ * Allocates a workspace for Dijkstra's algorithm on graphs with the given number
+ * of nodes.  A workspace holds one row of distances in ACC_T, the heap and
+ * settled flags, and the adjacency list used by the matrix version of
+ * distance_wei_into.  It may be reused for any number of calls on one thread.
+ */
+BCT_NAMESPACE::distance_wei_workspace* BCT_NAMESPACE::distance_wei_workspace_alloc(int size) {
+	distance_wei_workspace* ws = new distance_wei_workspace;
+	ws->size = size;
+	ws->D_row = new ACC_T[size + 1];
+	ws->L = NULL;
+	return ws;
+}
+
+/*
+ * Frees a workspace for Dijkstra's algorithm.
+ */
+void BCT_NAMESPACE::distance_wei_workspace_free(distance_wei_workspace* ws) {
+	if (ws == NULL) {
+		return;
+	}
+	delete[] ws->D_row;
+	adjacency_list_free(ws->L);
+	delete ws;
 }
@@ -1,8 +1,41 @@
+#include <algorithm>
+#include <functional>
 #include <gsl/gsl_math.h>
+#include <utility>
+#include <vector>
 
 #include "bct.h"
 
+namespace BCT_NAMESPACE {
+	
+	/*
+	 * Per-thread scratch space for local efficiency.  label maps node indices
+	 * to positions in the current neighborhood (or -1), and the remaining
+	 * members hold the relabeled neighborhood and the state of its search,
+	 * either as distances and a heap or as rows of bits.
+	 */
+	struct efficiency_local_workspace {
+		std::vector<int> label;
+		std::vector<int> offsets;
+		std::vector<int> nodes;
+		std::vector<FP_T> weights;
+		std::vector<FP_T> distance;
+		std::vector<FP_T> row;
+		std::vector<char> done;
+		std::vector<unsigned long> rows;
+		std::vector<unsigned long> visited;
+		std::vector<unsigned long> frontier;
+		std::vector<unsigned long> next;
+		std::vector<std::pair<FP_T, int> > heap;
+		efficiency_local_workspace(int N) : label(N, -1) { }
+	};
+}
+
+const int dense_limit = 1024;
 MATRIX_T* distance_inv(const MATRIX_T*, const MATRIX_T*);
+FP_T efficiency_global_sum(const MATRIX_T*);
+FP_T efficiency_local_sum(const BCT_NAMESPACE::adjacency_list*, FP_T, const int*, int, BCT_NAMESPACE::efficiency_local_workspace&);
+void relax_row(FP_T*, const FP_T*, FP_T, int, int);
 
 /*
  * Computes global efficiency.  Takes an optional distance matrix that is
@@ -14,6 +47,11 @@ FP_T BCT_NAMESPACE::efficiency_global(const MATRIX_T* G, const MATRIX_T* D) {
 	// N=length(G);
 	int N = length(G);
 	
+	// Without a distance matrix, accumulate one row of distances at a time
+	if (D == NULL) {
+		return efficiency_global_sum(G) / (FP_T)(N * (N - 1));
+	}
+	
 	// e=distance_inv(G);
 	MATRIX_T* e = distance_inv(G, D);
 	
@@ -26,7 +64,10 @@ FP_T BCT_NAMESPACE::efficiency_global(const MATRIX_T* G, const MATRIX_T* D) {
 }
 
 /*
- * Computes local efficiency.
+ * Computes local efficiency.  Instead of extracting G(V,V) and computing its
+ * full distance matrix, each neighborhood is relabeled into a small adjacency
+ * list and searched one source at a time.  Scratch space is allocated once per
+ * thread and reused for every node.
  */
 VECTOR_T* BCT_NAMESPACE::efficiency_local(const MATRIX_T* G) {
 	if (safe_mode) check_status(G, SQUARE, "efficiency_local");
@@ -37,40 +78,44 @@ VECTOR_T* BCT_NAMESPACE::efficiency_local(const MATRIX_T* G) {
 	// E=zeros(N,1);
 	VECTOR_T* E = zeros_vector(N);
 	
-	// for u=1:N
+	adjacency_list* L = to_adjacency_list(G);
+	FP_T uniform_weight = (L->offsets[N] > 0) ? 1.0 / L->weights[0] : 0.0;
+	for (int i = 0; i < L->offsets[N]; i++) {
+		L->weights[i] = 1.0 / L->weights[i];
+		if (L->weights[i] != uniform_weight) {
+			uniform_weight = 0.0;
+		}
+	}
+	
 #ifdef _OPENMP
-#pragma omp parallel for shared(E)
+#pragma omp parallel
 #endif
-	for (int u = 0; u < N; u++) {
+	{
+		efficiency_local_workspace ws(N);
 		
-		// V=find(G(u,:));
-		VECTOR_ID(const_view) G_row_u = MATRIX_ID(const_row)(G, u);
-		VECTOR_T* V = find(&G_row_u.vector);
-		if (V != NULL) {
+		// for u=1:N
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 16)
+#endif
+		for (int u = 0; u < N; u++) {
 			
+			// V=find(G(u,:));
 			// k=length(V);
-			int k = length(V);
+			const int* V = L->nodes + L->offsets[u];
+			int k = L->offsets[u + 1] - L->offsets[u];
 			
 			// if k>=2;
 			if (k >= 2) {
 				
 				// e=distance_inv(G(V,V));
-				MATRIX_T* G_idx = ordinal_index(G, V, V);
-				MATRIX_T* e = distance_inv(G_idx, NULL);
-				MATRIX_ID(free)(G_idx);
-				
 				// E(u)=sum(e(:))./(k^2-k);
-				VECTOR_T* e_v = to_vector(e);
-				MATRIX_ID(free)(e);
-				FP_T sum_e = sum(e_v);
-				VECTOR_ID(free)(e_v);
+				FP_T sum_e = efficiency_local_sum(L, uniform_weight, V, k, ws);
 				VECTOR_ID(set)(E, u, sum_e / (FP_T)(k * (k - 1)));
 			}
-			
-			VECTOR_ID(free)(V);
 		}
 	}
 	
+	adjacency_list_free(L);
 	return E;
 }
 
@@ -89,3 +134,256 @@ MATRIX_T* distance_inv(const MATRIX_T* G, const MATRIX_T* D) {
 	}
 	return D_inv;
 }
+
+/*
+ * Computes sum(e(:)) for e=distance_inv(G) without storing e.  Shortest paths
+ * are found one source at a time on an adjacency list of inverted weights, so
+ * memory use is O(N + E) rather than O(N^2).
+ */
+FP_T efficiency_global_sum(const MATRIX_T* G) {
+	using namespace BCT_NAMESPACE;
+	
+	int N = G->size1;
+	adjacency_list* L = to_adjacency_list(G);
+	for (int i = 0; i < L->offsets[N]; i++) {
+		L->weights[i] = 1.0 / L->weights[i];
+	}
+	FP_T sum_e = 0.0;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+	{
+		VECTOR_T* D_row = VECTOR_ID(alloc)(N);
+		distance_wei_workspace* ws = distance_wei_workspace_alloc(N);
+#ifdef _OPENMP
+#pragma omp for reduction(+:sum_e)
+#endif
+		for (int u = 0; u < N; u++) {
+			distance_wei_row(L, u, D_row, ws);
+			for (int v = 0; v < N; v++) {
+				FP_T value = VECTOR_ID(get)(D_row, v);
+				if (gsl_finite(value) == 1 && fp_nonzero(value)) {
+					sum_e += 1.0 / value;
+				}
+			}
+		}
+		VECTOR_ID(free)(D_row);
+		distance_wei_workspace_free(ws);
+	}
+	adjacency_list_free(L);
+	return sum_e;
+}
+
+/*
+ * Computes sum(e(:)) for e=distance_inv(G(V,V)), where L holds the inverted
+ * weights of G.  The neighborhood V is relabeled to 0..k-1 and Dijkstra's
+ * algorithm is run from each of its nodes without leaving the neighborhood.
+ * If uniform_weight is positive, every edge has that weight and breadth-first
+ * search is used instead.  Dense neighborhoods of up to dense_limit nodes are
+ * solved all at once with the Floyd-Warshall algorithm.
+ */
+FP_T efficiency_local_sum(const BCT_NAMESPACE::adjacency_list* L, FP_T uniform_weight, const int* V, int k, BCT_NAMESPACE::efficiency_local_workspace& ws) {
+	using namespace BCT_NAMESPACE;
+	typedef std::pair<FP_T, int> heap_entry;
+	
+	for (int i = 0; i < k; i++) {
+		ws.label[V[i]] = i;
+	}
+	ws.offsets.resize(k + 1);
+	ws.nodes.clear();
+	ws.weights.clear();
+	for (int i = 0; i < k; i++) {
+		ws.offsets[i] = ws.nodes.size();
+		for (int j = L->offsets[V[i]]; j < L->offsets[V[i] + 1]; j++) {
+			int w = ws.label[L->nodes[j]];
+			if (w >= 0) {
+				ws.nodes.push_back(w);
+				ws.weights.push_back(L->weights[j]);
+			}
+		}
+	}
+	ws.offsets[k] = ws.nodes.size();
+	for (int i = 0; i < k; i++) {
+		ws.label[V[i]] = -1;
+	}
+	
+	FP_T sum_e = 0.0;
+	
+	// With equal weights, run a breadth-first search over rows of bits
+	if (uniform_weight > 0.0) {
+		int words = (k + bit_matrix_word_bits - 1) / bit_matrix_word_bits;
+		ws.rows.assign(k * words, 0);
+		for (int i = 0; i < k; i++) {
+			for (int j = ws.offsets[i]; j < ws.offsets[i + 1]; j++) {
+				int w = ws.nodes[j];
+				ws.rows[i * words + w / bit_matrix_word_bits] |= 1UL << (w % bit_matrix_word_bits);
+			}
+		}
+		ws.visited.resize(words);
+		ws.frontier.resize(words);
+		ws.next.resize(words);
+		for (int source = 0; source < k; source++) {
+			std::fill(ws.visited.begin(), ws.visited.end(), 0);
+			std::fill(ws.frontier.begin(), ws.frontier.end(), 0);
+			ws.visited[source / bit_matrix_word_bits] = ws.frontier[source / bit_matrix_word_bits] = 1UL << (source % bit_matrix_word_bits);
+			FP_T d = 0.0;
+			bool found = true;
+			while (found) {
+				d += uniform_weight;
+				std::fill(ws.next.begin(), ws.next.end(), 0);
+				for (int i = 0; i < words; i++) {
+					for (unsigned long bits = ws.frontier[i]; bits != 0; bits &= bits - 1) {
+						const unsigned long* row = &ws.rows[(i * bit_matrix_word_bits + lowest_bit(bits)) * words];
+						for (int j = 0; j < words; j++) {
+							ws.next[j] |= row[j];
+						}
+					}
+				}
+				int count = 0;
+				for (int j = 0; j < words; j++) {
+					ws.next[j] &= ~ws.visited[j];
+					ws.visited[j] |= ws.next[j];
+					count += bit_count(ws.next[j]);
+				}
+				sum_e += (FP_T)count / d;
+				found = count > 0;
+				ws.frontier.swap(ws.next);
+			}
+		}
+		return sum_e;
+	}
+	
+	// For dense neighborhoods, the Floyd-Warshall algorithm on a k-by-k matrix
+	// beats repeated heap-based searches
+	int edges = ws.offsets[k];
+	if (k <= dense_limit && 8 * edges > k * k) {
+		ws.distance.assign(k * k, (FP_T)GSL_POSINF);
+		for (int i = 0; i < k; i++) {
+			ws.distance[i * k + i] = 0.0;
+			for (int j = ws.offsets[i]; j < ws.offsets[i + 1]; j++) {
+				if (ws.nodes[j] != i) {
+					ws.distance[i * k + ws.nodes[j]] = ws.weights[j];
+				}
+			}
+		}
+		
+		// A symmetric matrix stays symmetric, so only its upper triangle is
+		// relaxed.  Row m does not change while paths through m are relaxed,
+		// so it is gathered from the upper triangle into a contiguous row.
+		bool symmetric = true;
+		for (int i = 0; i < k && symmetric; i++) {
+			for (int j = i + 1; j < k; j++) {
+				if (ws.distance[i * k + j] != ws.distance[j * k + i]) {
+					symmetric = false;
+					break;
+				}
+			}
+		}
+		if (symmetric) {
+			ws.row.resize(k);
+			FP_T* D_m = &ws.row[0];
+			for (int m = 0; m < k; m++) {
+				for (int j = 0; j < m; j++) {
+					D_m[j] = ws.distance[j * k + m];
+				}
+				for (int j = m; j < k; j++) {
+					D_m[j] = ws.distance[m * k + j];
+				}
+				for (int i = 0; i < k; i++) {
+					FP_T D_i_m = D_m[i];
+					if (i == m || D_i_m == (FP_T)GSL_POSINF) {
+						continue;
+					}
+					relax_row(&ws.distance[i * k], D_m, D_i_m, i + 1, k);
+				}
+			}
+			for (int i = 0; i < k; i++) {
+				for (int j = i + 1; j < k; j++) {
+					FP_T d = ws.distance[i * k + j];
+					if (gsl_isinf(d) == 0 && d > 0.0) {
+						sum_e += 2.0 / d;
+					}
+				}
+			}
+			return sum_e;
+		}
+		for (int m = 0; m < k; m++) {
+			const FP_T* D_m = &ws.distance[m * k];
+			for (int i = 0; i < k; i++) {
+				FP_T D_i_m = ws.distance[i * k + m];
+				if (i == m || D_i_m == (FP_T)GSL_POSINF) {
+					continue;
+				}
+				relax_row(&ws.distance[i * k], D_m, D_i_m, 0, k);
+			}
+		}
+		for (int i = 0; i < k * k; i++) {
+			FP_T d = ws.distance[i];
+			if (gsl_isinf(d) == 0 && d > 0.0) {
+				sum_e += 1.0 / d;
+			}
+		}
+		return sum_e;
+	}
+	
+	ws.distance.resize(k);
+	ws.done.resize(k);
+	for (int source = 0; source < k; source++) {
+		std::fill(ws.distance.begin(), ws.distance.end(), (FP_T)GSL_POSINF);
+		std::fill(ws.done.begin(), ws.done.end(), 0);
+		ws.distance[source] = 0.0;
+		
+		ws.heap.clear();
+		ws.heap.push_back(heap_entry(0.0, source));
+		while (!ws.heap.empty()) {
+			std::pop_heap(ws.heap.begin(), ws.heap.end(), std::greater<heap_entry>());
+			FP_T d = ws.heap.back().first;
+			int v = ws.heap.back().second;
+			ws.heap.pop_back();
+			if (ws.done[v]) {
+				continue;
+			}
+			ws.done[v] = 1;
+			if (v != source) {
+				sum_e += 1.0 / d;
+			}
+			for (int i = ws.offsets[v]; i < ws.offsets[v + 1]; i++) {
+				int w = ws.nodes[i];
+				FP_T d_w = d + ws.weights[i];
+				if (!ws.done[w] && d_w < ws.distance[w]) {
+					ws.distance[w] = d_w;
+					ws.heap.push_back(heap_entry(d_w, w));
+					std::push_heap(ws.heap.begin(), ws.heap.end(), std::greater<heap_entry>());
+				}
+			}
+		}
+	}
+	return sum_e;
+}
+
+/*
+ * Sets D_i[j] to min(D_i[j], D_i_m + D_m[j]) for j from start to end - 1.  The
+ * loop is unrolled so that each group of four elements is loaded before any is
+ * stored, which lets the compiler use vector instructions even though the rows
+ * may overlap.
+ */
+void relax_row(FP_T* D_i, const FP_T* D_m, FP_T D_i_m, int start, int end) {
+	int j = start;
+	for (; j + 4 <= end; j += 4) {
+		FP_T a0 = D_m[j];
+		FP_T a1 = D_m[j + 1];
+		FP_T a2 = D_m[j + 2];
+		FP_T a3 = D_m[j + 3];
+		FP_T b0 = D_i[j];
+		FP_T b1 = D_i[j + 1];
+		FP_T b2 = D_i[j + 2];
+		FP_T b3 = D_i[j + 3];
+		D_i[j] = std::min(b0, D_i_m + a0);
+		D_i[j + 1] = std::min(b1, D_i_m + a1);
+		D_i[j + 2] = std::min(b2, D_i_m + a2);
+		D_i[j + 3] = std::min(b3, D_i_m + a3);
+	}
+	for (; j < end; j++) {
+		D_i[j] = std::min(D_i[j], D_i_m + D_m[j]);
+	}
+}
@@ -1,7 +1,24 @@
 #include <gsl/gsl_math.h>
+#include <vector>
 
 #include "bct.h"
 
+namespace BCT_NAMESPACE {
+	struct erange_workspace {
+		std::vector<int> forward;
+		std::vector<int> backward;
+		std::vector<int> forward_frontier;
+		std::vector<int> backward_frontier;
+		std::vector<int> next;
+		std::vector<int> visited;
+		
+		erange_workspace(int N) : forward(N), backward(N), visited(N) { }
+	};
+	
+	int erange_distance(const adjacency_list* out, const adjacency_list* in, int i, int j, erange_workspace& ws);
+	int erange_expand(const adjacency_list* adj, int skip_from, int skip_to, std::vector<int>& frontier, std::vector<int>& next, std::vector<int>& dist, const std::vector<int>& other);
+}
+
 /*
  * Computes the range for each edge (i.e., the shortest path length between the
  * nodes it connects after the edge has been removed from the graph)
@@ -25,27 +42,39 @@ MATRIX_T* BCT_NAMESPACE::erange(const MATRIX_T* CIJ, FP_T* eta, MATRIX_T** Eshor
 	VECTOR_ID(view) i = MATRIX_ID(column)(find_CIJ_eq_1, 0);
 	VECTOR_ID(view) j = MATRIX_ID(column)(find_CIJ_eq_1, 1);
 	
+	// Rather than cutting each edge and recomputing every distance with
+	// reachdist, search for the shortest path around each edge directly
+	adjacency_list* out = to_adjacency_list(CIJ);
+	MATRIX_T* CIJ_transpose = MATRIX_ID(alloc)(N, N);
+	MATRIX_ID(transpose_memcpy)(CIJ_transpose, CIJ);
+	adjacency_list* in = to_adjacency_list(CIJ_transpose);
+	MATRIX_ID(free)(CIJ_transpose);
+	int edges = length(&i.vector);
+	
 	// for c=1:length(i)
-	for (int c = 0; c < length(&i.vector); c++) {
-		
-		// CIJcut = CIJ;
-		MATRIX_T* CIJcut = copy(CIJ);
-		
-		// CIJcut(i(c),j(c)) = 0;
-		int i_c = (int)VECTOR_ID(get)(&i.vector, c);
-		int j_c = (int)VECTOR_ID(get)(&j.vector, c);
-		MATRIX_ID(set)(CIJcut, i_c, j_c, 0.0);
-		
-		// [R,D] = reachdist(CIJcut);
-		MATRIX_T* D;
-		MATRIX_T* R = reachdist(CIJcut, &D);
-		MATRIX_ID(free)(CIJcut);
-		MATRIX_ID(free)(R);
-		
-		// Erange(i(c),j(c)) = D(i(c),j(c))
-		MATRIX_ID(set)(Erange, i_c, j_c, MATRIX_ID(get)(D, i_c, j_c));
-		MATRIX_ID(free)(D);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+	{
+		erange_workspace ws(N);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+		for (int c = 0; c < edges; c++) {
+			
+			// CIJcut = CIJ;
+			// CIJcut(i(c),j(c)) = 0;
+			// [R,D] = reachdist(CIJcut);
+			int i_c = (int)VECTOR_ID(get)(&i.vector, c);
+			int j_c = (int)VECTOR_ID(get)(&j.vector, c);
+			int d = erange_distance(out, in, i_c, j_c, ws);
+			
+			// Erange(i(c),j(c)) = D(i(c),j(c))
+			MATRIX_ID(set)(Erange, i_c, j_c, (d > 0) ? (FP_T)d : GSL_POSINF);
+		}
 	}
+	adjacency_list_free(out);
+	adjacency_list_free(in);
 	
 	MATRIX_ID(free)(find_CIJ_eq_1);
 	
@@ -73,3 +102,84 @@ MATRIX_T* BCT_NAMESPACE::erange(const MATRIX_T* CIJ, FP_T* eta, MATRIX_T** Eshor
 	if (Eshort != NULL) *Eshort = _Eshort; else MATRIX_ID(free)(_Eshort);
 	return Erange;
 }
+
+/*
+ * Returns the length of the shortest path from i to j that does not use the
+ * edge from i to j, or zero if there is none.  Since reachdist only counts
+ * walks of length two or more once the edge is cut, a loop (i == j) is
+ * measured as the shortest cycle through i that avoids it.
+ *
+ * The search is bidirectional: it grows breadth-first frontiers forward from i
+ * and backward from j, one whole level at a time, always expanding the smaller
+ * frontier, and stops after the first level in which they meet.  Distances are
+ * stored as one more than their value so that zero means unvisited; the
+ * visited list is used to clear them again afterward.
+ */
+int BCT_NAMESPACE::erange_distance(const adjacency_list* out, const adjacency_list* in, int i, int j, erange_workspace& ws) {
+	ws.visited.clear();
+	ws.forward_frontier.clear();
+	ws.backward_frontier.clear();
+	
+	// The forward search starts from the neighbors of i, so that a path of
+	// length at least one is found even if i == j
+	int best = 0;
+	ws.backward[j] = 1;
+	ws.backward_frontier.push_back(j);
+	ws.visited.push_back(j);
+	for (int k = out->offsets[i]; k < out->offsets[i + 1]; k++) {
+		int v = out->nodes[k];
+		if (v == j || ws.forward[v] != 0) {
+			continue;
+		}
+		ws.forward[v] = 2;
+		ws.forward_frontier.push_back(v);
+		ws.visited.push_back(v);
+	}
+	
+	while (best == 0 && !ws.forward_frontier.empty() && !ws.backward_frontier.empty()) {
+		if (ws.forward_frontier.size() <= ws.backward_frontier.size()) {
+			best = erange_expand(out, i, j, ws.forward_frontier, ws.next, ws.forward, ws.backward);
+			ws.visited.insert(ws.visited.end(), ws.forward_frontier.begin(), ws.forward_frontier.end());
+		} else {
+			best = erange_expand(in, j, i, ws.backward_frontier, ws.next, ws.backward, ws.forward);
+			ws.visited.insert(ws.visited.end(), ws.backward_frontier.begin(), ws.backward_frontier.end());
+		}
+	}
+	
+	for (int k = 0; k < (int)ws.visited.size(); k++) {
+		ws.forward[ws.visited[k]] = 0;
+		ws.backward[ws.visited[k]] = 0;
+	}
+	return best;
+}
+
+/*
+ * Expands one level of a breadth-first frontier, skipping the cut edge, and
+ * returns the length of the shortest path found through a node already reached
+ * from the other side, or zero if none was.
+ */
+int BCT_NAMESPACE::erange_expand(const adjacency_list* adj, int skip_from, int skip_to, std::vector<int>& frontier, std::vector<int>& next, std::vector<int>& dist, const std::vector<int>& other) {
+	int best = 0;
+	next.clear();
+	for (int f = 0; f < (int)frontier.size(); f++) {
+		int u = frontier[f];
+		for (int k = adj->offsets[u]; k < adj->offsets[u + 1]; k++) {
+			int v = adj->nodes[k];
+			if (u == skip_from && v == skip_to) {
+				continue;
+			}
+			if (other[v] != 0) {
+				int d = (dist[u] - 1) + 1 + (other[v] - 1);
+				if (best == 0 || d < best) {
+					best = d;
+				}
+			}
+			if (dist[v] == 0) {
+				dist[v] = dist[u] + 1;
+				next.push_back(v);
+			}
+		}
+	}
+	frontier.swap(next);
+	return best;
+}
@@ -1,7 +1,33 @@
-#include <cmath>
+#include <vector>
 
 #include "bct.h"
 
+namespace BCT_NAMESPACE {
+	struct findpaths_state {
+		const adjacency_list* adj;
+		int qmax;
+		std::vector<int> path;
+		std::vector<bool> on_path;
+		std::vector<MATRIX_T*>* Pq;
+		std::vector<FP_T> plq;
+		std::vector<FP_T> ncyc;
+		MATRIX_T* util;
+		int deepest;
+		findpaths_visitor visitor;
+		void* data;
+		
+		findpaths_state(const adjacency_list* adj, int qmax);
+	};
+	
+	adjacency_list* findpaths_adjacency(const MATRIX_T* CIJ);
+	void findpaths_record(findpaths_state& state, int q);
+	void findpaths_search(findpaths_state& state, const VECTOR_T* sources);
+	void findpaths_search_source(findpaths_state& state, int source);
+	void findpaths_extend(findpaths_state& state, int q);
+	MATRIX_T* findpaths_levels(findpaths_state& state, const VECTOR_T* sources);
+	int findpaths_qstop(const findpaths_state& state);
+}
+
 /*
  * Finds paths from a set of source nodes up to a given length.  Note that there
  * is no savepths argument; if all paths are desired, pass a valid pointer as
@@ -10,18 +36,21 @@
  * "filler" value in allpths rather than 0 as in MATLAB.  Pq (the main return),
  * plq, and util are indexed by path length.  They therefore have (qmax + 1)
  * elements and contain no valid data at index 0.
+ *
+ * Paths are stored as a prefix tree (one node and one parent index per path)
+ * only if allpths is requested, in which case they are generated one length at
+ * a time to reproduce the MATLAB column order.  Otherwise they are enumerated
+ * depth-first and only counted, which needs memory proportional to qmax.  Use
+ * findpaths_plq if Pq is not needed either.
  */
 std::vector<MATRIX_T*> BCT_NAMESPACE::findpaths(const MATRIX_T* CIJ, const VECTOR_T* sources, int qmax, VECTOR_T** plq, int* qstop, MATRIX_T** allpths, MATRIX_T** util) {
 	if (safe_mode) check_status(CIJ, SQUARE, "findpaths");
 	
-	// CIJ = double(CIJ~=0);
-	MATRIX_T* _CIJ = compare_elements(CIJ, fp_not_equal, 0.0);
-	
 	// N = size(CIJ,1);
 	int N = CIJ->size1;
 	
-	// pths = [];
-	MATRIX_T* pths = NULL;
+	// CIJ = double(CIJ~=0);
+	adjacency_list* adj = findpaths_adjacency(CIJ);
 	
 	// Pq = zeros(N,N,qmax);
 	std::vector<MATRIX_T*> Pq(qmax + 1);
@@ -31,232 +60,371 @@ std::vector<MATRIX_T*> BCT_NAMESPACE::findpaths(const MATRIX_T* CIJ, const VECTO
 	}
 	
 	// util = zeros(N,qmax);
+	findpaths_state state(adj, qmax);
+	state.Pq = &Pq;
 	if (util != NULL) {
 		*util = zeros(N, qmax + 1);
+		state.util = *util;
 	}
 	
-	// q = 1;
-	int q = 1;
+	// if (savepths==1)
+	if (allpths != NULL) {
+		*allpths = findpaths_levels(state, sources);
+	} else {
+		findpaths_search(state, sources);
+	}
+	adjacency_list_free(adj);
 	
-	VECTOR_T* _CIJ_cols = sequence(0, N - 1);
-	MATRIX_T* _CIJ_idx = ordinal_index(_CIJ, sources, _CIJ_cols);
-	VECTOR_ID(free)(_CIJ_cols);
-	MATRIX_T* _CIJ_idx_ij = find_ij(_CIJ_idx);
-	MATRIX_ID(free)(_CIJ_idx);
-	pths = MATRIX_ID(alloc)(2, _CIJ_idx_ij->size1);
-	for (int i = 0; i < (int)_CIJ_idx_ij->size1; i++) {
-		int i_row = (int)MATRIX_ID(get)(_CIJ_idx_ij, i, 0);
-		int i_start = (int)VECTOR_ID(get)(sources, i_row);
-		int i_end = (int)MATRIX_ID(get)(_CIJ_idx_ij, i, 1);
-		MATRIX_ID(set)(pths, 0, i, (FP_T)i_start);
-		MATRIX_ID(set)(pths, 1, i, (FP_T)i_end);
+	// qstop = q;
+	if (qstop != NULL) {
+		*qstop = findpaths_qstop(state);
 	}
-	MATRIX_ID(free)(_CIJ_idx_ij);
 	
-	// util(1:N,q) = util(1:N,q)+hist(reshape(pths,1,size(pths,1)*size(pths,2)),1:N)';
+	// tpath = sum(sum(sum(Pq)));
+	// plq = reshape(sum(sum(Pq)),1,qmax)
+	if (plq != NULL) {
+		*plq = VECTOR_ID(alloc)(qmax + 1);
+		for (int i = 0; i <= qmax; i++) {
+			VECTOR_ID(set)(*plq, i, state.plq[i]);
+		}
+	}
+	
+	return Pq;
+}
+
+/*
+ * Counts paths from a set of source nodes up to a given length, returning plq
+ * as findpaths does but without allocating the qmax N x N matrices of Pq or
+ * storing any paths.  If ncyc is given, it is set to the number of cycles of
+ * each length (the trace of each matrix of Pq).  With OpenMP, sources are
+ * searched in parallel.
+ */
+VECTOR_T* BCT_NAMESPACE::findpaths_plq(const MATRIX_T* CIJ, const VECTOR_T* sources, int qmax, int* qstop, MATRIX_T** util, VECTOR_T** ncyc) {
+	if (safe_mode) check_status(CIJ, SQUARE, "findpaths_plq");
+	int N = CIJ->size1;
+	adjacency_list* adj = findpaths_adjacency(CIJ);
+	findpaths_state state(adj, qmax);
 	if (util != NULL) {
-		VECTOR_T* reshape_pths = to_vector(pths);
-		VECTOR_T* centers = sequence(0, N - 1);
-		VECTOR_T* hist_reshape_pths = hist(reshape_pths, centers);
-		VECTOR_ID(free)(reshape_pths);
-		VECTOR_ID(free)(centers);
-		VECTOR_ID(view) util_col_q = MATRIX_ID(column)(*util, q);
-		VECTOR_ID(add)(&util_col_q.vector, hist_reshape_pths);
-		VECTOR_ID(free)(hist_reshape_pths);
+		*util = zeros(N, qmax + 1);
+		state.util = *util;
 	}
+	findpaths_search(state, sources);
+	adjacency_list_free(adj);
+	if (qstop != NULL) {
+		*qstop = findpaths_qstop(state);
+	}
+	VECTOR_T* plq = VECTOR_ID(alloc)(qmax + 1);
+	for (int i = 0; i <= qmax; i++) {
+		VECTOR_ID(set)(plq, i, state.plq[i]);
+	}
+	if (ncyc != NULL) {
+		*ncyc = VECTOR_ID(alloc)(qmax + 1);
+		for (int i = 0; i <= qmax; i++) {
+			VECTOR_ID(set)(*ncyc, i, state.ncyc[i]);
+		}
+	}
+	return plq;
+}
+
+/*
+ * Passes every path found by findpaths to a visitor instead of storing it.  The
+ * visitor receives the nodes of a path of length q as an array of (q + 1)
+ * elements, which is only valid during the call.  Paths are visited in
+ * depth-first order rather than the order of allpths.  Returns qstop.
+ */
+int BCT_NAMESPACE::findpaths_stream(const MATRIX_T* CIJ, const VECTOR_T* sources, int qmax, findpaths_visitor visitor, void* data) {
+	if (safe_mode) check_status(CIJ, SQUARE, "findpaths_stream");
+	adjacency_list* adj = findpaths_adjacency(CIJ);
+	findpaths_state state(adj, qmax);
+	state.visitor = visitor;
+	state.data = data;
+	findpaths_search(state, sources);
+	adjacency_list_free(adj);
+	return findpaths_qstop(state);
+}
+
+BCT_NAMESPACE::findpaths_state::findpaths_state(const adjacency_list* adj, int qmax) :
+		adj(adj), qmax(qmax), path(qmax + 1), on_path(adj->size, false), Pq(NULL), plq(qmax + 1, 0.0),
+		ncyc(qmax + 1, 0.0), util(NULL), deepest(0), visitor(NULL), data(NULL) { }
+
+/*
+ * Returns an adjacency list for the binary version of a connection matrix.
+ */
+BCT_NAMESPACE::adjacency_list* BCT_NAMESPACE::findpaths_adjacency(const MATRIX_T* CIJ) {
+	MATRIX_T* _CIJ = compare_elements(CIJ, fp_not_equal, 0.0);
+	adjacency_list* adj = to_adjacency_list(_CIJ);
+	MATRIX_ID(free)(_CIJ);
+	return adj;
+}
+
+/*
+ * Adds the path of length q in state.path to the counts.
+ */
+void BCT_NAMESPACE::findpaths_record(findpaths_state& state, int q) {
+	int i = state.path[0];
+	int j = state.path[q];
 	
-	// for np=1:size(pths,2)
-	for (int np = 0; np < (int)pths->size2; np++) {
-		
-		// Pq(pths(1,np),pths(q+1,np),q) = Pq(pths(1,np),pths(q+1,np),q) + 1;
-		int i = (int)MATRIX_ID(get)(pths, 0, np);
-		int j = (int)MATRIX_ID(get)(pths, q, np);
-		MATRIX_ID(set)(Pq[q], i, j, MATRIX_ID(get)(Pq[q], i, j) + 1.0);
+	// Pq(pths(1,np),pths(q+1,np),q) = Pq(pths(1,np),pths(q+1,np),q) + 1;
+	if (state.Pq != NULL) {
+		MATRIX_T* Pq_q = (*state.Pq)[q];
+		MATRIX_ID(set)(Pq_q, i, j, MATRIX_ID(get)(Pq_q, i, j) + 1.0);
+	}
+	state.plq[q] += 1.0;
+	if (i == j) {
+		state.ncyc[q] += 1.0;
 	}
 	
-	// if (savepths==1)
-	if (allpths != NULL) {
-		
-		// allpths = pths;
-		*allpths = copy(pths);
+	// util(1:N,q) = util(1:N,q) + hist(reshape(npths,1,size(npths,1)*size(npths,2)),1:N)' - diag(Pq(:,:,q));
+	if (state.util != NULL) {
+		for (int k = 0; k <= q; k++) {
+			int node = state.path[k];
+			MATRIX_ID(set)(state.util, node, q, MATRIX_ID(get)(state.util, node, q) + 1.0);
+		}
+		if (q > 1 && i == j) {
+			MATRIX_ID(set)(state.util, i, q, MATRIX_ID(get)(state.util, i, q) - 1.0);
+		}
+	}
+	
+	// pths = npths(:,npths(1,:)~=npths(q+1,:));
+	if ((q == 1 || i != j) && q > state.deepest) {
+		state.deepest = q;
+	}
+	
+	if (state.visitor != NULL) {
+		state.visitor(&state.path[0], q, state.data);
+	}
+}
+
+/*
+ * Enumerates paths depth-first from each source.  If only counts are needed,
+ * sources are searched in parallel with separate counts that are then summed.
+ */
+void BCT_NAMESPACE::findpaths_search(findpaths_state& state, const VECTOR_T* sources) {
+	if (state.qmax < 1) {
+		return;
+	}
+	int n_sources = sources->size;
+#ifdef _OPENMP
+	if (state.Pq == NULL && state.visitor == NULL && n_sources > 1) {
+#pragma omp parallel
+		{
+			findpaths_state local(state.adj, state.qmax);
+			if (state.util != NULL) {
+				local.util = zeros(state.util->size1, state.util->size2);
+			}
+#pragma omp for schedule(dynamic)
+			for (int s = 0; s < n_sources; s++) {
+				findpaths_search_source(local, (int)VECTOR_ID(get)(sources, s));
+			}
+#pragma omp critical
+			{
+				for (int q = 0; q <= state.qmax; q++) {
+					state.plq[q] += local.plq[q];
+					state.ncyc[q] += local.ncyc[q];
+				}
+				if (local.deepest > state.deepest) {
+					state.deepest = local.deepest;
+				}
+				if (state.util != NULL) {
+					MATRIX_ID(add)(state.util, local.util);
+				}
+			}
+			if (local.util != NULL) {
+				MATRIX_ID(free)(local.util);
+			}
+		}
+		return;
+	}
+#endif
+	for (int s = 0; s < n_sources; s++) {
+		findpaths_search_source(state, (int)VECTOR_ID(get)(sources, s));
+	}
+}
+
+/*
+ * Enumerates paths depth-first from one source.  Paths of length one are
+ * extended even if they are loops, as in the MATLAB version.
+ */
+void BCT_NAMESPACE::findpaths_search_source(findpaths_state& state, int source) {
+	const adjacency_list* adj = state.adj;
+	int i = source;
+	state.path[0] = i;
+	for (int k = adj->offsets[i]; k < adj->offsets[i + 1]; k++) {
+		int j = adj->nodes[k];
+		state.path[1] = j;
+		findpaths_record(state, 1);
+		if (state.qmax > 1) {
+			state.on_path[j] = true;
+			findpaths_extend(state, 1);
+			state.on_path[j] = false;
+		}
+	}
+}
+
+/*
+ * Extends the path of length q in state.path by every neighbor of its last node
+ * that is not already on the path (except at the start, which closes a cycle).
+ * Cycles are counted but not extended further.
+ */
+void BCT_NAMESPACE::findpaths_extend(findpaths_state& state, int q) {
+	const adjacency_list* adj = state.adj;
+	int i = state.path[q];
+	
+	// pb_temp = pb(sum(j==pths(2:q,pb),1)==0);
+	for (int k = adj->offsets[i]; k < adj->offsets[i + 1]; k++) {
+		int j = adj->nodes[k];
+		if (state.on_path[j]) {
+			continue;
+		}
+		state.path[q + 1] = j;
+		findpaths_record(state, q + 1);
+		if (j != state.path[0] && q + 1 < state.qmax) {
+			state.on_path[j] = true;
+			findpaths_extend(state, q + 1);
+			state.on_path[j] = false;
+		}
+	}
+}
+
+/*
+ * Enumerates paths one length at a time, in the same order as the MATLAB
+ * version, and returns allpths.  Each path is stored in a prefix tree as its
+ * last node and the index of the path it extends.
+ */
+MATRIX_T* BCT_NAMESPACE::findpaths_levels(findpaths_state& state, const VECTOR_T* sources) {
+	const adjacency_list* adj = state.adj;
+	int N = adj->size;
+	int n_sources = sources->size;
+	std::vector<int> node;
+	std::vector<int> parent;
+	
+	// [i,j] = find(CIJ(sources,:)); pths = [sources(i); j];
+	// Roots (the sources) come first, followed by the paths of length one
+	std::vector<int> first_start(N + 1, 0);
+	for (int s = 0; s < n_sources; s++) {
+		int i = (int)VECTOR_ID(get)(sources, s);
+		for (int k = adj->offsets[i]; k < adj->offsets[i + 1]; k++) {
+			first_start[adj->nodes[k] + 1]++;
+		}
+	}
+	for (int j = 0; j < N; j++) {
+		first_start[j + 1] += first_start[j];
+	}
+	int n_first = first_start[N];
+	std::vector<int> first_node(n_first);
+	std::vector<int> first_source(n_first);
+	std::vector<int> position(first_start.begin(), first_start.end() - 1);
+	for (int s = 0; s < n_sources; s++) {
+		int i = (int)VECTOR_ID(get)(sources, s);
+		for (int k = adj->offsets[i]; k < adj->offsets[i + 1]; k++) {
+			int j = adj->nodes[k];
+			first_source[position[j]] = i;
+			first_node[position[j]] = j;
+			position[j]++;
+		}
+	}
+	for (int p = 0; p < n_first; p++) {
+		node.push_back(first_source[p]);
+		parent.push_back(-1);
+	}
+	std::vector<int> level_start(1, n_first);
+	std::vector<int> pths;
+	for (int p = 0; p < n_first; p++) {
+		node.push_back(first_node[p]);
+		parent.push_back(p);
+		pths.push_back(n_first + p);
+		state.path[0] = first_source[p];
+		state.path[1] = first_node[p];
+		findpaths_record(state, 1);
 	}
 	
 	// for q=2:qmax
-	for (q = 2; q <= qmax; q++) {
-		
-		// npths = zeros(q+1,len_npths);
-		// Handle as a std::vector<VECTOR_T*> rather than preallocating a MATRIX_T*
-		std::vector<VECTOR_T*> npths_v;
+	for (int q = 2; q <= state.qmax && !pths.empty(); q++) {
+		level_start.push_back(node.size());
 		
 		// endp = unique(pths(q,:));
-		VECTOR_ID(view) pths_row_q_sub_1 = MATRIX_ID(row)(pths, q - 1);
-		VECTOR_T* endp = unique(&pths_row_q_sub_1.vector);
-		
-		// npthscnt = 0;
-		int npthscnt = 0;
+		// [pa,pb] = find(pths(q,:) == i);
+		std::vector<int> bucket_start(N + 1, 0);
+		for (int p = 0; p < (int)pths.size(); p++) {
+			bucket_start[node[pths[p]] + 1]++;
+		}
+		for (int i = 0; i < N; i++) {
+			bucket_start[i + 1] += bucket_start[i];
+		}
+		std::vector<int> pb(pths.size());
+		position.assign(bucket_start.begin(), bucket_start.end() - 1);
+		for (int p = 0; p < (int)pths.size(); p++) {
+			pb[position[node[pths[p]]]++] = pths[p];
+		}
 		
 		// for ii=1:length(endp)
-		for (int ii = 0; ii < length(endp); ii++) {
-			
-			// i = endp(ii);
-			int i = (int)VECTOR_ID(get)(endp, ii);
+		std::vector<int> npths;
+		for (int i = 0; i < N; i++) {
+			if (bucket_start[i] == bucket_start[i + 1]) {
+				continue;
+			}
 			
-			// [pa,pb] = find(pths(q,:) == i);
-			VECTOR_T* pths_row_q_sub_1_eq_i = compare_elements(&pths_row_q_sub_1.vector, fp_equal, (FP_T)i);
-			VECTOR_T* pb = find(pths_row_q_sub_1_eq_i);
-			VECTOR_ID(free)(pths_row_q_sub_1_eq_i);
-			if (pb != NULL) {
-				
-				// nendp = find(CIJ(i,:)==1);
-				VECTOR_ID(const_view) _CIJ_row_i = MATRIX_ID(const_row)(_CIJ, i);
-				VECTOR_T* _CIJ_row_i_eq_1 = compare_elements(&_CIJ_row_i.vector, fp_equal, 1.0);
-				VECTOR_T* nendp = find(_CIJ_row_i_eq_1);
-				VECTOR_ID(free)(_CIJ_row_i_eq_1);
-				
-				// if (~isempty(nendp))
-				if (nendp != NULL) {
+			// nendp = find(CIJ(i,:)==1);
+			for (int k = adj->offsets[i]; k < adj->offsets[i + 1]; k++) {
+				int j = adj->nodes[k];
+				for (int b = bucket_start[i]; b < bucket_start[i + 1]; b++) {
 					
-					// for jj=1:length(nendp)
-					for (int jj = 0; jj < length(nendp); jj++) {
-						
-						// j = nendp(jj);
-						int j = (int)VECTOR_ID(get)(nendp, jj);
-						
-						// pb_temp = pb(sum(j==pths(2:q,pb),1)==0);
-						VECTOR_T* pths_rows = sequence(1, q - 1);
-						MATRIX_T* pths_idx = ordinal_index(pths, pths_rows, pb);
-						VECTOR_ID(free)(pths_rows);
-						MATRIX_T* pths_idx_eq_j = compare_elements(pths_idx, fp_equal, (FP_T)j);
-						MATRIX_ID(free)(pths_idx);
-						VECTOR_T* sum_pths_idx_eq_j = sum(pths_idx_eq_j, 1);
-						MATRIX_ID(free)(pths_idx_eq_j);
-						VECTOR_T* sum_pths_idx_eq_j_eq_0 = compare_elements(sum_pths_idx_eq_j, fp_equal, 0.0);
-						VECTOR_ID(free)(sum_pths_idx_eq_j);
-						VECTOR_T* pb_temp = logical_index(pb, sum_pths_idx_eq_j_eq_0);
-						VECTOR_ID(free)(sum_pths_idx_eq_j_eq_0);
-						if (pb_temp != NULL) {
-						
-							// npths(:,npthscnt+1:npthscnt+length(pb_temp)) = [pths(:,pb_temp)' ones(length(pb_temp),1)*j]';
-							pths_rows = sequence(0, pths->size1 - 1);
-							pths_idx = ordinal_index(pths, pths_rows, pb_temp);
-							VECTOR_ID(free)(pths_rows);
-							MATRIX_T* temp = MATRIX_ID(alloc)(pths_idx->size1 + 1, pths_idx->size2);
-							MATRIX_ID(view) temp_subm = MATRIX_ID(submatrix)(temp, 0, 0, pths_idx->size1, pths_idx->size2);
-							MATRIX_ID(memcpy)(&temp_subm.matrix, pths_idx);
-							MATRIX_ID(free)(pths_idx);
-							pths_idx = temp;
-							VECTOR_T* last_row = VECTOR_ID(alloc)(length(pb_temp));
-							VECTOR_ID(set_all)(last_row, (FP_T)j);
-							MATRIX_ID(set_row)(pths_idx, pths_idx->size1 - 1, last_row);
-							VECTOR_ID(free)(last_row);
-							for (int i = 0; i < length(pb_temp); i++) {
-								npths_v.push_back(zeros_vector(q + 1));
-								VECTOR_ID(view) pths_idx_col_i = MATRIX_ID(column)(pths_idx, i);
-								VECTOR_ID(view) npths_v_i_subv = VECTOR_ID(subvector)(npths_v[npthscnt + i], 0, pths_idx->size1);
-								VECTOR_ID(memcpy)(&npths_v_i_subv.vector, &pths_idx_col_i.vector);
-							}
-							MATRIX_ID(free)(pths_idx);
-							
-							// npthscnt = npthscnt+length(pb_temp);
-							npthscnt += length(pb_temp);
-							
-							// Pq(1:N,j,q) = Pq(1:N,j,q)+(hist(pths(1,pb_temp),1:N))';
-							VECTOR_ID(view) pths_row_0 = MATRIX_ID(row)(pths, 0);
-							VECTOR_T* pths_row_0_idx = ordinal_index(&pths_row_0.vector, pb_temp);
-							VECTOR_ID(free)(pb_temp);
-							VECTOR_T* centers = sequence(0, N - 1);
-							VECTOR_T* hist_pths_idx = hist(pths_row_0_idx, centers);
-							VECTOR_ID(free)(pths_row_0_idx);
-							VECTOR_ID(free)(centers);
-							VECTOR_ID(view) Pq_q_col_j = MATRIX_ID(column)(Pq[q], j);
-							VECTOR_ID(add)(&Pq_q_col_j.vector, hist_pths_idx);
-							VECTOR_ID(free)(hist_pths_idx);
-						}
+					// pb_temp = pb(sum(j==pths(2:q,pb),1)==0);
+					int p = pb[b];
+					for (int d = q - 1; d >= 0; d--) {
+						state.path[d] = node[p];
+						p = parent[p];
+					}
+					bool on_path = false;
+					for (int d = 1; d < q && !on_path; d++) {
+						on_path = state.path[d] == j;
+					}
+					if (on_path) {
+						continue;
 					}
 					
-					VECTOR_ID(free)(nendp);
+					// npths(:,npthscnt+1:npthscnt+length(pb_temp)) = [pths(:,pb_temp)' ones(length(pb_temp),1)*j]';
+					state.path[q] = j;
+					node.push_back(j);
+					parent.push_back(pb[b]);
+					findpaths_record(state, q);
+					
+					// pths = npths(:,npths(1,:)~=npths(q+1,:));
+					if (state.path[0] != j) {
+						npths.push_back(node.size() - 1);
+					}
 				}
-				
-				VECTOR_ID(free)(pb);
 			}
 		}
-		
-		VECTOR_ID(free)(endp);
-		MATRIX_T* npths = MATRIX_ID(alloc)(q + 1, npthscnt);
-		for (int i = 0; i < npthscnt; i++) {
-			MATRIX_ID(set_col)(npths, i, npths_v[i]);
-			VECTOR_ID(free)(npths_v[i]);
-		}
-		
-		// if (savepths==1)
-		if (allpths != NULL) {
-			
-			// allpths = [allpths; zeros(1,size(allpths,2))];
-			// allpths = [allpths npths(:,1:npthscnt)];
-			MATRIX_T* temp = MATRIX_ID(alloc)((*allpths)->size1 + 1, (*allpths)->size2 + npthscnt);
-			MATRIX_ID(set_all)(temp, -1.0);
-			MATRIX_ID(view) temp_subm = MATRIX_ID(submatrix)(temp, 0, 0, (*allpths)->size1, (*allpths)->size2);
-			MATRIX_ID(memcpy)(&temp_subm.matrix, *allpths);
-			temp_subm = MATRIX_ID(submatrix)(temp, 0, (*allpths)->size2, (*allpths)->size1 + 1, npthscnt);
-			MATRIX_ID(view) npths_subm = MATRIX_ID(submatrix)(npths, 0, 0, npths->size1, npthscnt);
-			MATRIX_ID(memcpy)(&temp_subm.matrix, &npths_subm.matrix);
-			MATRIX_ID(free)(*allpths);
-			*allpths = temp;
-		}
-		
-		// util(1:N,q) = util(1:N,q) + hist(reshape(npths,1,size(npths,1)*size(npths,2)),1:N)' - diag(Pq(:,:,q));
-		if (util != NULL) {
-			VECTOR_T* reshape_npths = to_vector(npths);
-			VECTOR_T* centers = sequence(0, N - 1);
-			VECTOR_T* hist_reshape_npths = hist(reshape_npths, centers);
-			VECTOR_ID(free)(reshape_npths);
-			VECTOR_ID(free)(centers);
-			VECTOR_ID(view) util_col_q = MATRIX_ID(column)(*util, q);
-			VECTOR_ID(add)(&util_col_q.vector, hist_reshape_npths);
-			VECTOR_ID(free)(hist_reshape_npths);
-			VECTOR_ID(view) diag_Pq_q = MATRIX_ID(diagonal)(Pq[q]);
-			VECTOR_ID(sub)(&util_col_q.vector, &diag_Pq_q.vector);
-		}
-		
-		// pths = npths(:,npths(1,:)~=npths(q+1,:));
-		VECTOR_T* npths_rows = sequence(0, npths->size1 - 1);
-		VECTOR_ID(view) npths_row_0 = MATRIX_ID(row)(npths, 0);
-		VECTOR_ID(view) npths_row_q = MATRIX_ID(row)(npths, q);
-		VECTOR_T* npths_cols = compare_elements(&npths_row_0.vector, fp_not_equal, &npths_row_q.vector);
-		MATRIX_ID(free)(pths);
-		pths = ord_log_index(npths, npths_rows, npths_cols);
-		MATRIX_ID(free)(npths);
-		VECTOR_ID(free)(npths_rows);
-		VECTOR_ID(free)(npths_cols);
-		
-		// if (isempty(pths))
-		// ...
-		if (pths == NULL) {
-			break;
-		}
+		pths.swap(npths);
 	}
+	level_start.push_back(node.size());
 	
-	MATRIX_ID(free)(_CIJ);
-	if (pths != NULL) {
-		MATRIX_ID(free)(pths);
-	}
-	
-	// qstop = q;
-	if (qstop != NULL) {
-		*qstop = (q <= qmax) ? q : qmax;
-	}
-	
-	// tpath = sum(sum(sum(Pq)));
-	// plq = reshape(sum(sum(Pq)),1,qmax)
-	if (plq != NULL) {
-		*plq = VECTOR_ID(alloc)(qmax + 1);
-		VECTOR_ID(set)(*plq, 0, 0.0);
-		for (int i = 1; i <= qmax; i++) {
-			VECTOR_T* sum_Pq_i = sum(Pq[i]);
-			VECTOR_ID(set)(*plq, i, sum(sum_Pq_i));
-			VECTOR_ID(free)(sum_Pq_i);
+	// allpths = [allpths; zeros(1,size(allpths,2))];
+	// allpths = [allpths npths(:,1:npthscnt)];
+	int rows = level_start.size();
+	MATRIX_T* allpths = MATRIX_ID(alloc)(rows, node.size() - n_first);
+	MATRIX_ID(set_all)(allpths, -1.0);
+	for (int q = 1; q < rows; q++) {
+		for (int c = level_start[q - 1]; c < level_start[q]; c++) {
+			int p = c;
+			for (int d = q; d >= 0; d--) {
+				MATRIX_ID(set)(allpths, d, c - n_first, (FP_T)node[p]);
+				p = parent[p];
+			}
 		}
 	}
+	return allpths;
+}
+
+/*
+ * Returns the length at which path enumeration stopped: one more than the
+ * longest path that could still be extended, but no more than qmax.
+ */
+int BCT_NAMESPACE::findpaths_qstop(const findpaths_state& state) {
 	
-	return Pq;
+	// if (isempty(pths))
+	// ...
+	int q = ((state.deepest > 1) ? state.deepest : 1) + 1;
+	return (q <= state.qmax) ? q : state.qmax;
 }
@@ -1,15 +1,60 @@
+#include <cmath>
+#include <limits>
+#include <vector>
+
 #include "bct.h"
 
+/*
+ * Walk counts are propagated a block of start vectors at a time over an
+ * adjacency list (a sparse-times-dense product), which costs O(q * edges) per
+ * vector instead of O(N^3) per dense matrix power.  Counts are kept as exact
+ * integers (128-bit where the compiler supports it) until the next step could
+ * overflow, after which each vector is kept as long double values with a shared
+ * power-of-two scale, so that counts far beyond the range of FP_T can still be
+ * returned as logarithms.
+ */
+namespace BCT_NAMESPACE {
+#ifdef __SIZEOF_INT128__
+	__extension__ typedef unsigned __int128 walk_count;
+#else
+	typedef unsigned long long walk_count;
+#endif
+	
+	struct walk_block {
+		const adjacency_list* adj;
+		int width;
+		walk_count limit;
+		bool exact;
+		std::vector<walk_count> count;
+		std::vector<walk_count> next_count;
+		std::vector<walk_count> total;
+		std::vector<long double> scaled;
+		std::vector<long double> next_scaled;
+		std::vector<int> scale;
+		
+		walk_block(const adjacency_list* adj, int width);
+	};
+	
+	const int walk_block_width = 16;
+	
+	adjacency_list* findwalks_adjacency(const MATRIX_T* CIJ);
+	void walk_block_start(walk_block& block, int first, int count);
+	void walk_block_step(walk_block& block);
+	FP_T walk_block_value(const walk_block& block, int node, int column, bool log_scale);
+	FP_T walk_block_total(const walk_block& block, int column, bool log_scale);
+}
+
 /*
  * Finds walks.  Note that there is no twalk argument as its value may overflow
  * a C++ long.  Wq (the main return) and wlq are indexed by path length.  They
- * therefore contain no valid data at index 0.
+ * therefore contain no valid data at index 0.  Use findwalks_wlq if only wlq or
+ * the diagonals of Wq are needed.
  */
 std::vector<MATRIX_T*> BCT_NAMESPACE::findwalks(const MATRIX_T* CIJ, VECTOR_T** wlq) {
 	if (safe_mode) check_status(CIJ, SQUARE, "findwalks");
 	
 	// CIJ = double(CIJ~=0);
-	MATRIX_T* _CIJ = compare_elements(CIJ, fp_not_equal, 0.0);
+	adjacency_list* adj = findwalks_adjacency(CIJ);
 	
 	// N = size(CIJ,1);
 	int N = CIJ->size1;
@@ -18,41 +63,287 @@ std::vector<MATRIX_T*> BCT_NAMESPACE::findwalks(const MATRIX_T* CIJ, VECTOR_T**
 	std::vector<MATRIX_T*> Wq(N + 1);
 	Wq[0] = NULL;
 	for (int i = 1; i <= N; i++) {
-		Wq[i] = zeros(N, N);
+		Wq[i] = MATRIX_ID(alloc)(N, N);
 	}
 	
-	// CIJpwr = CIJ;
-	MATRIX_T* _CIJpwr = copy(_CIJ);
-	
-	// Wq(:,:,1) = CIJ;
-	Wq[1] = copy(_CIJ);
-	
 	// for q=2:N
-	for (int q = 2; q <= N; q++) {
-		
-		// CIJpwr = CIJpwr*CIJ;
-		MATRIX_T* temp = mul(_CIJpwr, _CIJ);
-		MATRIX_ID(free)(_CIJpwr);
-		_CIJpwr = temp;
-		
-		// Wq(:,:,q) = CIJpwr;
-		Wq[q] = copy(_CIJpwr);
+	//     CIJpwr = CIJpwr*CIJ;
+	//     Wq(:,:,q) = CIJpwr;
+	// Row i of Wq(:,:,q) counts the walks of length q that start at node i
+	int blocks = (N + walk_block_width - 1) / walk_block_width;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+	{
+		walk_block block(adj, walk_block_width);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+		for (int k = 0; k < blocks; k++) {
+			int first = k * walk_block_width;
+			int count = (first + walk_block_width <= N) ? walk_block_width : N - first;
+			walk_block_start(block, first, count);
+			for (int q = 1; q <= N; q++) {
+				walk_block_step(block);
+				for (int b = 0; b < count; b++) {
+					for (int j = 0; j < N; j++) {
+						MATRIX_ID(set)(Wq[q], first + b, j, walk_block_value(block, j, b, false));
+					}
+				}
+			}
+		}
 	}
 	
-	MATRIX_ID(free)(_CIJ);
-	MATRIX_ID(free)(_CIJpwr);
-	
 	// twalk = sum(sum(sum(Wq)));
 	// wlq = reshape(sum(sum(Wq)),1,N);
 	if (wlq != NULL) {
 		*wlq = VECTOR_ID(alloc)(N + 1);
 		VECTOR_ID(set)(*wlq, 0, 0.0);
-		for (int i = 1; i <= N; i++) {
-			VECTOR_T* sum_Wq_i = sum(Wq[i]);
-			VECTOR_ID(set)(*wlq, i, sum(sum_Wq_i));
-			VECTOR_ID(free)(sum_Wq_i);
+		walk_block block(adj, 1);
+		walk_block_start(block, -1, 1);
+		for (int q = 1; q <= N; q++) {
+			walk_block_step(block);
+			VECTOR_ID(set)(*wlq, q, walk_block_total(block, 0, false));
 		}
 	}
 	
+	adjacency_list_free(adj);
 	return Wq;
 }
+
+/*
+ * Counts walks up to length qmax without computing the matrices of findwalks.
+ * Returns wlq, the total number of walks of each length.  If Wq_diag is given,
+ * it is set to an N x (qmax + 1) matrix whose (i,q) element is the number of
+ * closed walks of length q through node i (the diagonal of Wq(:,:,q)).  Both
+ * are indexed by length and contain no valid data at index 0.
+ *
+ * Counts are accumulated exactly as long as they fit in a 128-bit integer.  If
+ * log_scale is true, natural logarithms of the counts are returned instead of
+ * the counts themselves (-Inf for zero), which remain finite for lengths at
+ * which the counts would overflow FP_T.
+ */
+VECTOR_T* BCT_NAMESPACE::findwalks_wlq(const MATRIX_T* CIJ, int qmax, MATRIX_T** Wq_diag, bool log_scale) {
+	if (safe_mode) check_status(CIJ, SQUARE, "findwalks_wlq");
+	adjacency_list* adj = findwalks_adjacency(CIJ);
+	int N = CIJ->size1;
+	
+	// Summing walks over all start nodes is the same as starting from ones
+	VECTOR_T* wlq = zeros_vector(qmax + 1);
+	walk_block block(adj, 1);
+	walk_block_start(block, -1, 1);
+	for (int q = 1; q <= qmax; q++) {
+		walk_block_step(block);
+		VECTOR_ID(set)(wlq, q, walk_block_total(block, 0, log_scale));
+	}
+	
+	if (Wq_diag != NULL) {
+		*Wq_diag = zeros(N, qmax + 1);
+		int blocks = (N + walk_block_width - 1) / walk_block_width;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+		{
+			walk_block block(adj, walk_block_width);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+			for (int k = 0; k < blocks; k++) {
+				int first = k * walk_block_width;
+				int count = (first + walk_block_width <= N) ? walk_block_width : N - first;
+				walk_block_start(block, first, count);
+				for (int q = 1; q <= qmax; q++) {
+					walk_block_step(block);
+					for (int b = 0; b < count; b++) {
+						MATRIX_ID(set)(*Wq_diag, first + b, q, walk_block_value(block, first + b, b, log_scale));
+					}
+				}
+			}
+		}
+	}
+	
+	adjacency_list_free(adj);
+	return wlq;
+}
+
+/*
+ * Returns an adjacency list for the binary version of a connection matrix.
+ */
+BCT_NAMESPACE::adjacency_list* BCT_NAMESPACE::findwalks_adjacency(const MATRIX_T* CIJ) {
+	MATRIX_T* _CIJ = compare_elements(CIJ, fp_not_equal, 0.0);
+	adjacency_list* adj = to_adjacency_list(_CIJ);
+	MATRIX_ID(free)(_CIJ);
+	return adj;
+}
+
+/*
+ * Allocates a block of the given number of walk count vectors.  The limit is
+ * the largest column total for which another step cannot overflow: no count
+ * can exceed its column total, and a total grows at most by a factor of the
+ * largest out-degree.
+ */
+BCT_NAMESPACE::walk_block::walk_block(const adjacency_list* adj, int width) :
+		adj(adj), width(width), count(adj->size * width), next_count(adj->size * width), total(width),
+		scaled(adj->size * width), next_scaled(adj->size * width), scale(width) {
+	int max_degree = 1;
+	for (int i = 0; i < adj->size; i++) {
+		int degree = adj->offsets[i + 1] - adj->offsets[i];
+		if (degree > max_degree) {
+			max_degree = degree;
+		}
+	}
+	limit = ~(walk_count)0 / (walk_count)max_degree;
+}
+
+/*
+ * Starts the walks of each column at a single node (column b at node first + b,
+ * for the first count columns), or at every node if first is -1.
+ */
+void BCT_NAMESPACE::walk_block_start(walk_block& block, int first, int count) {
+	int N = block.adj->size;
+	int width = block.width;
+	block.exact = true;
+	for (int i = 0; i < N * width; i++) {
+		block.count[i] = 0;
+	}
+	for (int b = 0; b < width; b++) {
+		block.total[b] = 0;
+		block.scale[b] = 0;
+	}
+	if (first == -1) {
+		for (int i = 0; i < N; i++) {
+			block.count[i * width] = 1;
+		}
+		block.total[0] = N;
+	} else {
+		for (int b = 0; b < count; b++) {
+			block.count[(first + b) * width + b] = 1;
+			block.total[b] = 1;
+		}
+	}
+}
+
+/*
+ * Extends every walk in the block by one edge.
+ */
+void BCT_NAMESPACE::walk_block_step(walk_block& block) {
+	const adjacency_list* adj = block.adj;
+	int N = adj->size;
+	int width = block.width;
+	if (block.exact) {
+		for (int b = 0; b < width && block.exact; b++) {
+			block.exact = block.total[b] <= block.limit;
+		}
+		if (!block.exact) {
+			for (int i = 0; i < N * width; i++) {
+				block.scaled[i] = (long double)block.count[i];
+			}
+		}
+	}
+	
+	// CIJpwr = CIJpwr*CIJ;
+	if (block.exact) {
+		std::vector<walk_count>& next = block.next_count;
+		for (int i = 0; i < N * width; i++) {
+			next[i] = 0;
+		}
+		for (int i = 0; i < N; i++) {
+			const walk_count* from = &block.count[i * width];
+			for (int k = adj->offsets[i]; k < adj->offsets[i + 1]; k++) {
+				walk_count* to = &next[adj->nodes[k] * width];
+				for (int b = 0; b < width; b++) {
+					to[b] += from[b];
+				}
+			}
+		}
+		block.count.swap(next);
+		for (int b = 0; b < width; b++) {
+			block.total[b] = 0;
+		}
+		for (int i = 0; i < N; i++) {
+			for (int b = 0; b < width; b++) {
+				block.total[b] += block.count[i * width + b];
+			}
+		}
+	} else {
+		std::vector<long double>& next = block.next_scaled;
+		for (int i = 0; i < N * width; i++) {
+			next[i] = 0.0;
+		}
+		for (int i = 0; i < N; i++) {
+			const long double* from = &block.scaled[i * width];
+			for (int k = adj->offsets[i]; k < adj->offsets[i + 1]; k++) {
+				long double* to = &next[adj->nodes[k] * width];
+				for (int b = 0; b < width; b++) {
+					to[b] += from[b];
+				}
+			}
+		}
+		block.scaled.swap(next);
+		
+		// Keep the largest value of each column below one
+		for (int b = 0; b < width; b++) {
+			long double max_value = 0.0;
+			for (int i = 0; i < N; i++) {
+				if (block.scaled[i * width + b] > max_value) {
+					max_value = block.scaled[i * width + b];
+				}
+			}
+			if (max_value > 0.0) {
+				int exponent;
+				std::frexp(max_value, &exponent);
+				for (int i = 0; i < N; i++) {
+					block.scaled[i * width + b] = std::ldexp(block.scaled[i * width + b], -exponent);
+				}
+				block.scale[b] += exponent;
+			}
+		}
+	}
+}
+
+/*
+ * Returns the number of walks in the given column that end at the given node,
+ * or its natural logarithm.
+ */
+FP_T BCT_NAMESPACE::walk_block_value(const walk_block& block, int node, int column, bool log_scale) {
+	int i = node * block.width + column;
+	if (block.exact) {
+		if (log_scale) {
+			return (block.count[i] == 0) ? -std::numeric_limits<FP_T>::infinity() : (FP_T)std::log((long double)block.count[i]);
+		} else {
+			return (FP_T)block.count[i];
+		}
+	} else {
+		long double value = block.scaled[i];
+		if (log_scale) {
+			return (value == 0.0) ? -std::numeric_limits<FP_T>::infinity() : (FP_T)(std::log(value) + block.scale[column] * std::log(2.0L));
+		} else {
+			return (FP_T)std::ldexp(value, block.scale[column]);
+		}
+	}
+}
+
+/*
+ * Returns the total number of walks in the given column, or its natural
+ * logarithm.
+ */
+FP_T BCT_NAMESPACE::walk_block_total(const walk_block& block, int column, bool log_scale) {
+	if (block.exact) {
+		walk_count total = block.total[column];
+		if (log_scale) {
+			return (total == 0) ? -std::numeric_limits<FP_T>::infinity() : (FP_T)std::log((long double)total);
+		} else {
+			return (FP_T)total;
+		}
+	} else {
+		long double total = 0.0;
+		for (int i = 0; i < block.adj->size; i++) {
+			total += block.scaled[i * block.width + column];
+		}
+		if (log_scale) {
+			return (total == 0.0) ? -std::numeric_limits<FP_T>::infinity() : (FP_T)(std::log(total) + block.scale[column] * std::log(2.0L));
+		} else {
+			return (FP_T)std::ldexp(total, block.scale[column]);
+		}
+	}
+}
@@ -0,0 +1,281 @@
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "bct.h"
+
+namespace BCT_NAMESPACE {
+	
+	// Quantities cached by a context
+	enum context_quantity {
+		CONTEXT_ADJACENCY_LIST,
+		CONTEXT_BASIC_STATS,
+		CONTEXT_DEGREES_UND,
+		CONTEXT_STRENGTHS_UND,
+		CONTEXT_TRIANGLES,
+		CONTEXT_DISTANCE_BIN,
+		CONTEXT_DISTANCE_WEI,
+		CONTEXT_MODULES,
+		CONTEXT_MODULE_STRENGTH,
+		CONTEXT_QUANTITY_COUNT
+	};
+	
+	/*
+	 * Whether each quantity has been computed, and a lock for each quantity so
+	 * that different threads can compute different quantities of the same graph
+	 * at the same time.
+	 */
+	struct context_state {
+		bool computed[CONTEXT_QUANTITY_COUNT];
+#ifdef _OPENMP
+		omp_lock_t locks[CONTEXT_QUANTITY_COUNT];
+#endif
+	};
+	
+	/*
+	 * Holds the lock for one quantity of a context for the lifetime of the
+	 * guard, so that the lock is released if a computation throws.
+	 */
+	class context_guard {
+	public:
+		context_guard(graph_context* context, context_quantity quantity);
+		~context_guard();
+		bool computed() const;
+		void set_computed();
+	private:
+		context_state* state;
+		context_quantity quantity;
+	};
+}
+
+/*
+ * Creates a context that caches quantities derived from the given graph.
+ * Nothing is computed until it is first requested, and each quantity is then
+ * computed only once, so measures that take a context share this work.  The
+ * graph is not copied and must not be modified or freed while the context is in
+ * use.  Quantities may be requested from several threads at once.
+ */
+BCT_NAMESPACE::graph_context* BCT_NAMESPACE::graph_context_alloc(const MATRIX_T* W) {
+	if (safe_mode) check_status(W, SQUARE, "graph_context_alloc");
+	graph_context* context = new graph_context;
+	context->W = W;
+	context->adj = NULL;
+	context->stats = NULL;
+	context->deg = NULL;
+	context->str = NULL;
+	context->triangles = NULL;
+	context->D_bin = NULL;
+	context->D_wei = NULL;
+	context->Ci = NULL;
+	context->Q = 0.0;
+	context->S = NULL;
+	context_state* state = new context_state;
+	for (int i = 0; i < CONTEXT_QUANTITY_COUNT; i++) {
+		state->computed[i] = false;
+#ifdef _OPENMP
+		omp_init_lock(&state->locks[i]);
+#endif
+	}
+	context->state = state;
+	return context;
+}
+
+/*
+ * Frees a context and every quantity it has cached.
+ */
+void BCT_NAMESPACE::graph_context_free(graph_context* context) {
+	if (context == NULL) {
+		return;
+	}
+	if (context->adj != NULL) adjacency_list_free(context->adj);
+	if (context->stats != NULL) basic_stats_free(context->stats);
+	if (context->deg != NULL) VECTOR_ID(free)(context->deg);
+	if (context->str != NULL) VECTOR_ID(free)(context->str);
+	if (context->triangles != NULL) VECTOR_ID(free)(context->triangles);
+	if (context->D_bin != NULL) MATRIX_ID(free)(context->D_bin);
+	if (context->D_wei != NULL) MATRIX_ID(free)(context->D_wei);
+	if (context->Ci != NULL) VECTOR_ID(free)(context->Ci);
+	if (context->S != NULL) MATRIX_ID(free)(context->S);
+	context_state* state = (context_state*)context->state;
+#ifdef _OPENMP
+	for (int i = 0; i < CONTEXT_QUANTITY_COUNT; i++) {
+		omp_destroy_lock(&state->locks[i]);
+	}
+#endif
+	delete state;
+	delete context;
+}
+
+/*
+ * Returns the adjacency list of the graph.
+ */
+const BCT_NAMESPACE::adjacency_list* BCT_NAMESPACE::context_adjacency_list(graph_context* context) {
+	context_guard guard(context, CONTEXT_ADJACENCY_LIST);
+	if (!guard.computed()) {
+		context->adj = to_adjacency_list(context->W);
+		guard.set_computed();
+	}
+	return context->adj;
+}
+
+/*
+ * Returns the result of basic_stats_dir for the graph.
+ */
+const BCT_NAMESPACE::basic_stats* BCT_NAMESPACE::context_basic_stats(graph_context* context) {
+	context_guard guard(context, CONTEXT_BASIC_STATS);
+	if (!guard.computed()) {
+		context->stats = basic_stats_dir(context->W);
+		guard.set_computed();
+	}
+	return context->stats;
+}
+
+/*
+ * Returns the result of degrees_und for the graph.
+ */
+const VECTOR_T* BCT_NAMESPACE::context_degrees_und(graph_context* context) {
+	context_guard guard(context, CONTEXT_DEGREES_UND);
+	if (!guard.computed()) {
+		context->deg = degrees_und(context->W);
+		guard.set_computed();
+	}
+	return context->deg;
+}
+
+/*
+ * Returns the result of strengths_und for the graph.
+ */
+const VECTOR_T* BCT_NAMESPACE::context_strengths_und(graph_context* context) {
+	context_guard guard(context, CONTEXT_STRENGTHS_UND);
+	if (!guard.computed()) {
+		context->str = strengths_und(context->W);
+		guard.set_computed();
+	}
+	return context->str;
+}
+
+/*
+ * Returns the number of triangles around each node of an undirected graph.
+ * Connection weights are ignored.  Element i is half the number of connections
+ * between pairs of neighbors of node i, which is the number of triangles when
+ * the graph has no self-connections.
+ */
+const VECTOR_T* BCT_NAMESPACE::context_triangles(graph_context* context) {
+	context_guard guard(context, CONTEXT_TRIANGLES);
+	if (guard.computed()) {
+		return context->triangles;
+	}
+	const adjacency_list* adj = context_adjacency_list(context);
+	int N = adj->size;
+	VECTOR_T* triangles = VECTOR_ID(alloc)(N);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+	{
+		
+		// Neighbors of node u are marked with u + 1, so the marks never need to
+		// be cleared
+		int* mark = new int[(N > 0) ? N : 1];
+		for (int i = 0; i < N; i++) {
+			mark[i] = 0;
+		}
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+		for (int u = 0; u < N; u++) {
+			for (int k = adj->offsets[u]; k < adj->offsets[u + 1]; k++) {
+				mark[adj->nodes[k]] = u + 1;
+			}
+			long pairs = 0;
+			for (int k = adj->offsets[u]; k < adj->offsets[u + 1]; k++) {
+				int v = adj->nodes[k];
+				for (int l = adj->offsets[v]; l < adj->offsets[v + 1]; l++) {
+					pairs += (mark[adj->nodes[l]] == u + 1);
+				}
+			}
+			VECTOR_ID(set)(triangles, u, 0.5 * (FP_T)pairs);
+		}
+		delete[] mark;
+	}
+	context->triangles = triangles;
+	guard.set_computed();
+	return triangles;
+}
+
+/*
+ * Returns the result of distance_bin for the graph.
+ */
+const MATRIX_T* BCT_NAMESPACE::context_distance_bin(graph_context* context) {
+	context_guard guard(context, CONTEXT_DISTANCE_BIN);
+	if (!guard.computed()) {
+		context->D_bin = distance_bin(context->W);
+		guard.set_computed();
+	}
+	return context->D_bin;
+}
+
+/*
+ * Returns the result of distance_wei for the graph.
+ */
+const MATRIX_T* BCT_NAMESPACE::context_distance_wei(graph_context* context) {
+	context_guard guard(context, CONTEXT_DISTANCE_WEI);
+	if (!guard.computed()) {
+		context->D_wei = distance_wei(context->W);
+		guard.set_computed();
+	}
+	return context->D_wei;
+}
+
+/*
+ * Returns community structure found by modularity_und, and its modularity in Q
+ * if given.  modularity_und draws from the shared random number generator, so
+ * results depend on the order in which contexts first compute their modules.
+ */
+const VECTOR_T* BCT_NAMESPACE::context_modules(graph_context* context, FP_T* Q) {
+	context_guard guard(context, CONTEXT_MODULES);
+	if (!guard.computed()) {
+		context->Q = modularity_und(context->W, &context->Ci);
+		guard.set_computed();
+	}
+	if (Q != NULL) {
+		*Q = context->Q;
+	}
+	return context->Ci;
+}
+
+/*
+ * Returns the result of module_strength for the community structure returned
+ * by context_modules.  It is computed from the adjacency list, so it omits
+ * weights within machine epsilon of zero.
+ */
+const MATRIX_T* BCT_NAMESPACE::context_module_strength(graph_context* context) {
+	context_guard guard(context, CONTEXT_MODULE_STRENGTH);
+	if (!guard.computed()) {
+		const VECTOR_T* Ci = context_modules(context);
+		context->S = module_strength(context_adjacency_list(context), Ci);
+		guard.set_computed();
+	}
+	return context->S;
+}
+
+BCT_NAMESPACE::context_guard::context_guard(graph_context* context, context_quantity quantity) {
+	state = (context_state*)context->state;
+	this->quantity = quantity;
+#ifdef _OPENMP
+	omp_set_lock(&state->locks[quantity]);
+#endif
+}
+
+BCT_NAMESPACE::context_guard::~context_guard() {
+#ifdef _OPENMP
+	omp_unset_lock(&state->locks[quantity]);
+#endif
+}
+
+bool BCT_NAMESPACE::context_guard::computed() const {
+	return state->computed[quantity];
+}
+
+void BCT_NAMESPACE::context_guard::set_computed() {
+	state->computed[quantity] = true;
+}
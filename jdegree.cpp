@@ -9,37 +9,12 @@ MATRIX_T* BCT_NAMESPACE::jdegree(const MATRIX_T* CIJ) {
 	if (safe_mode) check_status(CIJ, SQUARE, "jdegree");
 	
 	// CIJ = double(CIJ~=0);
-	MATRIX_T* _CIJ = compare_elements(CIJ, fp_not_equal, 0.0);
-	
-	// N = size(CIJ,1);
-	int N = _CIJ->size1;
-	
 	// id = sum(CIJ,1);
-	VECTOR_T* id = sum(_CIJ, 1);
-	
 	// od = sum(CIJ,2)';
-	VECTOR_T* od = sum(_CIJ, 2);
-	MATRIX_ID(free)(_CIJ);
-	
-	// szJ = max(max(id,od))+1;
-	FP_T max_id = VECTOR_ID(max)(id);
-	FP_T max_od = VECTOR_ID(max)(od);
-	int szJ = (int)max(max_id, max_od) + 1;
-	
 	// J = zeros(szJ);
-	MATRIX_T* J = zeros(szJ);
-	
-	// for i=1:N
-	for (int i = 0; i < N; i++) {
-		
-		// J(id(i)+1,od(i)+1) = J(id(i)+1,od(i)+1) + 1;
-		int id_i = (int)VECTOR_ID(get)(id, i);
-		int od_i = (int)VECTOR_ID(get)(od, i);
-		MATRIX_ID(set)(J, id_i, od_i, MATRIX_ID(get)(J, id_i, od_i) + 1.0);
-	}
-	
-	VECTOR_ID(free)(id);
-	VECTOR_ID(free)(od);
+	basic_stats* stats = basic_stats_dir(CIJ);
+	MATRIX_T* J = copy(stats->J);
+	basic_stats_free(stats);
 	return J;
 }
 
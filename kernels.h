@@ -0,0 +1,210 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+/*
+ * Graph kernels templated on the type in which connection weights are stored
+ * (S) and the type in which results are accumulated (A).  Unlike the rest of
+ * the library, these do not depend on the precision macros, so any
+ * combination of types can be used in the same program; for instance, a large
+ * graph can be stored as float, halving the memory read by each kernel, while
+ * distances and sums are accumulated in double.  Each precision of the library
+ * calls these kernels with S = FP_T and A = ACC_T.
+ */
+namespace bct_kernels {
+	
+	// Read-only view of a graph in compressed sparse row form, as stored by
+	// adjacency_list
+	template<class S> struct graph_view {
+		int size;
+		const int* offsets;
+		const int* nodes;
+		const S* weights;
+	};
+	
+	// Scratch space for Dijkstra's algorithm.  Its storage grows to fit the
+	// largest search made with it and is kept between searches, so a workspace
+	// reused by one thread allocates nothing once it has warmed up.
+	template<class A> struct dijkstra_workspace {
+		std::vector<bool> unsettled;
+		std::vector<std::pair<A, int> > heap;
+	};
+	
+	template<class A, class S> void distance_wei_row(const graph_view<S>& L, int source, A* D_row);
+	template<class A, class S> void distance_wei_row(const graph_view<S>& L, int source, A* D_row, dijkstra_workspace<A>* ws);
+	template<class A, class S, class Equal> void betweenness_wei(const graph_view<S>& L, Equal equal, A* BC);
+	template<class A, class S, class Zero> void clustering_coef_wu(const graph_view<S>& W, Zero zero, A* C);
+}
+
+/*
+ * Computes a single row of the distance matrix for a weighted graph, given as
+ * lengths.  This is Dijkstra's algorithm with a binary heap.  D_row must have
+ * one element per node.
+ */
+template<class A, class S> void bct_kernels::distance_wei_row(const graph_view<S>& L, int source, A* D_row) {
+	dijkstra_workspace<A> ws;
+	distance_wei_row(L, source, D_row, &ws);
+}
+
+/*
+ * Computes a single row of the distance matrix as above, keeping the heap and
+ * the settled flags in the given workspace.  The heap is ordered as by
+ * std::priority_queue, so the result does not depend on the workspace.
+ */
+template<class A, class S> void bct_kernels::distance_wei_row(const graph_view<S>& L, int source, A* D_row, dijkstra_workspace<A>* ws) {
+	typedef std::pair<A, int> heap_entry;
+	std::greater<heap_entry> heap_order;
+	int N = L.size;
+	for (int i = 0; i < N; i++) {
+		D_row[i] = std::numeric_limits<A>::infinity();
+	}
+	D_row[source] = 0.0;
+	std::vector<bool>& unsettled = ws->unsettled;
+	unsettled.assign(N, true);
+	std::vector<heap_entry>& Q = ws->heap;
+	Q.clear();
+	Q.push_back(heap_entry(0.0, source));
+	while (!Q.empty()) {
+		A D_u_v = Q.front().first;
+		int v = Q.front().second;
+		std::pop_heap(Q.begin(), Q.end(), heap_order);
+		Q.pop_back();
+		if (!unsettled[v]) {
+			continue;
+		}
+		unsettled[v] = false;
+		for (int i = L.offsets[v]; i < L.offsets[v + 1]; i++) {
+			int w = L.nodes[i];
+			if (!unsettled[w]) {
+				continue;
+			}
+			A D_u_w = D_u_v + (A)L.weights[i];
+			if (D_u_w < D_row[w]) {
+				D_row[w] = D_u_w;
+				Q.push_back(heap_entry(D_u_w, w));
+				std::push_heap(Q.begin(), Q.end(), heap_order);
+			}
+		}
+	}
+}
+
+/*
+ * Computes node betweenness for a weighted graph, given as lengths.  This is
+ * Brandes' algorithm: a Dijkstra search from each node counts shortest paths,
+ * and dependencies are then accumulated in reverse order of distance.  Two
+ * path lengths are treated as equal if equal(x, y) is true, and a shorter path
+ * replaces the shortest paths found so far as in betweenness_wei.  BC must have
+ * one element per node.
+ */
+template<class A, class S, class Equal> void bct_kernels::betweenness_wei(const graph_view<S>& L, Equal equal, A* BC) {
+	typedef std::pair<A, int> heap_entry;
+	int n = L.size;
+	for (int i = 0; i < n; i++) {
+		BC[i] = 0.0;
+	}
+	std::vector<A> D(n);
+	std::vector<A> NP(n);
+	std::vector<A> DP(n);
+	std::vector<bool> unsettled(n);
+	std::vector<int> order;
+	order.reserve(n);
+	std::vector<std::vector<int> > P(n);
+	for (int u = 0; u < n; u++) {
+		for (int i = 0; i < n; i++) {
+			D[i] = std::numeric_limits<A>::infinity();
+			NP[i] = 0.0;
+			DP[i] = 0.0;
+			unsettled[i] = true;
+			P[i].clear();
+		}
+		D[u] = 0.0;
+		NP[u] = 1.0;
+		order.clear();
+		std::priority_queue<heap_entry, std::vector<heap_entry>, std::greater<heap_entry> > Q;
+		Q.push(heap_entry(0.0, u));
+		while (!Q.empty()) {
+			int v = Q.top().second;
+			Q.pop();
+			if (!unsettled[v]) {
+				continue;
+			}
+			unsettled[v] = false;
+			order.push_back(v);
+			for (int i = L.offsets[v]; i < L.offsets[v + 1]; i++) {
+				int w = L.nodes[i];
+				if (!unsettled[w]) {
+					continue;
+				}
+				A Duw = D[v] + (A)L.weights[i];
+				if (Duw < D[w]) {
+					D[w] = Duw;
+					NP[w] = NP[v];
+					P[w].assign(1, v);
+					Q.push(heap_entry(Duw, w));
+				} else if (equal(Duw, D[w])) {
+					NP[w] += NP[v];
+					P[w].push_back(v);
+				}
+			}
+		}
+		for (int i = (int)order.size() - 1; i > 0; i--) {
+			int w = order[i];
+			BC[w] += DP[w];
+			for (int k = 0; k < (int)P[w].size(); k++) {
+				int v = P[w][k];
+				DP[v] += (1.0 + DP[w]) * NP[v] / NP[w];
+			}
+		}
+	}
+}
+
+/*
+ * Computes the clustering coefficient for a weighted undirected graph.  The
+ * cube roots of the connections of each node are spread into a dense row, so
+ * that the weighted triangles around node i are found by visiting only the
+ * neighbors of its neighbors.  Nodes with no triangles (zero(cyc3) is true)
+ * have a coefficient of 0.  C must have one element per node.
+ */
+template<class A, class S, class Zero> void bct_kernels::clustering_coef_wu(const graph_view<S>& W, Zero zero, A* C) {
+	int n = W.size;
+	int edges = W.offsets[n];
+	std::vector<A> W_root(edges);
+	for (int k = 0; k < edges; k++) {
+		W_root[k] = std::pow((A)W.weights[k], (A)(1.0 / 3.0));
+	}
+	std::vector<A> root(n, 0.0);
+	for (int i = 0; i < n; i++) {
+		for (int k = W.offsets[i]; k < W.offsets[i + 1]; k++) {
+			root[W.nodes[k]] = W_root[k];
+		}
+		
+		// cyc3=diag((W.^(1/3))^3);
+		A cyc3 = 0.0;
+		for (int k = W.offsets[i]; k < W.offsets[i + 1]; k++) {
+			int j = W.nodes[k];
+			A paths = 0.0;
+			for (int l = W.offsets[j]; l < W.offsets[j + 1]; l++) {
+				paths += W_root[l] * root[W.nodes[l]];
+			}
+			cyc3 += W_root[k] * paths;
+		}
+		for (int k = W.offsets[i]; k < W.offsets[i + 1]; k++) {
+			root[W.nodes[k]] = 0.0;
+		}
+		
+		// K=sum(W~=0,2);
+		// K(cyc3==0)=inf;
+		// C=cyc3./(K.*(K-1));
+		A K = (A)(W.offsets[i + 1] - W.offsets[i]);
+		C[i] = zero(cyc3) ? 0.0 : cyc3 / (K * (K - 1.0));
+	}
+}
+
+#endif
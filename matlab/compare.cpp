@@ -1,28 +1,46 @@
 #include <cmath>
+#include <cstring>
+#include <stdint.h>
 
 #include "matlab.h"
 
+namespace MATLAB_NAMESPACE {
+	inline float fp_scale(float x);
+	inline double fp_scale(double x);
+	inline long double fp_scale(long double x);
+	inline int fp_compare(FP_T x, FP_T y, FP_T epsilon);
+	int comparator_results(comparator compare);
+}
+
 FP_T MATLAB_NAMESPACE::epsilon = std::numeric_limits<FP_T>::epsilon();
 
 /*
  * Compares two floating-point numbers.
  */
 int MATLAB_NAMESPACE::fp_compare(FP_T x, FP_T y) {
-	if (fp_zero(x) && fp_zero(y)) {
-		return 0;
-	} else {
-		int exponent;
-		FP_T max = (std::abs(x) > std::abs(y)) ? x : y;
-		std::frexp(max, &exponent);
-		FP_T delta = std::ldexp(epsilon, exponent);
-		FP_T difference = x - y;
-		if (difference > delta) {
-			return 1;
-		} else if (difference < -delta) {
-			return -1;
-		} else {
-			return 0;
-		}
+	return fp_compare(x, y, epsilon);
+}
+
+/*
+ * Compares each element of x with the corresponding element of y, storing the
+ * results of fp_compare in result.  The loop has no branches, so compilers can
+ * vectorize it (e.g., GCC with -O3 -mavx).
+ */
+void MATLAB_NAMESPACE::fp_compare(const FP_T* x, const FP_T* y, int n, int* result) {
+	FP_T eps = epsilon;
+	for (int i = 0; i < n; i++) {
+		result[i] = fp_compare(x[i], y[i], eps);
+	}
+}
+
+/*
+ * Compares each element of x with y, storing the results of fp_compare in
+ * result.
+ */
+void MATLAB_NAMESPACE::fp_compare(const FP_T* x, FP_T y, int n, int* result) {
+	FP_T eps = epsilon;
+	for (int i = 0; i < n; i++) {
+		result[i] = fp_compare(x[i], y, eps);
 	}
 }
 
@@ -96,10 +114,22 @@ bool MATLAB_NAMESPACE::matrix_less(MATRIX_T* m1, MATRIX_T* m2) {
 }
 
 /*
- * Emulates (v op x), where op is a binary comparison operator.
+ * Emulates (v op x), where op is a binary comparison operator.  The fp_
+ * comparators are applied to contiguous data in bulk.
  */
 VECTOR_T* MATLAB_NAMESPACE::compare_elements(const VECTOR_T* v, comparator compare, FP_T x) {
 	VECTOR_T* cmp_v = VECTOR_ID(alloc)(v->size);
+	int results = comparator_results(compare);
+	if (results != 0 && v->stride == 1) {
+		int n = v->size;
+		int* cmp = new int[(n > 0) ? n : 1];
+		fp_compare(v->data, x, n, cmp);
+		for (int i = 0; i < n; i++) {
+			cmp_v->data[i] = (FP_T)((results >> (cmp[i] + 1)) & 1);
+		}
+		delete[] cmp;
+		return cmp_v;
+	}
 	for (int i = 0; i < (int)v->size; i++) {
 		FP_T value = VECTOR_ID(get)(v, i);
 		VECTOR_ID(set)(cmp_v, i, (FP_T)compare(value, x));
@@ -115,6 +145,17 @@ VECTOR_T* MATLAB_NAMESPACE::compare_elements(const VECTOR_T* v1, comparator comp
 		return NULL;
 	}
 	VECTOR_T* cmp_v = VECTOR_ID(alloc)(v1->size);
+	int results = comparator_results(compare);
+	if (results != 0 && v1->stride == 1 && v2->stride == 1) {
+		int n = v1->size;
+		int* cmp = new int[(n > 0) ? n : 1];
+		fp_compare(v1->data, v2->data, n, cmp);
+		for (int i = 0; i < n; i++) {
+			cmp_v->data[i] = (FP_T)((results >> (cmp[i] + 1)) & 1);
+		}
+		delete[] cmp;
+		return cmp_v;
+	}
 	for (int i = 0; i < (int)v1->size; i++) {
 		FP_T value1 = VECTOR_ID(get)(v1, i);
 		FP_T value2 = VECTOR_ID(get)(v2, i);
@@ -124,10 +165,25 @@ VECTOR_T* MATLAB_NAMESPACE::compare_elements(const VECTOR_T* v1, comparator comp
 }
 
 /*
- * Emulates (m op x), where op is a binary comparison operator.
+ * Emulates (m op x), where op is a binary comparison operator.  The fp_
+ * comparators are applied to one row at a time in bulk.
  */
 MATRIX_T* MATLAB_NAMESPACE::compare_elements(const MATRIX_T* m, comparator compare, FP_T x) {
 	MATRIX_T* cmp_m = MATRIX_ID(alloc)(m->size1, m->size2);
+	int results = comparator_results(compare);
+	if (results != 0) {
+		int n = m->size2;
+		int* cmp = new int[(n > 0) ? n : 1];
+		for (int i = 0; i < (int)m->size1; i++) {
+			fp_compare(MATRIX_ID(const_ptr)(m, i, 0), x, n, cmp);
+			FP_T* cmp_row = MATRIX_ID(ptr)(cmp_m, i, 0);
+			for (int j = 0; j < n; j++) {
+				cmp_row[j] = (FP_T)((results >> (cmp[j] + 1)) & 1);
+			}
+		}
+		delete[] cmp;
+		return cmp_m;
+	}
 	for (int i = 0; i < (int)m->size1; i++) {
 		for (int j = 0; j < (int)m->size2; j++) {
 			FP_T value = MATRIX_ID(get)(m, i, j);
@@ -145,6 +201,20 @@ MATRIX_T* MATLAB_NAMESPACE::compare_elements(const MATRIX_T* m1, comparator comp
 		return NULL;
 	}
 	MATRIX_T* cmp_m = MATRIX_ID(alloc)(m1->size1, m1->size2);
+	int results = comparator_results(compare);
+	if (results != 0) {
+		int n = m1->size2;
+		int* cmp = new int[(n > 0) ? n : 1];
+		for (int i = 0; i < (int)m1->size1; i++) {
+			fp_compare(MATRIX_ID(const_ptr)(m1, i, 0), MATRIX_ID(const_ptr)(m2, i, 0), n, cmp);
+			FP_T* cmp_row = MATRIX_ID(ptr)(cmp_m, i, 0);
+			for (int j = 0; j < n; j++) {
+				cmp_row[j] = (FP_T)((results >> (cmp[j] + 1)) & 1);
+			}
+		}
+		delete[] cmp;
+		return cmp_m;
+	}
 	for (int i = 0; i < (int)m1->size1; i++) {
 		for (int j = 0; j < (int)m1->size2; j++) {
 			FP_T value1 = MATRIX_ID(get)(m1, i, j);
@@ -154,3 +224,76 @@ MATRIX_T* MATLAB_NAMESPACE::compare_elements(const MATRIX_T* m1, comparator comp
 	}
 	return cmp_m;
 }
+
+/*
+ * Compares two floating-point numbers, treating them as equal if both are
+ * smaller in magnitude than epsilon or if they differ by no more than epsilon
+ * scaled to the binary exponent of the larger one.  This is the comparison
+ * originally done with frexp and ldexp; the scale is now read from the
+ * exponent bits and selected without branches.
+ */
+inline int MATLAB_NAMESPACE::fp_compare(FP_T x, FP_T y, FP_T epsilon) {
+	FP_T abs_x = std::abs(x);
+	FP_T abs_y = std::abs(y);
+	FP_T max = (abs_x > abs_y) ? abs_x : abs_y;
+	FP_T delta = (epsilon + epsilon) * fp_scale(max);
+	FP_T difference = x - y;
+	int result = (difference > delta) - (difference < -delta);
+	int zero = (abs_x < epsilon) & (abs_y < epsilon);
+	return result * (1 - zero);
+}
+
+/*
+ * Returns the largest power of two not greater than the magnitude of x, or 1
+ * if x is infinite or NaN.  Zero and subnormal numbers return zero, but fp_zero
+ * holds for these so their scale is never used.
+ */
+inline float MATLAB_NAMESPACE::fp_scale(float x) {
+	uint32_t bits;
+	std::memcpy(&bits, &x, sizeof(bits));
+	uint32_t exponent = bits & 0x7f800000u;
+	uint32_t special = 0u - (uint32_t)(exponent == 0x7f800000u);
+	bits = (exponent & ~special) | (0x3f800000u & special);
+	float scale;
+	std::memcpy(&scale, &bits, sizeof(scale));
+	return scale;
+}
+
+inline double MATLAB_NAMESPACE::fp_scale(double x) {
+	uint64_t bits;
+	std::memcpy(&bits, &x, sizeof(bits));
+	uint64_t exponent = bits & 0x7ff0000000000000ull;
+	uint64_t special = 0u - (uint64_t)(exponent == 0x7ff0000000000000ull);
+	bits = (exponent & ~special) | (0x3ff0000000000000ull & special);
+	double scale;
+	std::memcpy(&scale, &bits, sizeof(scale));
+	return scale;
+}
+
+/*
+ * The layout of long double varies between platforms, so its exponent is found
+ * with frexp.
+ */
+inline long double MATLAB_NAMESPACE::fp_scale(long double x) {
+	if (x != x || x - x != 0.0L) {
+		return 1.0L;
+	}
+	int exponent;
+	std::frexp(x, &exponent);
+	return std::ldexp(0.5L, exponent);
+}
+
+/*
+ * Returns a bit mask of the fp_compare results (bit 0 for -1, bit 1 for 0, and
+ * bit 2 for 1) for which the given comparator holds, or zero if the comparator
+ * is not one of the fp_ comparators.
+ */
+int MATLAB_NAMESPACE::comparator_results(comparator compare) {
+	if (compare == fp_equal) return 2;
+	if (compare == fp_not_equal) return 5;
+	if (compare == fp_less) return 1;
+	if (compare == fp_less_or_equal) return 3;
+	if (compare == fp_greater) return 4;
+	if (compare == fp_greater_or_equal) return 6;
+	return 0;
+}
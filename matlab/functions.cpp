@@ -3,10 +3,28 @@
 #include <gsl/gsl_linalg.h>
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_randist.h>
+#include <vector>
 
 #include "matlab.h"
 #include "sort.h"
 
+namespace MATLAB_NAMESPACE {
+	
+	/*
+	 * Compares two rows of a matrix by index, so that rows can be sorted
+	 * without being copied.
+	 */
+	class row_less {
+	public:
+		row_less(const MATRIX_T* m) : m(m) { }
+		bool operator()(std::size_t i, std::size_t j) const;
+	private:
+		const MATRIX_T* m;
+	};
+	
+	int compare_rows(const MATRIX_T* m, std::size_t i, std::size_t j);
+}
+
 /*
  * See MATLAB documentation for descriptions of these functions.  We will
  * document instances where our version differs from the MATLAB version.
@@ -445,10 +463,15 @@ int MATLAB_NAMESPACE::nnz(const VECTOR_T* v) {
 }
 
 int MATLAB_NAMESPACE::nnz(const MATRIX_T* m) {
-	VECTOR_T* v = to_vector(m);
-	int nnz_v = nnz(v);
-	VECTOR_ID(free)(v);
-	return nnz_v;
+	int nnz = 0;
+	for (int i = 0; i < (int)m->size1; i++) {
+		for (int j = 0; j < (int)m->size2; j++) {
+			if (fp_nonzero(MATRIX_ID(get)(m, i, j))) {
+				nnz++;
+			}
+		}
+	}
+	return nnz;
 }
 
 VECTOR_T* MATLAB_NAMESPACE::nonzeros(const MATRIX_T* m) {
@@ -567,12 +590,12 @@ VECTOR_T* MATLAB_NAMESPACE::rand_vector(int size) {
  */
 gsl_permutation* MATLAB_NAMESPACE::randperm(int size) {
 	gsl_rng* rng = get_rng();
-	FP_T values[size];
+	std::vector<FP_T> values(size + 1);
 	for (int i = 0; i < size; i++) {
 		values[i] = (FP_T)i;
 	}
-	gsl_ran_shuffle(rng, values, size, sizeof(FP_T));
-	VECTOR_ID(view) values_vv = VECTOR_ID(view_array)(values, size);
+	gsl_ran_shuffle(rng, &values[0], size, sizeof(FP_T));
+	VECTOR_ID(view) values_vv = VECTOR_ID(view_array)(&values[0], size);
 	gsl_permutation* values_p = to_permutation(&values_vv.vector);
 	return values_p;
 }
@@ -585,6 +608,11 @@ VECTOR_T* MATLAB_NAMESPACE::reverse(const VECTOR_T* v) {
 	return rev_v;
 }
 
+/*
+ * Both sets are sorted by unique, so their symmetric difference is found by
+ * merging them in one pass.  As in MATLAB, NaNs are never equal, so every NaN
+ * from either set is kept.
+ */
 VECTOR_T* MATLAB_NAMESPACE::setxor(const VECTOR_T* v1, const VECTOR_T* v2) {
 	if (v1 == NULL && v2 == NULL) {
 		return NULL;
@@ -597,64 +625,67 @@ VECTOR_T* MATLAB_NAMESPACE::setxor(const VECTOR_T* v1, const VECTOR_T* v2) {
 	}
 	VECTOR_T* unique_v1 = unique(v1);
 	VECTOR_T* unique_v2 = unique(v2);
-	VECTOR_T* unsized_v = VECTOR_ID(alloc)(v1->size + v2->size);
-	int n = 0;
-	for (int i = 0; i < (int)unique_v1->size; i++) {
-		bool found = false;
-		FP_T v1_value = VECTOR_ID(get)(unique_v1, i);
-		for (int j = 0; j < (int)unique_v2->size; j++) {
-			FP_T v2_value = VECTOR_ID(get)(unique_v2, j);
-			if (fp_equal(v1_value, v2_value)) {
-				found = true;
-				break;
+	int size1 = (unique_v1 == NULL) ? 0 : unique_v1->size;
+	int size2 = (unique_v2 == NULL) ? 0 : unique_v2->size;
+	std::vector<FP_T> elements;
+	int x = 0;
+	int y = 0;
+	while (x < size1 || y < size2) {
+		int result;
+		if (x == size1) {
+			result = 1;
+		} else if (y == size2) {
+			result = -1;
+		} else {
+			FP_T value1 = VECTOR_ID(get)(unique_v1, x);
+			FP_T value2 = VECTOR_ID(get)(unique_v2, y);
+			
+			// NaNs sort last, after every number
+			if (gsl_isnan((double)value1) == 1) {
+				result = (gsl_isnan((double)value2) == 1) ? -1 : 1;
+			} else if (gsl_isnan((double)value2) == 1) {
+				result = -1;
+			} else {
+				result = fp_compare(value1, value2);
 			}
 		}
-		if (!found) {
-			VECTOR_ID(set)(unsized_v, n++, v1_value);
+		if (result < 0) {
+			elements.push_back(VECTOR_ID(get)(unique_v1, x++));
+		} else if (result > 0) {
+			elements.push_back(VECTOR_ID(get)(unique_v2, y++));
+		} else {
+			x++;
+			y++;
 		}
 	}
-	for (int i = 0; i < (int)unique_v2->size; i++) {
-		bool found = false;
-		FP_T v2_value = VECTOR_ID(get)(unique_v2, i);
-		for (int j = 0; j < (int)unique_v1->size; j++) {
-			FP_T v1_value = VECTOR_ID(get)(unique_v1, j);
-			if (fp_equal(v2_value, v1_value)) {
-				found = true;
-				break;
-			}
-		}
-		if (!found) {
-			VECTOR_ID(set)(unsized_v, n++, v2_value);
-		}
+	if (unique_v1 != NULL) {
+		VECTOR_ID(free)(unique_v1);
 	}
-	VECTOR_ID(free)(unique_v1);
-	VECTOR_ID(free)(unique_v2);
-	if (n > 0) {
-		VECTOR_T* unsorted_v = VECTOR_ID(alloc)(n);
-		VECTOR_ID(view) unsized_subv = VECTOR_ID(subvector)(unsized_v, 0, n);
-		VECTOR_ID(memcpy)(unsorted_v, &unsized_subv.vector);
-		VECTOR_ID(free)(unsized_v);
-		VECTOR_T* setxor_v = sort(unsorted_v);
-		VECTOR_ID(free)(unsorted_v);
-		return setxor_v;
-	} else {
-		VECTOR_ID(free)(unsized_v);
+	if (unique_v2 != NULL) {
+		VECTOR_ID(free)(unique_v2);
+	}
+	if (elements.empty()) {
 		return NULL;
 	}
+	VECTOR_T* setxor_v = VECTOR_ID(alloc)(elements.size());
+	for (int i = 0; i < (int)elements.size(); i++) {
+		VECTOR_ID(set)(setxor_v, i, elements[i]);
+	}
+	return setxor_v;
 }
 
+/*
+ * Elements are compared exactly, as in MATLAB, and NaNs are placed last when
+ * ascending and first when descending.  See argsort.
+ */
 VECTOR_T* MATLAB_NAMESPACE::sort(const VECTOR_T* v, const std::string& mode, VECTOR_T** ind) {
 	if (mode != "ascend" && mode != "descend") {
 		return NULL;
 	}
-	FP_T elements[v->size];
-	to_array(v, elements);
-	std::size_t indices[v->size];
-	if (mode == "ascend") {
-		stable_sort_index(indices, elements, v->size);
-	} else {
-		stable_sort_index(indices, elements, v->size, fp_greater);
-	}
+	std::vector<FP_T> elements(v->size + 1);
+	to_array(v, &elements[0]);
+	std::vector<std::size_t> indices(v->size + 1);
+	argsort(&elements[0], v->size, &indices[0], mode == "descend");
 	VECTOR_T* sort_v = VECTOR_ID(alloc)(v->size);
 	if (ind != NULL) {
 		*ind = VECTOR_ID(alloc)(v->size);
@@ -669,53 +700,46 @@ VECTOR_T* MATLAB_NAMESPACE::sort(const VECTOR_T* v, const std::string& mode, VEC
 	return sort_v;
 }
 
+/*
+ * Each column (or row) is sorted with the same buffers, without allocating a
+ * vector for it.
+ */
 MATRIX_T* MATLAB_NAMESPACE::sort(const MATRIX_T* m, int dim, const std::string& mode, MATRIX_T** ind) {
 	if (mode != "ascend" && mode != "descend") {
 		return NULL;
 	}
-	if (dim == 1) {
-		MATRIX_T* sort_m = MATRIX_ID(alloc)(m->size1, m->size2);
-		if (ind != NULL) {
-			*ind = MATRIX_ID(alloc)(m->size1, m->size2);
-		}
-		for (int i = 0; i < (int)m->size2; i++) {
-			VECTOR_ID(const_view) m_col_i = MATRIX_ID(const_column)(m, i);
-			VECTOR_T* sort_m_col_i;
-			if (ind == NULL) {
-				sort_m_col_i = sort(&m_col_i.vector, mode);
-			} else {
-				VECTOR_T* ind_col_i;
-				sort_m_col_i = sort(&m_col_i.vector, mode, &ind_col_i);
-				MATRIX_ID(set_col)(*ind, i, ind_col_i);
-				VECTOR_ID(free)(ind_col_i);
-			}
-			MATRIX_ID(set_col)(sort_m, i, sort_m_col_i);
-			VECTOR_ID(free)(sort_m_col_i);
-		}
-		return sort_m;
-	} else if (dim == 2) {
-		MATRIX_T* sort_m = MATRIX_ID(alloc)(m->size1, m->size2);
-		if (ind != NULL) {
-			*ind = MATRIX_ID(alloc)(m->size1, m->size2);
-		}
-		for (int i = 0; i < (int)m->size1; i++) {
-			VECTOR_ID(const_view) m_row_i = MATRIX_ID(const_row)(m, i);
-			VECTOR_T* sort_m_row_i;
-			if (ind == NULL) {
-				sort_m_row_i = sort(&m_row_i.vector, mode);
+	if (dim != 1 && dim != 2) {
+		return NULL;
+	}
+	int count = (dim == 1) ? m->size2 : m->size1;
+	int length = (dim == 1) ? m->size1 : m->size2;
+	MATRIX_T* sort_m = MATRIX_ID(alloc)(m->size1, m->size2);
+	if (ind != NULL) {
+		*ind = MATRIX_ID(alloc)(m->size1, m->size2);
+	}
+	std::vector<FP_T> elements(length + 1);
+	std::vector<std::size_t> indices(length + 1);
+	for (int i = 0; i < count; i++) {
+		for (int k = 0; k < length; k++) {
+			elements[k] = (dim == 1) ? MATRIX_ID(get)(m, k, i) : MATRIX_ID(get)(m, i, k);
+		}
+		argsort(&elements[0], length, &indices[0], mode == "descend");
+		for (int k = 0; k < length; k++) {
+			int index = indices[k];
+			if (dim == 1) {
+				MATRIX_ID(set)(sort_m, k, i, elements[index]);
+				if (ind != NULL) {
+					MATRIX_ID(set)(*ind, k, i, (FP_T)index);
+				}
 			} else {
-				VECTOR_T* ind_row_i;
-				sort_m_row_i = sort(&m_row_i.vector, mode, &ind_row_i);
-				MATRIX_ID(set_row)(*ind, i, ind_row_i);
-				VECTOR_ID(free)(ind_row_i);
+				MATRIX_ID(set)(sort_m, i, k, elements[index]);
+				if (ind != NULL) {
+					MATRIX_ID(set)(*ind, i, k, (FP_T)index);
+				}
 			}
-			MATRIX_ID(set_row)(sort_m, i, sort_m_row_i);
-			VECTOR_ID(free)(sort_m_row_i);
 		}
-		return sort_m;
-	} else {
-		return NULL;
 	}
+	return sort_m;
 }
 
 /*
@@ -726,16 +750,8 @@ VECTOR_T* MATLAB_NAMESPACE::sortrows(const VECTOR_T* v, VECTOR_T** ind) {
 }
 
 MATRIX_T* MATLAB_NAMESPACE::sortrows(const MATRIX_T* m, VECTOR_T** ind) {
-	VECTOR_T* rows[m->size1];
-	for (int i = 0; i < (int)m->size1; i++) {
-		rows[i] = VECTOR_ID(alloc)(m->size2);
-		MATRIX_ID(get_row)(rows[i], m, i);
-	}
-	std::size_t indices[m->size1];
-	stable_sort_index(indices, rows, m->size1, vector_less);
-	for (int i = 0; i < (int)m->size1; i++) {
-		VECTOR_ID(free)(rows[i]);
-	}
+	std::vector<std::size_t> indices(m->size1 + 1);
+	stable_sort_index(&indices[0], m->size1, row_less(m));
 	MATRIX_T* sort_m = MATRIX_ID(alloc)(m->size1, m->size2);
 	if (ind != NULL) {
 		*ind = VECTOR_ID(alloc)(m->size1);
@@ -868,48 +884,54 @@ MATRIX_T* MATLAB_NAMESPACE::triu(const MATRIX_T* m, int k) {
 	return triu_m;
 }
 
+/*
+ * Elements are grouped by walking them in sorted order, so i and j are found in
+ * one pass rather than by searching.  As in MATLAB, each NaN is unique.
+ * Returns NULL if v is empty.
+ */
 VECTOR_T* MATLAB_NAMESPACE::unique(const VECTOR_T* v, const std::string& first_or_last, VECTOR_T** i, VECTOR_T** j) {
 	if (first_or_last != "first" && first_or_last != "last") {
 		return NULL;
 	}
-	VECTOR_T* sort_v = sort(v);
-	VECTOR_T* unsized_v = VECTOR_ID(alloc)(v->size);
-	VECTOR_ID(set)(unsized_v, 0, VECTOR_ID(get)(sort_v, 0));
-	int n = 1;
-	for (int x = 1; x < (int)v->size; x++) {
-		FP_T prev_value = VECTOR_ID(get)(sort_v, x - 1);
-		FP_T value = VECTOR_ID(get)(sort_v, x);
-		if (fp_not_equal(prev_value, value)) {
-			VECTOR_ID(set)(unsized_v, n++, value);
-		}
+	int size = v->size;
+	if (size == 0) {
+		return NULL;
 	}
-	VECTOR_ID(free)(sort_v);
+	std::vector<FP_T> elements(size);
+	to_array(v, &elements[0]);
+	std::vector<std::size_t> indices(size);
+	argsort(&elements[0], size, &indices[0]);
+	
+	// Group x contains the sorted elements from start[x] to start[x + 1] - 1
+	std::vector<int> start(1, 0);
+	for (int x = 1; x < size; x++) {
+		FP_T value = elements[indices[x]];
+		if (gsl_isnan((double)value) == 1 || fp_not_equal(elements[indices[x - 1]], value)) {
+			start.push_back(x);
+		}
+	}
+	int n = start.size();
+	start.push_back(size);
 	VECTOR_T* unique_v = VECTOR_ID(alloc)(n);
-	VECTOR_ID(view) unsized_subv = VECTOR_ID(subvector)(unsized_v, 0, n);
-	VECTOR_ID(memcpy)(unique_v, &unsized_subv.vector);
-	VECTOR_ID(free)(unsized_v);
 	if (i != NULL) {
 		*i = VECTOR_ID(alloc)(n);
-		for (int x = 0; x < n; x++) {
-			for (int y = 0; y < (int)v->size; y++) {
-				if (fp_equal(VECTOR_ID(get)(unique_v, x), VECTOR_ID(get)(v, y))) {
-					VECTOR_ID(set)(*i, x, y);
-					if (first_or_last == "first") {
-						break;
-					}
-				}
-			}
-		}
 	}
 	if (j != NULL) {
-		*j = VECTOR_ID(alloc)(v->size);
-		for (int x = 0; x < (int)v->size; x++) {
-			for (int y = 0; y < n; y++) {
-				if (fp_equal(VECTOR_ID(get)(v, x), VECTOR_ID(get)(unique_v, y))) {
-					VECTOR_ID(set)(*j, x, y);
-					break;
-				}
+		*j = VECTOR_ID(alloc)(size);
+	}
+	for (int x = 0; x < n; x++) {
+		VECTOR_ID(set)(unique_v, x, elements[indices[start[x]]]);
+		std::size_t index = indices[start[x]];
+		for (int y = start[x]; y < start[x + 1]; y++) {
+			if (first_or_last == "first" ? indices[y] < index : indices[y] > index) {
+				index = indices[y];
 			}
+			if (j != NULL) {
+				VECTOR_ID(set)(*j, indices[y], (FP_T)x);
+			}
+		}
+		if (i != NULL) {
+			VECTOR_ID(set)(*i, x, (FP_T)index);
 		}
 	}
 	return unique_v;
@@ -929,54 +951,59 @@ MATRIX_T* MATLAB_NAMESPACE::unique_rows(const MATRIX_T* m, const std::string& fi
 	if (first_or_last != "first" && first_or_last != "last") {
 		return NULL;
 	}
-	MATRIX_T* sort_m = sortrows(m);
-	MATRIX_T* unsized_m = MATRIX_ID(alloc)(m->size1, m->size2);
-	VECTOR_ID(view) first_row = MATRIX_ID(row)(sort_m, 0);
-	MATRIX_ID(set_row)(unsized_m, 0, &first_row.vector);
-	int n_unique = 1;
-	for (int x = 1; x < (int)m->size1; x++) {
-		VECTOR_ID(view) sort_m_row_x_sub_1 = MATRIX_ID(row)(sort_m, x - 1);
-		VECTOR_ID(view) sort_m_row_x = MATRIX_ID(row)(sort_m, x);
-		if (compare_vectors(&sort_m_row_x_sub_1.vector, &sort_m_row_x.vector) != 0) {
-			MATRIX_ID(set_row)(unsized_m, n_unique++, &sort_m_row_x.vector);
+	int size = m->size1;
+	if (size == 0) {
+		return NULL;
+	}
+	std::vector<std::size_t> indices(size);
+	stable_sort_index(&indices[0], size, row_less(m));
+	std::vector<int> start(1, 0);
+	for (int x = 1; x < size; x++) {
+		if (compare_rows(m, indices[x - 1], indices[x]) != 0) {
+			start.push_back(x);
 		}
 	}
-	MATRIX_ID(free)(sort_m);
+	int n_unique = start.size();
+	start.push_back(size);
 	MATRIX_T* unique_m = MATRIX_ID(alloc)(n_unique, m->size2);
-	MATRIX_ID(view) unsized_subm = MATRIX_ID(submatrix)(unsized_m, 0, 0, n_unique, m->size2);
-	MATRIX_ID(memcpy)(unique_m, &unsized_subm.matrix);
-	MATRIX_ID(free)(unsized_m);
 	if (i != NULL) {
 		*i = VECTOR_ID(alloc)(n_unique);
-		for (int x = 0; x < n_unique; x++) {
-			VECTOR_ID(view) unique_m_row_x = MATRIX_ID(row)(unique_m, x);
-			for (int y = 0; y < (int)m->size1; y++) {
-				VECTOR_ID(const_view) m_row_y = MATRIX_ID(const_row)(m, y);
-				if (compare_vectors(&unique_m_row_x.vector, &m_row_y.vector) == 0) {
-					VECTOR_ID(set)(*i, x, y);
-					if (first_or_last == "first") {
-						break;
-					}
-				}
-			}
-		}
 	}
 	if (j != NULL) {
-		*j = VECTOR_ID(alloc)(m->size1);
-		for (int x = 0; x < (int)m->size1; x++) {
-			VECTOR_ID(const_view) m_row_x = MATRIX_ID(const_row)(m, x);
-			for (int y = 0; y < n_unique; y++) {
-				VECTOR_ID(view) unique_m_row_y = MATRIX_ID(row)(unique_m, y);
-				if (compare_vectors(&m_row_x.vector, &unique_m_row_y.vector) == 0) {
-					VECTOR_ID(set)(*j, x, y);
-					break;
-				}
+		*j = VECTOR_ID(alloc)(size);
+	}
+	for (int x = 0; x < n_unique; x++) {
+		VECTOR_ID(const_view) m_row = MATRIX_ID(const_row)(m, indices[start[x]]);
+		MATRIX_ID(set_row)(unique_m, x, &m_row.vector);
+		std::size_t index = indices[start[x]];
+		for (int y = start[x]; y < start[x + 1]; y++) {
+			if (first_or_last == "first" ? indices[y] < index : indices[y] > index) {
+				index = indices[y];
+			}
+			if (j != NULL) {
+				VECTOR_ID(set)(*j, indices[y], (FP_T)x);
 			}
 		}
+		if (i != NULL) {
+			VECTOR_ID(set)(*i, x, (FP_T)index);
+		}
 	}
 	return unique_m;
 }
 
+bool MATLAB_NAMESPACE::row_less::operator()(std::size_t i, std::size_t j) const {
+	return compare_rows(m, i, j) == -1;
+}
+
+/*
+ * Compares two rows of a matrix as compare_vectors does.
+ */
+int MATLAB_NAMESPACE::compare_rows(const MATRIX_T* m, std::size_t i, std::size_t j) {
+	VECTOR_ID(const_view) m_row_i = MATRIX_ID(const_row)(m, i);
+	VECTOR_ID(const_view) m_row_j = MATRIX_ID(const_row)(m, j);
+	return compare_vectors(&m_row_i.vector, &m_row_j.vector);
+}
+
 MATRIX_T* MATLAB_NAMESPACE::zeros(int size) {
 	return MATRIX_ID(calloc)(size, size);
 }
@@ -28,6 +28,7 @@
 
 #ifndef SKIP
 
+#include <cstddef>
 #include <gsl/gsl_matrix.h>
 #include <gsl/gsl_permutation.h>
 #include <gsl/gsl_rng.h>
@@ -134,6 +135,8 @@ namespace MATLAB_NAMESPACE {
 	// Floating-point comparison
 	extern FP_T epsilon;
 	int fp_compare(FP_T x, FP_T y);
+	void fp_compare(const FP_T* x, const FP_T* y, int n, int* result);
+	void fp_compare(const FP_T* x, FP_T y, int n, int* result);
 	bool fp_zero(FP_T x);
 	bool fp_nonzero(FP_T x);
 	bool fp_equal(FP_T x, FP_T y);
@@ -154,6 +157,9 @@ namespace MATLAB_NAMESPACE {
 	MATRIX_T* compare_elements(const MATRIX_T* m, comparator compare, FP_T x);
 	MATRIX_T* compare_elements(const MATRIX_T* m1, comparator compare, const MATRIX_T* m2);
 	
+	// Sorting
+	void argsort(const FP_T* x, std::size_t n, std::size_t* indices, bool descend = false);
+	
 	// Vector-by-vector indexing
 	VECTOR_T* ordinal_index(const VECTOR_T* v, const VECTOR_T* indices);
 	void ordinal_index_assign(VECTOR_T* v, const VECTOR_T* indices, FP_T value);
@@ -0,0 +1,316 @@
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+#include <vector>
+
+#include "matlab.h"
+
+namespace MATLAB_NAMESPACE {
+	
+	// Runs are insertion sorted in blocks of this size before being merged
+	const std::size_t insertion_sort_limit = 32;
+	
+	// Runs shorter than this are merge sorted rather than radix sorted
+	const std::size_t radix_sort_limit = 256;
+	
+	// Inputs at least this long are split into one run per thread, and the
+	// sorted runs are then merged
+	const std::size_t parallel_sort_limit = 1 << 16;
+	
+	inline uint32_t sort_key(float x);
+	inline uint64_t sort_key(double x);
+	inline long double sort_key(long double x);
+	inline uint32_t reverse_key(uint32_t key);
+	inline uint64_t reverse_key(uint64_t key);
+	inline long double reverse_key(long double key);
+	template<class K> void argsort_keys(const FP_T* x, std::size_t n, std::size_t* indices, bool descend, K);
+	template<class K> void sort_keys(K* keys, std::size_t* indices, std::size_t count);
+	void sort_run(uint32_t* keys, std::size_t* indices, std::size_t count, uint32_t* key_buffer, std::size_t* index_buffer);
+	void sort_run(uint64_t* keys, std::size_t* indices, std::size_t count, uint64_t* key_buffer, std::size_t* index_buffer);
+	void sort_run(long double* keys, std::size_t* indices, std::size_t count, long double* key_buffer, std::size_t* index_buffer);
+	template<class K> void radix_sort(K* keys, std::size_t* indices, std::size_t count, K* key_buffer, std::size_t* index_buffer);
+	template<class K> void merge_sort(K* keys, std::size_t* indices, std::size_t count, K* key_buffer, std::size_t* index_buffer);
+	template<class K> void merge_runs(const K* keys, const std::size_t* indices, std::size_t first, std::size_t middle, std::size_t last, K* key_out, std::size_t* index_out);
+}
+
+/*
+ * Fills indices with the permutation that stably sorts n elements, so that
+ * x[indices[0]], x[indices[1]], ... is in ascending (or descending) order.
+ * Elements are compared exactly rather than with fp_compare, equal elements
+ * keep their original order, and NaNs are placed last when ascending and first
+ * when descending, as in MATLAB.
+ *
+ * Single- and double-precision elements are radix sorted on unsigned integer
+ * keys that order the same way as the elements; long double elements are merge
+ * sorted.  Only keys and indices are moved.  Large inputs are split into runs
+ * that are sorted in parallel and then merged.
+ */
+void MATLAB_NAMESPACE::argsort(const FP_T* x, std::size_t n, std::size_t* indices, bool descend) {
+	argsort_keys(x, n, indices, descend, sort_key((FP_T)0.0));
+}
+
+/*
+ * Maps a float to an unsigned integer that sorts in the same order.  Negative
+ * numbers have all bits flipped and positive numbers have the sign bit set.
+ * Negative zero is first turned into positive zero so that the two are equal.
+ */
+inline uint32_t MATLAB_NAMESPACE::sort_key(float x) {
+	x += 0.0f;
+	uint32_t bits;
+	std::memcpy(&bits, &x, sizeof(bits));
+	uint32_t mask = -(bits >> 31) | ((uint32_t)1 << 31);
+	return bits ^ mask;
+}
+
+inline uint64_t MATLAB_NAMESPACE::sort_key(double x) {
+	x += 0.0;
+	uint64_t bits;
+	std::memcpy(&bits, &x, sizeof(bits));
+	uint64_t mask = -(bits >> 63) | ((uint64_t)1 << 63);
+	return bits ^ mask;
+}
+
+/*
+ * The layout of a long double is platform-dependent, so long doubles are their
+ * own keys and are compared directly.
+ */
+inline long double MATLAB_NAMESPACE::sort_key(long double x) {
+	return x;
+}
+
+/*
+ * Returns a key that sorts in the opposite order.
+ */
+inline uint32_t MATLAB_NAMESPACE::reverse_key(uint32_t key) {
+	return ~key;
+}
+
+inline uint64_t MATLAB_NAMESPACE::reverse_key(uint64_t key) {
+	return ~key;
+}
+
+inline long double MATLAB_NAMESPACE::reverse_key(long double key) {
+	return -key;
+}
+
+/*
+ * Sorts with keys of type K, which is given only to select the key type.
+ * NaNs have no place in the order of the keys, so they are set aside and their
+ * indices added at the end.
+ */
+template<class K> void MATLAB_NAMESPACE::argsort_keys(const FP_T* x, std::size_t n, std::size_t* indices, bool descend, K) {
+	std::vector<K> keys(n + 1);
+	std::vector<std::size_t> nan_indices;
+	std::size_t count = 0;
+	for (std::size_t i = 0; i < n; i++) {
+		if (x[i] != x[i]) {
+			nan_indices.push_back(i);
+		} else {
+			K key = sort_key(x[i]);
+			keys[count] = descend ? reverse_key(key) : key;
+			indices[count++] = i;
+		}
+	}
+	sort_keys(&keys[0], indices, count);
+	if (!nan_indices.empty()) {
+		if (descend) {
+			std::copy_backward(indices, indices + count, indices + n);
+			std::copy(nan_indices.begin(), nan_indices.end(), indices);
+		} else {
+			std::copy(nan_indices.begin(), nan_indices.end(), indices + count);
+		}
+	}
+}
+
+/*
+ * Stably sorts keys in ascending order, moving indices along with them.  With
+ * OpenMP, large inputs are split into one run per thread, and adjacent sorted
+ * runs are then merged in pairs until one remains.
+ */
+template<class K> void MATLAB_NAMESPACE::sort_keys(K* keys, std::size_t* indices, std::size_t count) {
+	std::vector<K> key_buffer(count + 1);
+	std::vector<std::size_t> index_buffer(count + 1);
+	int runs = 1;
+#ifdef _OPENMP
+	if (count >= parallel_sort_limit) {
+		runs = omp_get_max_threads();
+	}
+#endif
+	if (runs <= 1) {
+		sort_run(keys, indices, count, &key_buffer[0], &index_buffer[0]);
+		return;
+	}
+	std::vector<std::size_t> bounds(runs + 1);
+	for (int r = 0; r <= runs; r++) {
+		bounds[r] = count * r / runs;
+	}
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1)
+#endif
+	for (int r = 0; r < runs; r++) {
+		std::size_t first = bounds[r];
+		sort_run(&keys[first], &indices[first], bounds[r + 1] - first, &key_buffer[first], &index_buffer[first]);
+	}
+	K* key_in = keys;
+	std::size_t* index_in = indices;
+	K* key_out = &key_buffer[0];
+	std::size_t* index_out = &index_buffer[0];
+	while (runs > 1) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1)
+#endif
+		for (int r = 0; r < runs; r += 2) {
+			std::size_t middle = bounds[r + 1];
+			std::size_t last = (r + 1 < runs) ? bounds[r + 2] : middle;
+			merge_runs(key_in, index_in, bounds[r], middle, last, key_out, index_out);
+		}
+		std::vector<std::size_t> merged_bounds;
+		for (int r = 0; r < runs; r += 2) {
+			merged_bounds.push_back(bounds[r]);
+		}
+		merged_bounds.push_back(count);
+		bounds.swap(merged_bounds);
+		runs = bounds.size() - 1;
+		std::swap(key_in, key_out);
+		std::swap(index_in, index_out);
+	}
+	if (index_in != indices) {
+		std::copy(index_in, index_in + count, indices);
+	}
+}
+
+/*
+ * Sorts one run in place, using the buffers as scratch space.
+ */
+void MATLAB_NAMESPACE::sort_run(uint32_t* keys, std::size_t* indices, std::size_t count, uint32_t* key_buffer, std::size_t* index_buffer) {
+	if (count < radix_sort_limit) {
+		merge_sort(keys, indices, count, key_buffer, index_buffer);
+	} else {
+		radix_sort(keys, indices, count, key_buffer, index_buffer);
+	}
+}
+
+void MATLAB_NAMESPACE::sort_run(uint64_t* keys, std::size_t* indices, std::size_t count, uint64_t* key_buffer, std::size_t* index_buffer) {
+	if (count < radix_sort_limit) {
+		merge_sort(keys, indices, count, key_buffer, index_buffer);
+	} else {
+		radix_sort(keys, indices, count, key_buffer, index_buffer);
+	}
+}
+
+void MATLAB_NAMESPACE::sort_run(long double* keys, std::size_t* indices, std::size_t count, long double* key_buffer, std::size_t* index_buffer) {
+	merge_sort(keys, indices, count, key_buffer, index_buffer);
+}
+
+/*
+ * Performs a least-significant-digit radix sort on unsigned keys, one byte per
+ * pass.  The counts for every pass are taken in a single read of the keys, and
+ * passes over bytes that are the same in every key are skipped.
+ */
+template<class K> void MATLAB_NAMESPACE::radix_sort(K* keys, std::size_t* indices, std::size_t count, K* key_buffer, std::size_t* index_buffer) {
+	const int passes = sizeof(K);
+	std::vector<std::size_t> offsets(passes * 256, 0);
+	for (std::size_t i = 0; i < count; i++) {
+		K key = keys[i];
+		for (int pass = 0; pass < passes; pass++) {
+			offsets[pass * 256 + (int)((key >> (8 * pass)) & 0xff)]++;
+		}
+	}
+	K* key_in = keys;
+	std::size_t* index_in = indices;
+	K* key_out = key_buffer;
+	std::size_t* index_out = index_buffer;
+	for (int pass = 0; pass < passes; pass++) {
+		std::size_t* offset = &offsets[pass * 256];
+		int shift = 8 * pass;
+		if (offset[(int)((key_in[0] >> shift) & 0xff)] == count) {
+			continue;
+		}
+		std::size_t position = 0;
+		for (int digit = 0; digit < 256; digit++) {
+			std::size_t digit_count = offset[digit];
+			offset[digit] = position;
+			position += digit_count;
+		}
+		for (std::size_t i = 0; i < count; i++) {
+			std::size_t j = offset[(int)((key_in[i] >> shift) & 0xff)]++;
+			key_out[j] = key_in[i];
+			index_out[j] = index_in[i];
+		}
+		std::swap(key_in, key_out);
+		std::swap(index_in, index_out);
+	}
+	if (key_in != keys) {
+		std::copy(key_in, key_in + count, keys);
+		std::copy(index_in, index_in + count, indices);
+	}
+}
+
+/*
+ * Performs a bottom-up merge sort, insertion sorting small blocks first.
+ */
+template<class K> void MATLAB_NAMESPACE::merge_sort(K* keys, std::size_t* indices, std::size_t count, K* key_buffer, std::size_t* index_buffer) {
+	for (std::size_t first = 0; first < count; first += insertion_sort_limit) {
+		std::size_t last = std::min(first + insertion_sort_limit, count);
+		for (std::size_t i = first + 1; i < last; i++) {
+			K key = keys[i];
+			std::size_t index = indices[i];
+			std::size_t j = i;
+			for ( ; j > first && key < keys[j - 1]; j--) {
+				keys[j] = keys[j - 1];
+				indices[j] = indices[j - 1];
+			}
+			keys[j] = key;
+			indices[j] = index;
+		}
+	}
+	K* key_in = keys;
+	std::size_t* index_in = indices;
+	K* key_out = key_buffer;
+	std::size_t* index_out = index_buffer;
+	for (std::size_t width = insertion_sort_limit; width < count; width *= 2) {
+		for (std::size_t first = 0; first < count; first += 2 * width) {
+			std::size_t middle = std::min(first + width, count);
+			std::size_t last = std::min(first + 2 * width, count);
+			merge_runs(key_in, index_in, first, middle, last, key_out, index_out);
+		}
+		std::swap(key_in, key_out);
+		std::swap(index_in, index_out);
+	}
+	if (key_in != keys) {
+		std::copy(key_in, key_in + count, keys);
+		std::copy(index_in, index_in + count, indices);
+	}
+}
+
+/*
+ * Stably merges the sorted runs [first, middle) and [middle, last) into the
+ * same positions of the output arrays.
+ */
+template<class K> void MATLAB_NAMESPACE::merge_runs(const K* keys, const std::size_t* indices, std::size_t first, std::size_t middle, std::size_t last, K* key_out, std::size_t* index_out) {
+	std::size_t i = first;
+	std::size_t j = middle;
+	std::size_t k = first;
+	while (i < middle && j < last) {
+		if (keys[j] < keys[i]) {
+			key_out[k] = keys[j];
+			index_out[k++] = indices[j++];
+		} else {
+			key_out[k] = keys[i];
+			index_out[k++] = indices[i++];
+		}
+	}
+	for ( ; i < middle; i++) {
+		key_out[k] = keys[i];
+		index_out[k++] = indices[i];
+	}
+	for ( ; j < last; j++) {
+		key_out[k] = keys[j];
+		index_out[k++] = indices[j];
+	}
+}
@@ -5,68 +5,66 @@
 
 #include <algorithm>
 #include <cstddef>
-#include <vector>
 
 namespace MATLAB_NAMESPACE {
 	template<class T> void stable_sort(T*, std::size_t);
 	template<class T> void stable_sort(T*, std::size_t, bool (*)(T, T));
 	template<class T> void stable_sort_index(std::size_t*, const T*, std::size_t);
 	template<class T> void stable_sort_index(std::size_t*, const T*, std::size_t, bool (*)(T, T));
+	template<class Compare> void stable_sort_index(std::size_t*, std::size_t, Compare);
 }
 
-template <class T1, class T2> struct transparent_pair {
-	T1 first;
-	T2 second;
-	transparent_pair(const T1& x, const T2& y) : first(x), second(y) { }
-	operator T1() const { return first; }
+/*
+ * Compares two indices by the array elements they refer to, so that indirect
+ * sorts can move indices without copying elements.
+ */
+template<class T> struct index_less {
+	const T* array;
+	bool (*compare)(T, T);
+	index_less(const T* array, bool (*compare)(T, T)) : array(array), compare(compare) { }
+	bool operator()(std::size_t i, std::size_t j) const {
+		return (compare == NULL) ? array[i] < array[j] : compare(array[i], array[j]);
+	}
 };
 
 /*
  * Performs an in-place stable sort.
  */
 template<class T> void MATLAB_NAMESPACE::stable_sort(T* array, std::size_t count) {
-	std::vector<T> v;
-	v.assign(array, array + count);
-	std::stable_sort(v.begin(), v.end());
-	std::copy(v.begin(), v.end(), array);
+	std::stable_sort(array, array + count);
 }
 
 /*
  * Performs an in-place stable sort using a custom comparison function.
  */
 template<class T> void MATLAB_NAMESPACE::stable_sort(T* array, std::size_t count, bool (*compare)(T, T)) {
-	std::vector<T> v;
-	v.assign(array, array + count);
-	std::stable_sort(v.begin(), v.end(), compare);
-	std::copy(v.begin(), v.end(), array);
+	std::stable_sort(array, array + count, compare);
 }
 
 /*
  * Performs an indirect stable sort.
  */
 template<class T> void MATLAB_NAMESPACE::stable_sort_index(std::size_t* indices, const T* array, std::size_t count) {
-	std::vector<transparent_pair<T, std::size_t> > v;
-	for (std::size_t i = 0; i < count; i++) {
-		v.push_back(transparent_pair<T, std::size_t>(array[i], i));
-	}
-	std::stable_sort(v.begin(), v.end());
-	for (std::size_t i = 0; i < count; i++) {
-		indices[i] = v[i].second;
-	}
+	stable_sort_index(indices, count, index_less<T>(array, NULL));
 }
 
 /*
  * Performs an indirect stable sort using a custom comparison function.
  */
 template<class T> void MATLAB_NAMESPACE::stable_sort_index(std::size_t* indices, const T* array, std::size_t count, bool (*compare)(T, T)) {
-	std::vector<transparent_pair<T, std::size_t> > v;
-	for (std::size_t i = 0; i < count; i++) {
-		v.push_back(transparent_pair<T, std::size_t>(array[i], i));
-	}
-	std::stable_sort(v.begin(), v.end(), compare);
+	stable_sort_index(indices, count, index_less<T>(array, compare));
+}
+
+/*
+ * Fills indices with the permutation that stably sorts the integers 0 to
+ * (count - 1) under a comparison object that takes two indices.  Only the
+ * indices are moved.
+ */
+template<class Compare> void MATLAB_NAMESPACE::stable_sort_index(std::size_t* indices, std::size_t count, Compare compare) {
 	for (std::size_t i = 0; i < count; i++) {
-		indices[i] = v[i].second;
+		indices[i] = i;
 	}
+	std::stable_sort(indices, indices + count, compare);
 }
 
 #endif
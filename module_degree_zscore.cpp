@@ -2,6 +2,10 @@
 
 #include "bct.h"
 
+namespace BCT_NAMESPACE {
+	VECTOR_T* module_degree_zscore_from_strength(const MATRIX_T* S, const VECTOR_T* Ci);
+}
+
 /*
  * Computes z-score for a binary graph and its corresponding community
  * structure.  For a directed graph, computes out-neighbor z-score.
@@ -9,30 +13,69 @@
 VECTOR_T* BCT_NAMESPACE::module_degree_zscore(const MATRIX_T* A, const VECTOR_T* Ci) {
 	if (safe_mode) check_status(A, SQUARE | BINARY, "module_degree_zscore");
 	
+	MATRIX_T* S = module_strength(A, Ci);
+	VECTOR_T* Z = module_degree_zscore_from_strength(S, Ci);
+	if (S != NULL) {
+		MATRIX_ID(free)(S);
+	}
+	return Z;
+}
+
+/*
+ * Computes z-score using the community structure and module strengths cached
+ * by a context.
+ */
+VECTOR_T* BCT_NAMESPACE::module_degree_zscore(graph_context* context) {
+	if (safe_mode) check_status(context->W, SQUARE | BINARY, "module_degree_zscore");
+	return module_degree_zscore_from_strength(context_module_strength(context), context_modules(context));
+}
+
+/*
+ * Given the strength of each node's connections to each module (as returned by
+ * module_strength) and community structure, computes z-score.
+ */
+VECTOR_T* BCT_NAMESPACE::module_degree_zscore_from_strength(const MATRIX_T* S, const VECTOR_T* Ci) {
 	// n=length(A);
-	int n = length(A);
+	int n = Ci->size;
 	
 	// Z=zeros(n,1);
 	VECTOR_T* Z = zeros_vector(n);
 	
+	if (S == NULL) {
+		return Z;
+	}
+	int* nodes = new int[n];
+	
 	// for i=1:max(Ci)
-	for (int i = 1; i <= (int)max(Ci); i++) {
+	for (int i = 1; i <= (int)S->size2; i++) {
+		int size = 0;
+		for (int j = 0; j < n; j++) {
+			if (fp_equal(VECTOR_ID(get)(Ci, j), (FP_T)i)) {
+				nodes[size++] = j;
+			}
+		}
+		if (size == 0) {
+			continue;
+		}
 		
 		// Koi=sum(A(Ci==i,Ci==i),2);
-		VECTOR_T* Ci_eq_i = compare_elements(Ci, fp_equal, (FP_T)i);
-		MATRIX_T* A_idx = logical_index(A, Ci_eq_i, Ci_eq_i);
-		VECTOR_T* Koi = sum(A_idx, 2);
-		MATRIX_ID(free)(A_idx);
+		VECTOR_T* Koi = VECTOR_ID(alloc)(size);
+		for (int k = 0; k < size; k++) {
+			VECTOR_ID(set)(Koi, k, MATRIX_ID(get)(S, nodes[k], i - 1));
+		}
 		
 		// Z(Ci==i)=(Koi-mean(Koi))./std(Koi);
 		FP_T std_Koi = MATLAB_NAMESPACE::std(Koi);
 		VECTOR_ID(add_constant)(Koi, -mean(Koi));
 		VECTOR_ID(scale)(Koi, 1.0 / std_Koi);
-		logical_index_assign(Z, Ci_eq_i, Koi);
-		VECTOR_ID(free)(Ci_eq_i);
+		for (int k = 0; k < size; k++) {
+			VECTOR_ID(set)(Z, nodes[k], VECTOR_ID(get)(Koi, k));
+		}
 		VECTOR_ID(free)(Koi);
 	}
 	
+	delete[] nodes;
+	
 	// Z(isnan(Z))=0;
 	for (int i = 0; i < (int)Z->size; i++) {
 		if (gsl_isnan(VECTOR_ID(get)(Z, i)) == 1) {
@@ -0,0 +1,96 @@
+#include <cmath>
+
+#include "bct.h"
+
+namespace BCT_NAMESPACE {
+	int* module_indices(const VECTOR_T* Ci, int modules);
+	int module_index(FP_T label, int modules);
+}
+
+/*
+ * Computes the strength of each node's connections to each module.  Element
+ * (i,c) of the returned matrix is the sum of W(i,j) over all nodes j with
+ * Ci(j) = c + 1; for a directed graph, only out-connections are counted.
+ * Module indices are the values of Ci from 1 to max(Ci), and nodes with any
+ * other value belong to no module.  Returns NULL if there are no modules.
+ *
+ * Only nonzero connections are visited, so for an adjacency list the cost is
+ * proportional to the number of edges plus the size of the table.  An
+ * adjacency list omits weights within machine epsilon of zero, so its result
+ * agrees with that of the matrix version only up to such weights.  Rows are
+ * computed in parallel.
+ */
+MATRIX_T* BCT_NAMESPACE::module_strength(const MATRIX_T* W, const VECTOR_T* Ci) {
+	if (safe_mode) check_status(W, SQUARE, "module_strength");
+	int n = W->size1;
+	int modules = (int)max(Ci);
+	if (modules < 1) {
+		return NULL;
+	}
+	int* module = module_indices(Ci, modules);
+	MATRIX_T* S = zeros(n, modules);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+	for (int i = 0; i < n; i++) {
+		const FP_T* W_row = MATRIX_ID(const_ptr)(W, i, 0);
+		FP_T* S_row = MATRIX_ID(ptr)(S, i, 0);
+		for (int j = 0; j < n; j++) {
+			int c = module[j];
+			if (c >= 0 && W_row[j] != 0.0) {
+				S_row[c] += W_row[j];
+			}
+		}
+	}
+	delete[] module;
+	return S;
+}
+
+MATRIX_T* BCT_NAMESPACE::module_strength(const adjacency_list* adj, const VECTOR_T* Ci) {
+	int n = adj->size;
+	int modules = (int)max(Ci);
+	if (modules < 1) {
+		return NULL;
+	}
+	int* module = module_indices(Ci, modules);
+	MATRIX_T* S = zeros(n, modules);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+	for (int i = 0; i < n; i++) {
+		FP_T* S_row = MATRIX_ID(ptr)(S, i, 0);
+		for (int k = adj->offsets[i]; k < adj->offsets[i + 1]; k++) {
+			int c = module[adj->nodes[k]];
+			if (c >= 0) {
+				S_row[c] += adj->weights[k];
+			}
+		}
+	}
+	delete[] module;
+	return S;
+}
+
+/*
+ * Returns a new array holding the module index of each node, as given by
+ * module_index.
+ */
+int* BCT_NAMESPACE::module_indices(const VECTOR_T* Ci, int modules) {
+	int n = Ci->size;
+	int* module = new int[n];
+	for (int j = 0; j < n; j++) {
+		module[j] = module_index(VECTOR_ID(get)(Ci, j), modules);
+	}
+	return module;
+}
+
+/*
+ * Returns the zero-based module index of a node with the given community
+ * label, or -1 if the label is not an integer from 1 to the number of modules.
+ */
+int BCT_NAMESPACE::module_index(FP_T label, int modules) {
+	int c = (int)std::floor(label + 0.5);
+	if (c < 1 || c > modules || fp_not_equal(label, (FP_T)c)) {
+		return -1;
+	}
+	return c - 1;
+}
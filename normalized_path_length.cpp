@@ -51,19 +51,32 @@ FP_T BCT_NAMESPACE::normalized_path_length_m(const MATRIX_T* L, FP_T wmax) {
 		}
 	}
 	lmean /= nonzeros;
-	MATRIX_T* D = distance_wei(L);
+	adjacency_list* adj = to_adjacency_list(L);
 	FP_T dmin = 1.0 / wmax;
 	FP_T dmax = (FP_T)N * lmean;
 	FP_T sum = 0.0;
-	for (int i = 0; i < N; i++) {
-		for (int j = 0; j < N; j++) {
-			if (i == j) {
-				continue;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+	{
+		VECTOR_T* D_row = VECTOR_ID(alloc)(N);
+		distance_wei_workspace* ws = distance_wei_workspace_alloc(N);
+#ifdef _OPENMP
+#pragma omp for reduction(+:sum)
+#endif
+		for (int i = 0; i < N; i++) {
+			distance_wei_row(adj, i, D_row, ws);
+			for (int j = 0; j < N; j++) {
+				if (i == j) {
+					continue;
+				}
+				FP_T d = VECTOR_ID(get)(D_row, j);
+				sum += (d < dmax) ? d : dmax;
 			}
-			FP_T d = MATRIX_ID(get)(D, i, j);
-			sum += (d < dmax) ? d : dmax;
 		}
+		VECTOR_ID(free)(D_row);
+		distance_wei_workspace_free(ws);
 	}
-	MATRIX_ID(free)(D);
+	adjacency_list_free(adj);
 	return std::abs(((sum / (FP_T)(N * (N - 1))) - dmin) / (dmax - dmin));
 }
@@ -0,0 +1,153 @@
+#include <vector>
+
+#include "bct.h"
+
+namespace BCT_NAMESPACE {
+	long packed_matrix_index(int size, int i, int j);
+}
+
+/*
+ * Allocates a packed symmetric matrix with every element set to zero.  Only
+ * the upper triangle, including the main diagonal, is stored: row i holds
+ * elements (i,i) through (i,size-1), and rows are stored one after another.
+ * Element (i,j) and element (j,i) are the same element, so an undirected graph
+ * takes half the memory of a full matrix and is always symmetric.
+ */
+BCT_NAMESPACE::packed_matrix* BCT_NAMESPACE::packed_matrix_alloc(int size) {
+	packed_matrix* m = new packed_matrix;
+	m->size = size;
+	long elements = (long)size * (size + 1) / 2;
+	m->data = new FP_T[(elements > 0) ? elements : 1];
+	for (long k = 0; k < elements; k++) {
+		m->data[k] = 0.0;
+	}
+	return m;
+}
+
+/*
+ * Frees a packed symmetric matrix.
+ */
+void BCT_NAMESPACE::packed_matrix_free(packed_matrix* m) {
+	if (m == NULL) {
+		return;
+	}
+	delete[] m->data;
+	delete m;
+}
+
+/*
+ * Returns the element at (i,j), which is also the element at (j,i).
+ */
+FP_T BCT_NAMESPACE::packed_matrix_get(const packed_matrix* m, int i, int j) {
+	return m->data[packed_matrix_index(m->size, i, j)];
+}
+
+/*
+ * Sets the element at (i,j) and (j,i).
+ */
+void BCT_NAMESPACE::packed_matrix_set(packed_matrix* m, int i, int j, FP_T value) {
+	m->data[packed_matrix_index(m->size, i, j)] = value;
+}
+
+/*
+ * Returns a pointer to element (i,i), which is followed by the rest of row i
+ * of the upper triangle, elements (i,i+1) through (i,size-1).
+ */
+FP_T* BCT_NAMESPACE::packed_matrix_row(packed_matrix* m, int i) {
+	return &m->data[packed_matrix_index(m->size, i, i)];
+}
+
+const FP_T* BCT_NAMESPACE::packed_matrix_const_row(const packed_matrix* m, int i) {
+	return &m->data[packed_matrix_index(m->size, i, i)];
+}
+
+/*
+ * Packs the upper triangle of a symmetric matrix.
+ */
+BCT_NAMESPACE::packed_matrix* BCT_NAMESPACE::to_packed_matrix(const MATRIX_T* m) {
+	if (safe_mode) check_status(m, SQUARE | UNDIRECTED, "to_packed_matrix");
+	int N = m->size1;
+	packed_matrix* packed_m = packed_matrix_alloc(N);
+	for (int i = 0; i < N; i++) {
+		FP_T* row = packed_matrix_row(packed_m, i);
+		for (int j = i; j < N; j++) {
+			row[j - i] = MATRIX_ID(get)(m, i, j);
+		}
+	}
+	return packed_m;
+}
+
+/*
+ * Unpacks a packed symmetric matrix into a full matrix.
+ */
+MATRIX_T* BCT_NAMESPACE::packed_matrix_to_matrix(const packed_matrix* m) {
+	int N = m->size;
+	MATRIX_T* ret = MATRIX_ID(alloc)(N, N);
+	for (int i = 0; i < N; i++) {
+		const FP_T* row = packed_matrix_const_row(m, i);
+		for (int j = i; j < N; j++) {
+			MATRIX_ID(set)(ret, i, j, row[j - i]);
+			MATRIX_ID(set)(ret, j, i, row[j - i]);
+		}
+	}
+	return ret;
+}
+
+/*
+ * Converts a packed symmetric matrix to an adjacency list, as to_adjacency_list
+ * does for the corresponding full matrix.  Neighbors of node i below the
+ * diagonal are gathered from the rows of the upper triangle above row i.
+ */
+BCT_NAMESPACE::adjacency_list* BCT_NAMESPACE::to_adjacency_list(const packed_matrix* m) {
+	int N = m->size;
+	std::vector<int> degree(N, 0);
+	int edges = 0;
+	for (int i = 0; i < N; i++) {
+		const FP_T* row = packed_matrix_const_row(m, i);
+		for (int j = i; j < N; j++) {
+			if (fp_nonzero(row[j - i])) {
+				degree[i]++;
+				edges++;
+				if (j != i) {
+					degree[j]++;
+					edges++;
+				}
+			}
+		}
+	}
+	adjacency_list* adj = adjacency_list_alloc(N, edges);
+	for (int i = 0; i < N; i++) {
+		adj->offsets[i + 1] = adj->offsets[i] + degree[i];
+	}
+	
+	// Filling row j in order of i visits its neighbors in increasing order,
+	// first those below the diagonal and then those on or above it
+	std::vector<int> position(adj->offsets, adj->offsets + N);
+	for (int i = 0; i < N; i++) {
+		const FP_T* row = packed_matrix_const_row(m, i);
+		for (int j = i; j < N; j++) {
+			FP_T value = row[j - i];
+			if (fp_nonzero(value)) {
+				adj->nodes[position[i]] = j;
+				adj->weights[position[i]++] = value;
+				if (j != i) {
+					adj->nodes[position[j]] = i;
+					adj->weights[position[j]++] = value;
+				}
+			}
+		}
+	}
+	return adj;
+}
+
+/*
+ * Returns the position of element (i,j) in the packed data.
+ */
+long BCT_NAMESPACE::packed_matrix_index(int size, int i, int j) {
+	if (i > j) {
+		int temp = i;
+		i = j;
+		j = temp;
+	}
+	return (long)i * size - (long)i * (i - 1) / 2 + (j - i);
+}
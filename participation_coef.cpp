@@ -2,6 +2,10 @@
 
 #include "bct.h"
 
+namespace BCT_NAMESPACE {
+	VECTOR_T* participation_coef_from_strength(const MATRIX_T* S, const VECTOR_T* Ko);
+}
+
 /*
  * Computes nodal participation coefficient and community structure.  For a
  * directed graph, computes "out-neighbor" participation coefficient.
@@ -9,51 +13,55 @@
 VECTOR_T* BCT_NAMESPACE::participation_coef(const MATRIX_T* W, const VECTOR_T* Ci) {
 	if (safe_mode) check_status(W, SQUARE | BINARY, "participation_coef");
 	
-	// n=length(W);
-	int n = length(W);
-	
 	// Ko=sum(W,2);
 	VECTOR_T* Ko = sum(W, 2);
 	
 	// Gc=(W~=0)*diag(Ci);
-	MATRIX_T* W_neq_0 = compare_elements(W, fp_not_equal, 0.0);
-	MATRIX_T* diag_Ci = diag(Ci);
-	MATRIX_T* Gc = mul(W_neq_0, diag_Ci);
-	MATRIX_ID(free)(W_neq_0);
-	MATRIX_ID(free)(diag_Ci);
+	MATRIX_T* S = module_strength(W, Ci);
+	VECTOR_T* P = participation_coef_from_strength(S, Ko);
+	VECTOR_ID(free)(Ko);
+	if (S != NULL) {
+		MATRIX_ID(free)(S);
+	}
+	return P;
+}
+
+/*
+ * Computes participation coefficient using the community structure, module
+ * strengths, and out-strengths cached by a context.
+ */
+VECTOR_T* BCT_NAMESPACE::participation_coef(graph_context* context) {
+	if (safe_mode) check_status(context->W, SQUARE | BINARY, "participation_coef");
+	return participation_coef_from_strength(context_module_strength(context), context_basic_stats(context)->os);
+}
+
+/*
+ * Given the strength of each node's connections to each module (as returned by
+ * module_strength) and each node's total strength, computes participation
+ * coefficient.
+ */
+VECTOR_T* BCT_NAMESPACE::participation_coef_from_strength(const MATRIX_T* S, const VECTOR_T* Ko) {
+	int n = Ko->size;
 	
 	// Kc2=zeros(n,1);
-	VECTOR_T* Kc2 = zeros_vector(n);
-	
 	// for i=1:max(Ci);
-	for (int i = 1; i <= (int)max(Ci); i++) {
-		
-		// Kc2=Kc2+(sum(W.*(Gc==i),2).^2);
-		MATRIX_T* Gc_eq_i = compare_elements(Gc, fp_equal, (FP_T)i);
-		MATRIX_T* W_mul_Gc_eq_i = copy(W);
-		MATRIX_ID(mul_elements)(W_mul_Gc_eq_i, Gc_eq_i);
-		MATRIX_ID(free)(Gc_eq_i);
-		VECTOR_T* sum_W_mul_Gc_eq_i = sum(W_mul_Gc_eq_i, 2);
-		MATRIX_ID(free)(W_mul_Gc_eq_i);
-		VECTOR_T* sum_W_mul_Gc_eq_i_pow_2 = pow_elements(sum_W_mul_Gc_eq_i, 2.0);
-		VECTOR_ID(free)(sum_W_mul_Gc_eq_i);
-		VECTOR_ID(add)(Kc2, sum_W_mul_Gc_eq_i_pow_2);
-		VECTOR_ID(free)(sum_W_mul_Gc_eq_i_pow_2);
-	}
-	
-	MATRIX_ID(free)(Gc);
-	
+	// Kc2=Kc2+(sum(W.*(Gc==i),2).^2);
 	// P=ones(n,1)-Kc2./(Ko.^2);
-	VECTOR_T* Ko_pow_2 = pow_elements(Ko, 2.0);
-	VECTOR_ID(div)(Kc2, Ko_pow_2);
-	VECTOR_ID(free)(Ko_pow_2);
-	VECTOR_T* P = ones_vector(n);
-	VECTOR_ID(sub)(P, Kc2);
-	VECTOR_ID(free)(Kc2);
+	VECTOR_T* P = VECTOR_ID(alloc)(n);
+	for (int j = 0; j < n; j++) {
+		FP_T Kc2 = 0.0;
+		if (S != NULL) {
+			for (int i = 0; i < (int)S->size2; i++) {
+				FP_T Kc = MATRIX_ID(get)(S, j, i);
+				Kc2 += Kc * Kc;
+			}
+		}
+		FP_T Ko_j = VECTOR_ID(get)(Ko, j);
+		VECTOR_ID(set)(P, j, 1.0 - Kc2 / (Ko_j * Ko_j));
+	}
 	
 	// P(~Ko)=0;
 	VECTOR_T* not_Ko = logical_not(Ko);
-	VECTOR_ID(free)(Ko);
 	logical_index_assign(P, not_Ko, 0.0);
 	VECTOR_ID(free)(not_Ko);
 	
@@ -1,4 +1,5 @@
 #undef FP_T
+#undef ACC_T
 #undef FP_ID
 #undef VECTOR_T
 #undef VECTOR_ID
@@ -9,6 +10,7 @@
 #define MATLAB_NAMESPACE matlab_float
 #define BCT_NAMESPACE bct_float
 #define FP_T float
+#define ACC_T double
 #define FP_ID(id) id##_##float
 #define VECTOR_T gsl_vector_float
 #define VECTOR_ID(id) gsl_vector_float##_##id
@@ -22,6 +24,7 @@
 #define MATLAB_NAMESPACE matlab
 #define BCT_NAMESPACE bct
 #define FP_T double
+#define ACC_T double
 #define FP_ID(id) id##_##double
 #define VECTOR_T gsl_vector
 #define VECTOR_ID(id) gsl_vector##_##id
@@ -35,6 +38,7 @@
 #define MATLAB_NAMESPACE matlab_long_double
 #define BCT_NAMESPACE bct_long_double
 #define FP_T long double
+#define ACC_T long double
 #define FP_ID(id) id##_##long_double
 #define VECTOR_T gsl_vector_long_double
 #define VECTOR_ID(id) gsl_vector_long_double##_##id
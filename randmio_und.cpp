@@ -1,3 +1,5 @@
+#include <vector>
+
 #include "bct.h"
 
 /*
@@ -112,3 +114,120 @@ MATRIX_T* BCT_NAMESPACE::randmio_und(const MATRIX_T* R, int ITER) {
 	MATRIX_ID(free)(find_tril_R);
 	return _R;
 }
+
+/*
+ * Returns a randomized graph with equivalent degree sequence to the original
+ * weighted undirected graph, stored as a packed symmetric matrix.  Edges are
+ * listed and drawn in the same order as in the full matrix version, so both
+ * versions give the same graph for the same random number generator state
+ * unless the graph has self-connections.
+ */
+BCT_NAMESPACE::packed_matrix* BCT_NAMESPACE::randmio_und(const packed_matrix* R, int ITER) {
+	gsl_rng* rng = get_rng();
+	int N = R->size;
+	
+	// [i j]=find(tril(R));
+	std::vector<int> i;
+	std::vector<int> j;
+	for (int row = 0; row < N; row++) {
+		const FP_T* R_row = packed_matrix_const_row(R, row);
+		for (int column = row; column < N; column++) {
+			if (fp_nonzero(R_row[column - row])) {
+				i.push_back(column);
+				j.push_back(row);
+			}
+		}
+	}
+	
+	// K=length(i);
+	int K = i.size();
+	
+	// ITER=K*ITER;
+	ITER = K * ITER;
+	
+	packed_matrix* _R = packed_matrix_alloc(N);
+	long elements = (long)N * (N + 1) / 2;
+	for (long k = 0; k < elements; k++) {
+		_R->data[k] = R->data[k];
+	}
+	
+	// for iter=1:ITER
+	for (int iter = 1; iter <= ITER; iter++) {
+		
+		// while 1
+		while (true) {
+			
+			int e1, e2;
+			int a, b, c, d;
+			
+			// while 1
+			while (true) {
+				
+				// e1=ceil(K*rand);
+				e1 = gsl_rng_uniform_int(rng, K);
+				
+				// e2=ceil(K*rand);
+				e2 = gsl_rng_uniform_int(rng, K);
+				
+				// while (e2==e1),
+				while (e2 == e1) {
+					
+					// e2=ceil(K*rand);
+					e2 = gsl_rng_uniform_int(rng, K);
+				}
+				
+				// a=i(e1); b=j(e1);
+				a = i[e1];
+				b = j[e1];
+				
+				// c=i(e2); d=j(e2);
+				c = i[e2];
+				d = j[e2];
+				
+				// if all(a~=[c d]) && all(b~=[c d]);
+				if (a != c && a != d && b != c && b != d) {
+					
+					// break
+					break;
+				}
+			}
+			
+			// if rand>0.5
+			if (gsl_rng_uniform(rng) > 0.5) {
+				
+				// i(e2)=d; j(e2)=c;
+				i[e2] = d;
+				j[e2] = c;
+				
+				// c=i(e2); d=j(e2);
+				c = i[e2];
+				d = j[e2];
+			}
+			
+			// if ~(R(a,d) || R(c,b))
+			if (fp_zero(packed_matrix_get(_R, a, d)) && fp_zero(packed_matrix_get(_R, c, b))) {
+				
+				// R(a,d)=R(a,b); R(a,b)=0;
+				// R(d,a)=R(b,a); R(b,a)=0;
+				packed_matrix_set(_R, a, d, packed_matrix_get(_R, a, b));
+				packed_matrix_set(_R, a, b, 0.0);
+				
+				// R(c,b)=R(c,d); R(c,d)=0;
+				// R(b,c)=R(d,c); R(d,c)=0;
+				packed_matrix_set(_R, c, b, packed_matrix_get(_R, c, d));
+				packed_matrix_set(_R, c, d, 0.0);
+				
+				// j(e1) = d;
+				j[e1] = d;
+				
+				// j(e2) = b;
+				j[e2] = b;
+				
+				// break;
+				break;
+			}
+		}
+	}
+	
+	return _R;
+}
@@ -1,138 +1,230 @@
 #include <gsl/gsl_math.h>
+#include <vector>
 
 #include "bct.h"
 
-void reachdist2(const MATRIX_T*, MATRIX_T**, MATRIX_T**, MATRIX_T**, int, int*, VECTOR_T*, VECTOR_T*);
+namespace BCT_NAMESPACE {
+	void reachdist_batch(const adjacency_list* adj, int first, int count, MATRIX_T* R, MATRIX_T* D,
+						 std::vector<unsigned long>& visited, std::vector<unsigned long>& frontier, std::vector<unsigned long>& next);
+}
 
 /*
  * Computes reachability and distance matrices based on the power of the
  * adjacency matrix.
+ *
+ * Rather than raising the adjacency matrix to successive powers, this runs a
+ * breadth-first search from a word's worth of sources at a time, keeping one
+ * bit per source for every node.  R(i,j) is 1 if there is a path of length at
+ * least one from i to j (so R(i,i) is 1 only if i lies on a cycle), and D(i,j)
+ * is the length of the shortest such path, or Inf if there is none.  As in the
+ * MATLAB version, direct connections have distance 2 - CIJ(i,j), which is 1 for
+ * binary graphs.  Use reachability if only R is needed.
  */
 MATRIX_T* BCT_NAMESPACE::reachdist(const MATRIX_T* CIJ, MATRIX_T** D) {
 	if (safe_mode) check_status(CIJ, SQUARE, "reachdist");
 	
-	// R = CIJ;
-	MATRIX_T* R = copy(CIJ);
-	
-	// D = CIJ;
-	if (D != NULL) {
-		*D = copy(CIJ);
-	}
-	
-	// powr = 2;
-	int powr = 2;
-	
 	// N = size(CIJ,1);
 	int N = CIJ->size1;
 	
-	// CIJpwr = CIJ;
-	MATRIX_T* CIJpwr = copy(CIJ);
-	
-	// id = sum(CIJ,1);
-	VECTOR_T* id = sum(CIJ, 1);
-	
-	// od = sum(CIJ,2)';
-	VECTOR_T* od = sum(CIJ, 2);
-	
-	// id_0 = find(id==0);
-	VECTOR_T* id_eq_0 = compare_elements(id, fp_equal, 0.0);
-	VECTOR_ID(free)(id);
-	VECTOR_T* id_0 = find(id_eq_0);
-	VECTOR_ID(free)(id_eq_0);
-	
-	// od_0 = find(od==0);
-	VECTOR_T* od_eq_0 = compare_elements(od, fp_equal, 0.0);
-	VECTOR_ID(free)(od);
-	VECTOR_T* od_0 = find(od_eq_0);
-	VECTOR_ID(free)(od_eq_0);
-	
-	// col = setxor(1:N,id_0);
-	VECTOR_T* i_all = sequence(0, N - 1);
-	VECTOR_T* col = setxor(i_all, id_0);
-	
-	// row = setxor(1:N,od_0);
-	VECTOR_T* row = setxor(i_all, od_0);
-	VECTOR_ID(free)(i_all);
-	
-	// [R,D,powr] = reachdist2(CIJ,CIJpwr,R,D,N,powr,col,row);
-	reachdist2(CIJ, &CIJpwr, &R, D, N, &powr, col, row);
-	MATRIX_ID(free)(CIJpwr);
-	if (col != NULL) {
-		VECTOR_ID(free)(col);
-	}
-	if (row != NULL) {
-		VECTOR_ID(free)(row);
+	if (D == NULL) {
+		bit_matrix* R_bits = reachability(CIJ);
+		MATRIX_T* R = bit_matrix_to_matrix(R_bits);
+		bit_matrix_free(R_bits);
+		return R;
 	}
 	
-	if (D != NULL) {
-		
-		// D = powr - D+1;
-		MATRIX_ID(scale)(*D, -1.0);
-		MATRIX_ID(add_constant)(*D, (FP_T)(powr + 1));
-		
-		// D(D==(N+2)) = Inf;
-		MATRIX_T* D_eq_N_add_2 = compare_elements(*D, fp_equal, (FP_T)(N + 2));
-		logical_index_assign(*D, D_eq_N_add_2, GSL_POSINF);
-		MATRIX_ID(free)(D_eq_N_add_2);
-		
-		// D(:,id_0) = Inf;
-		VECTOR_T* D_rows_cols = sequence(0, N - 1);
-		if (id_0 != NULL) {
-			ordinal_index_assign(*D, D_rows_cols, id_0, GSL_POSINF);
-		}
-		
-		// D(od_0,:) = Inf;
-		if (od_0 != NULL) {
-			ordinal_index_assign(*D, od_0, D_rows_cols, GSL_POSINF);
+	adjacency_list* adj = to_adjacency_list(CIJ);
+	MATRIX_T* R = zeros(N);
+	*D = MATRIX_ID(alloc)(N, N);
+	MATRIX_ID(set_all)(*D, GSL_POSINF);
+	int batches = (N + bit_matrix_word_bits - 1) / bit_matrix_word_bits;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+	{
+		std::vector<unsigned long> visited(N);
+		std::vector<unsigned long> frontier(N);
+		std::vector<unsigned long> next(N);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+		for (int batch = 0; batch < batches; batch++) {
+			int first = batch * bit_matrix_word_bits;
+			int count = (first + bit_matrix_word_bits <= N) ? bit_matrix_word_bits : N - first;
+			reachdist_batch(adj, first, count, R, *D, visited, frontier, next);
 		}
-		VECTOR_ID(free)(D_rows_cols);
 	}
 	
-	if (id_0 != NULL) {
-		VECTOR_ID(free)(id_0);
+	// Direct connections count their weight in the first power of CIJ
+	for (int i = 0; i < N; i++) {
+		for (int k = adj->offsets[i]; k < adj->offsets[i + 1]; k++) {
+			MATRIX_ID(set)(*D, i, adj->nodes[k], 2.0 - adj->weights[k]);
+		}
 	}
-	if (od_0 != NULL) {
-		VECTOR_ID(free)(od_0);
+	
+	adjacency_list_free(adj);
+	return R;
+}
+
+/*
+ * Computes the reachability matrix R of reachdist as bits.
+ */
+BCT_NAMESPACE::bit_matrix* BCT_NAMESPACE::reachability(const MATRIX_T* CIJ) {
+	if (safe_mode) check_status(CIJ, SQUARE, "reachability");
+	adjacency_list* adj = to_adjacency_list(CIJ);
+	bit_matrix* R = reachability(adj);
+	adjacency_list_free(adj);
+	return R;
+}
+
+/*
+ * Computes the reachability matrix R of reachdist as bits, for graphs too large
+ * to store as dense matrices.  The graph is condensed into its strongly
+ * connected components, which Tarjan's algorithm finds in reverse topological
+ * order.  The row of each component is then the union of the rows (and nodes)
+ * of the components it connects to, computed a word at a time.  All nodes in a
+ * component share the same row, which includes the component itself if it has
+ * more than one node or a loop.
+ */
+BCT_NAMESPACE::bit_matrix* BCT_NAMESPACE::reachability(const adjacency_list* adj) {
+	int N = adj->size;
+	bit_matrix* R = bit_matrix_alloc(N, N);
+	int words = R->words;
+	
+	// Iterative Tarjan's algorithm
+	std::vector<int> index(N, -1);
+	std::vector<int> low(N);
+	std::vector<int> component(N, -1);
+	std::vector<int> stack;
+	std::vector<int> call_node;
+	std::vector<int> call_edge;
+	std::vector<int> members;
+	std::vector<int> merged(N, -1);
+	int next_index = 0;
+	int components = 0;
+	for (int root = 0; root < N; root++) {
+		if (index[root] != -1) {
+			continue;
+		}
+		call_node.push_back(root);
+		call_edge.push_back(adj->offsets[root]);
+		index[root] = low[root] = next_index++;
+		stack.push_back(root);
+		while (!call_node.empty()) {
+			int u = call_node.back();
+			int& k = call_edge.back();
+			if (k < adj->offsets[u + 1]) {
+				int v = adj->nodes[k++];
+				if (index[v] == -1) {
+					index[v] = low[v] = next_index++;
+					stack.push_back(v);
+					call_node.push_back(v);
+					call_edge.push_back(adj->offsets[v]);
+				} else if (component[v] == -1 && index[v] < low[u]) {
+					low[u] = index[v];
+				}
+				continue;
+			}
+			call_node.pop_back();
+			call_edge.pop_back();
+			if (!call_node.empty() && low[u] < low[call_node.back()]) {
+				low[call_node.back()] = low[u];
+			}
+			if (low[u] != index[u]) {
+				continue;
+			}
+			
+			// u is the root of a component; every component it connects to
+			// has already been completed
+			members.clear();
+			int w;
+			do {
+				w = stack.back();
+				stack.pop_back();
+				component[w] = components;
+				members.push_back(w);
+			} while (w != u);
+			unsigned long* row = &R->data[u * words];
+			bool cyclic = members.size() > 1;
+			for (int m = 0; m < (int)members.size(); m++) {
+				int i = members[m];
+				for (int k = adj->offsets[i]; k < adj->offsets[i + 1]; k++) {
+					int v = adj->nodes[k];
+					if (component[v] == components) {
+						cyclic = true;
+						continue;
+					}
+					row[v / bit_matrix_word_bits] |= 1UL << (v % bit_matrix_word_bits);
+					if (merged[component[v]] != components) {
+						merged[component[v]] = components;
+						const unsigned long* other = &R->data[v * words];
+						for (int word = 0; word < words; word++) {
+							row[word] |= other[word];
+						}
+					}
+				}
+			}
+			if (cyclic) {
+				for (int m = 0; m < (int)members.size(); m++) {
+					int i = members[m];
+					row[i / bit_matrix_word_bits] |= 1UL << (i % bit_matrix_word_bits);
+				}
+			}
+			for (int m = 0; m < (int)members.size(); m++) {
+				if (members[m] != u) {
+					unsigned long* copy = &R->data[members[m] * words];
+					for (int word = 0; word < words; word++) {
+						copy[word] = row[word];
+					}
+				}
+			}
+			components++;
+		}
 	}
 	return R;
 }
 
-void reachdist2(const MATRIX_T* CIJ, MATRIX_T** CIJpwr, MATRIX_T** R, MATRIX_T** D, int N, int* powr, VECTOR_T* col, VECTOR_T* row) {
-	using namespace BCT_NAMESPACE;
-	
-	// CIJpwr = CIJpwr*CIJ;
-	MATRIX_T* temp = mul(*CIJpwr, CIJ);
-	MATRIX_ID(free)(*CIJpwr);
-	*CIJpwr = temp;
-	
-	// R = double(R | ((CIJpwr)~=0));
-	MATRIX_T* CIJpwr_neq_0 = compare_elements(*CIJpwr, fp_not_equal, 0.0);
-	MATRIX_T* R_or_CIJpwr_neq_0 = logical_or(*R, CIJpwr_neq_0);
-	MATRIX_ID(free)(CIJpwr_neq_0);
-	MATRIX_ID(free)(*R);
-	*R = R_or_CIJpwr_neq_0;
-	
-	// D = D+R;
-	if (D != NULL) {
-		MATRIX_ID(add)(*D, *R);
+/*
+ * Runs a breadth-first search from each of count consecutive sources at once,
+ * starting at first.  Bit b of each word belongs to source (first + b).  The
+ * sources themselves are not marked as visited, so that a source is reached
+ * again through its shortest cycle.
+ */
+void BCT_NAMESPACE::reachdist_batch(const adjacency_list* adj, int first, int count, MATRIX_T* R, MATRIX_T* D,
+									std::vector<unsigned long>& visited, std::vector<unsigned long>& frontier, std::vector<unsigned long>& next) {
+	int N = adj->size;
+	for (int i = 0; i < N; i++) {
+		visited[i] = 0;
+		frontier[i] = 0;
 	}
-	
-	// if ((powr<=N)&&(~isempty(nonzeros(R(row,col)==0))))
-	if (*powr <= N) {
-		if (row != NULL && col != NULL) {
-			MATRIX_T* R_idx = ordinal_index(*R, row, col);
-			MATRIX_T* R_idx_eq_0 = compare_elements(R_idx, fp_equal, 0.0);
-			MATRIX_ID(free)(R_idx);
-			VECTOR_T* nonzeros_R_idx_eq_0 = nonzeros(R_idx_eq_0);
-			MATRIX_ID(free)(R_idx_eq_0);
-			if (nonzeros_R_idx_eq_0 != NULL) {
-				VECTOR_ID(free)(nonzeros_R_idx_eq_0);
-				
-				// powr = powr+1;
-				(*powr)++;
-				
-				// [R,D,powr] = reachdist2(CIJ,CIJpwr,R,D,N,powr,col,row);
-				reachdist2(CIJ, CIJpwr, R, D, N, powr, col, row);
+	for (int b = 0; b < count; b++) {
+		frontier[first + b] = 1UL << b;
+	}
+	bool active = count > 0;
+	for (int distance = 1; active; distance++) {
+		for (int i = 0; i < N; i++) {
+			next[i] = 0;
+		}
+		for (int i = 0; i < N; i++) {
+			unsigned long bits = frontier[i];
+			if (bits != 0) {
+				for (int k = adj->offsets[i]; k < adj->offsets[i + 1]; k++) {
+					next[adj->nodes[k]] |= bits;
+				}
+			}
+		}
+		active = false;
+		for (int j = 0; j < N; j++) {
+			unsigned long bits = next[j] & ~visited[j];
+			frontier[j] = bits;
+			if (bits != 0) {
+				active = true;
+				visited[j] |= bits;
+				for (; bits != 0; bits &= bits - 1) {
+					int i = first + lowest_bit(bits);
+					MATRIX_ID(set)(R, i, j, 1.0);
+					MATRIX_ID(set)(D, i, j, (FP_T)distance);
+				}
 			}
 		}
 	}
@@ -1,20 +1,30 @@
 from distutils.core import Extension, setup
+import numpy
 
 swig_opts = ["-Wall", "-c++", "-outputtuple"]
-libraries = ["bct", "gsl", "gslcblas"]
+include_dirs = [numpy.get_include()]
+libraries = ["bct", "gsl", "gslcblas", "pthread"]
+
+# Links the OpenMP runtime used by a library built with openmp_flags, so that
+# batch_run analyzes graphs in parallel from Python
+extra_link_args = ["-fopenmp"]
 
 bct_gsl = Extension(
     "_bct_gsl",
     sources = ["bct_gsl.i"],
     swig_opts = swig_opts,
-    libraries = libraries
+    include_dirs = include_dirs,
+    libraries = libraries,
+    extra_link_args = extra_link_args
 )
 
 bct_py = Extension(
     "_bct_py",
     sources = ["bct_py.i"],
     swig_opts = swig_opts,
-    libraries = libraries
+    include_dirs = include_dirs,
+    libraries = libraries,
+    extra_link_args = extra_link_args
 )
 
 setup(
@@ -1,7 +1,54 @@
 #include <iostream>
+#include <pthread.h>
+#include <vector>
 
 #include "bct.h"
 
+namespace BCT_NAMESPACE {
+	
+	// Square tiles of this size are compared against their transposes, so
+	// that both fit in cache
+	const int status_tile = 64;
+	
+	const int status_all = SQUARE | RECTANGULAR | UNDIRECTED | DIRECTED | BINARY | WEIGHTED | POSITIVE | SIGNED | NO_LOOPS | LOOPS;
+	
+	/*
+	 * A cached classification.  The matrix is identified by its data pointer
+	 * and shape, and the entry is valid only while generation matches
+	 * status_generation.
+	 */
+	struct status_cache_entry {
+		const FP_T* data;
+		std::size_t size1;
+		std::size_t size2;
+		std::size_t tda;
+		unsigned long generation;
+		int status;
+	};
+	std::vector<status_cache_entry> status_cache;
+	unsigned long status_generation = 0;
+	
+	// Guards status_cache and status_generation whether the callers are OpenMP
+	// threads, Python threads, or threads created by the application
+	pthread_mutex_t status_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+	
+	// Holds status_cache_mutex until it goes out of scope, so that the mutex is
+	// released even if updating the cache throws
+	class status_cache_lock {
+	public:
+		status_cache_lock() { pthread_mutex_lock(&status_cache_mutex); }
+		~status_cache_lock() { pthread_mutex_unlock(&status_cache_mutex); }
+	private:
+		status_cache_lock(const status_cache_lock&);
+		status_cache_lock& operator=(const status_cache_lock&);
+	};
+	
+	bool status_cache_find(const MATRIX_T* m, int* status);
+	bool status_cache_matches(const status_cache_entry& entry, const MATRIX_T* m);
+	bool status_weighted(const FP_T* row, int length);
+	bool status_directed(const MATRIX_T* m, int i0, int i1, int j0, int j1);
+}
+
 bool BCT_NAMESPACE::safe_mode = true;
 
 bool BCT_NAMESPACE::get_safe_mode() { return safe_mode; }
@@ -26,21 +73,16 @@ bool BCT_NAMESPACE::check_status(const MATRIX_T* m, int flags, const std::string
 		"positive", "signed",
 		"no_loops", "loops"
 	};
-	bool (*propfn[])(const MATRIX_T*) = {
-		is_square, is_rectangular,
-		is_undirected, is_directed,
-		is_binary, is_weighted,
-		is_positive, is_signed,
-		has_no_loops, has_loops
-	};
+	int properties;
+	if ((flags & ~(SQUARE | RECTANGULAR)) == 0 || !status_cache_find(m, &properties)) {
+		properties = matrix_status(m, flags);
+	}
 	bool ret = true;
 	std::vector<std::string> failures;
 	for (int i = 0; i < 10; i++) {
-		if (flags & (int)prop[i]) {
-			if (!propfn[i](m)) {
-				ret = false;
-				failures.push_back(propstr[i]);
-			}
+		if ((flags & (int)prop[i]) && !(properties & (int)prop[i])) {
+			ret = false;
+			failures.push_back(propstr[i]);
 		}
 	}
 	if (!ret) {
@@ -74,77 +116,252 @@ bool BCT_NAMESPACE::is_rectangular(const MATRIX_T* m) {
  * Returns whether the given matrix is undirected.
  */
 bool BCT_NAMESPACE::is_undirected(const MATRIX_T* m) {
-	return !is_directed(m);
+	return (matrix_status(m, UNDIRECTED) & UNDIRECTED) != 0;
 }
 
 /*
  * Returns whether the given matrix is directed.
  */
 bool BCT_NAMESPACE::is_directed(const MATRIX_T* m) {
-	for (int i = 0; i < (int)m->size1; i++) {
-		for (int j = 0; j < (int)m->size2; j++) {
-			if (fp_not_equal(MATRIX_ID(get)(m, i, j), MATRIX_ID(get)(m, j, i))) {
-				return true;
-			}
-		}
-	}
-	return false;
+	return (matrix_status(m, DIRECTED) & DIRECTED) != 0;
 }
 
 /*
  * Returns whether the given matrix is binary.
  */
 bool BCT_NAMESPACE::is_binary(const MATRIX_T* m) {
-	return !is_weighted(m);
+	return (matrix_status(m, BINARY) & BINARY) != 0;
 }
 
 /*
  * Returns whether the given matrix is weighted.
  */
 bool BCT_NAMESPACE::is_weighted(const MATRIX_T* m) {
-	for (int i = 0; i < (int)m->size1; i++) {
-		for (int j = 0; j < (int)m->size2; j++) {
-			FP_T value = MATRIX_ID(get)(m, i, j);
-			if (fp_nonzero(value) && fp_not_equal(value, 1.0)) {
-				return true;
-			}
-		}
-	}
-	return false;
+	return (matrix_status(m, WEIGHTED) & WEIGHTED) != 0;
 }
 
 /*
  * Returns whether the given matrix is positive.
  */
 bool BCT_NAMESPACE::is_positive(const MATRIX_T* m) {
-	return !is_signed(m);
+	return (matrix_status(m, POSITIVE) & POSITIVE) != 0;
 }
 
 /*
  * Returns whether the given matrix is signed.
  */
 bool BCT_NAMESPACE::is_signed(const MATRIX_T* m) {
-	for (int i = 0; i < (int)m->size1; i++) {
-		for (int j = 0; j < (int)m->size2; j++) {
-			if (MATRIX_ID(get)(m, i, j) < 0.0) {
-				return true;
-			}
-		}
-	}
-	return false;
+	return (matrix_status(m, SIGNED) & SIGNED) != 0;
 }
 
 /*
  * Returns whether the given matrix has loops.
  */
 bool BCT_NAMESPACE::has_loops(const MATRIX_T* m) {
-	return !has_no_loops(m);
+	return (matrix_status(m, LOOPS) & LOOPS) != 0;
 }
 
 /*
  * Returns whether the given matrix has no loops.
  */
 bool BCT_NAMESPACE::has_no_loops(const MATRIX_T* m) {
-	VECTOR_ID(const_view) diag_m = MATRIX_ID(const_diagonal)(m);
-	return VECTOR_ID(isnull)(&diag_m.vector) == 1;
+	return (matrix_status(m, NO_LOOPS) & NO_LOOPS) != 0;
+}
+
+/*
+ * Classifies a matrix into every status flag.  See the two-argument version.
+ */
+int BCT_NAMESPACE::matrix_status(const MATRIX_T* m) {
+	return matrix_status(m, status_all);
+}
+
+/*
+ * Classifies a matrix, returning the flag that holds from each pair of status
+ * flags (e.g., UNDIRECTED or DIRECTED) with at least one member in the given
+ * flags.  Other pairs are not determined.  A rectangular matrix is directed.
+ *
+ * All properties are found in a single pass, which stops as soon as every
+ * requested property is known.  Elements are first tested for exact equality
+ * (with their transposes, and with 0 and 1) in loops without branches, and only
+ * tiles that fail these tests are rechecked using the tolerances of
+ * fp_not_equal and fp_nonzero.  The matrix is visited in square tiles, each
+ * read together with its transpose.
+ */
+int BCT_NAMESPACE::matrix_status(const MATRIX_T* m, int flags) {
+	int size1 = m->size1;
+	int size2 = m->size2;
+	bool square = size1 == size2;
+	bool check_directed = (flags & (UNDIRECTED | DIRECTED)) != 0;
+	bool check_weighted = (flags & (BINARY | WEIGHTED)) != 0;
+	bool check_signed = (flags & (POSITIVE | SIGNED)) != 0;
+	bool check_loops = (flags & (NO_LOOPS | LOOPS)) != 0;
+	bool directed = check_directed && !square;
+	bool weighted = false;
+	bool is_signed = false;
+	bool loops = false;
+	
+	// Diagonal elements must be exactly zero
+	if (check_loops) {
+		int diagonal = (size1 < size2) ? size1 : size2;
+		for (int i = 0; i < diagonal && !loops; i++) {
+			loops = MATRIX_ID(get)(m, i, i) != 0.0;
+		}
+	}
+	
+	// With no symmetry to check, tiles are whole rows
+	bool tiled = check_directed && square;
+	int columns = tiled ? status_tile : size2;
+	std::size_t tda = m->tda;
+	for (int i0 = 0; i0 < size1; i0 += status_tile) {
+		int i1 = (i0 + status_tile < size1) ? i0 + status_tile : size1;
+		for (int j0 = tiled ? i0 : 0; j0 < size2; j0 += columns) {
+			if ((!check_directed || directed) && (!check_weighted || weighted) && (!check_signed || is_signed)) {
+				break;
+			}
+			int j1 = (j0 + columns < size2) ? j0 + columns : size2;
+			int asymmetric = 0;
+			int nonbinary = 0;
+			int negative = 0;
+			for (int i = i0; i < i1; i++) {
+				const FP_T* row = MATRIX_ID(const_ptr)(m, i, 0);
+				const FP_T* column = m->data + i;
+				for (int j = j0; j < j1; j++) {
+					FP_T value = row[j];
+					nonbinary |= (value != 0.0) & (value != 1.0);
+					negative |= value < 0.0;
+				}
+				if (tiled && j0 != i0) {
+					for (int j = j0; j < j1; j++) {
+						FP_T value = column[(std::size_t)j * tda];
+						nonbinary |= (value != 0.0) & (value != 1.0);
+						negative |= value < 0.0;
+						asymmetric |= row[j] != value;
+					}
+				} else if (tiled) {
+					for (int j = j0; j < j1; j++) {
+						asymmetric |= row[j] != column[(std::size_t)j * tda];
+					}
+				}
+			}
+			is_signed = is_signed || negative;
+			if (check_weighted && !weighted && nonbinary) {
+				for (int i = i0; i < i1 && !weighted; i++) {
+					weighted = status_weighted(MATRIX_ID(const_ptr)(m, i, j0), j1 - j0);
+				}
+				if (tiled && j0 != i0) {
+					for (int j = j0; j < j1 && !weighted; j++) {
+						weighted = status_weighted(MATRIX_ID(const_ptr)(m, j, i0), i1 - i0);
+					}
+				}
+			}
+			if (check_directed && !directed && asymmetric) {
+				directed = status_directed(m, i0, i1, j0, j1);
+			}
+		}
+	}
+	
+	int status = square ? SQUARE : RECTANGULAR;
+	if (check_directed) status |= directed ? DIRECTED : UNDIRECTED;
+	if (check_weighted) status |= weighted ? WEIGHTED : BINARY;
+	if (check_signed) status |= is_signed ? SIGNED : POSITIVE;
+	if (check_loops) status |= loops ? LOOPS : NO_LOOPS;
+	return status;
+}
+
+/*
+ * Classifies a matrix and remembers the result, so that check_status does not
+ * examine the matrix again.  The cache is opt-in: a cached matrix must not be
+ * modified, or freed, until it is removed with uncache_status or the cache is
+ * cleared.  Call cache_status again to reclassify a matrix after modifying it.
+ */
+void BCT_NAMESPACE::cache_status(const MATRIX_T* m) {
+	int status = matrix_status(m);
+	{
+		status_cache_lock lock;
+		status_cache_entry entry;
+		entry.data = m->data;
+		entry.size1 = m->size1;
+		entry.size2 = m->size2;
+		entry.tda = m->tda;
+		entry.generation = status_generation;
+		entry.status = status;
+		int i = 0;
+		while (i < (int)status_cache.size() && !status_cache_matches(status_cache[i], m) && status_cache[i].generation == status_generation) {
+			i++;
+		}
+		if (i < (int)status_cache.size()) {
+			status_cache[i] = entry;
+		} else {
+			status_cache.push_back(entry);
+		}
+	}
+}
+
+/*
+ * Removes a matrix from the status cache.
+ */
+void BCT_NAMESPACE::uncache_status(const MATRIX_T* m) {
+	status_cache_lock lock;
+	for (int i = 0; i < (int)status_cache.size(); i++) {
+		if (status_cache_matches(status_cache[i], m)) {
+			status_cache.erase(status_cache.begin() + i);
+			break;
+		}
+	}
+}
+
+/*
+ * Invalidates every entry in the status cache by advancing the generation
+ * counter.  Stale entries are overwritten as new matrices are cached.
+ */
+void BCT_NAMESPACE::clear_status_cache() {
+	status_cache_lock lock;
+	status_generation++;
+}
+
+/*
+ * Looks up a matrix in the status cache.
+ */
+bool BCT_NAMESPACE::status_cache_find(const MATRIX_T* m, int* status) {
+	status_cache_lock lock;
+	for (int i = 0; i < (int)status_cache.size(); i++) {
+		if (status_cache_matches(status_cache[i], m) && status_cache[i].generation == status_generation) {
+			*status = status_cache[i].status;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool BCT_NAMESPACE::status_cache_matches(const status_cache_entry& entry, const MATRIX_T* m) {
+	return entry.data == m->data && entry.size1 == m->size1 && entry.size2 == m->size2 && entry.tda == m->tda;
+}
+
+/*
+ * Returns whether any element is weighted, as tested by is_weighted before
+ * classification was done in a single pass.
+ */
+bool BCT_NAMESPACE::status_weighted(const FP_T* row, int length) {
+	for (int j = 0; j < length; j++) {
+		if (fp_nonzero(row[j]) && fp_not_equal(row[j], 1.0)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * Returns whether any element of the tile (i0:i1, j0:j1) differs from its
+ * transpose, as tested by is_directed before classification was done in a
+ * single pass.
+ */
+bool BCT_NAMESPACE::status_directed(const MATRIX_T* m, int i0, int i1, int j0, int j1) {
+	for (int i = i0; i < i1; i++) {
+		for (int j = j0; j < j1; j++) {
+			if (fp_not_equal(MATRIX_ID(get)(m, i, j), MATRIX_ID(get)(m, j, i))) {
+				return true;
+			}
+		}
+	}
+	return false;
 }
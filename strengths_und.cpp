@@ -9,3 +9,42 @@ VECTOR_T* BCT_NAMESPACE::strengths_und(const MATRIX_T* CIJ) {
 	// str = sum(CIJ);
 	return sum(CIJ);
 }
+
+/*
+ * Computes strength for an undirected graph into an existing vector with one
+ * element per node.  Rows are added in the same order as sum(CIJ).
+ */
+void BCT_NAMESPACE::strengths_und_into(const MATRIX_T* CIJ, VECTOR_T* str) {
+	if (safe_mode) check_status(CIJ, SQUARE | UNDIRECTED, "strengths_und_into");
+	if (str->size != CIJ->size2) {
+		throw bct_exception("strengths_und_into: str must have one element per node");
+	}
+	VECTOR_ID(set_zero)(str);
+	for (int i = 0; i < (int)CIJ->size1; i++) {
+		VECTOR_ID(const_view) CIJ_row_i = MATRIX_ID(const_row)(CIJ, i);
+		VECTOR_ID(add)(str, &CIJ_row_i.vector);
+	}
+}
+
+/*
+ * Computes strength for an undirected graph stored as a packed symmetric
+ * matrix.  Each element of the upper triangle is read once and added to both
+ * of its nodes, in the same order as sum(CIJ) so that the result is identical.
+ */
+VECTOR_T* BCT_NAMESPACE::strengths_und(const packed_matrix* CIJ) {
+	int N = CIJ->size;
+	VECTOR_T* str = zeros_vector(N);
+	for (int i = 0; i < N; i++) {
+		const FP_T* row = packed_matrix_const_row(CIJ, i);
+		FP_T str_i = VECTOR_ID(get)(str, i);
+		for (int j = i; j < N; j++) {
+			FP_T value = row[j - i];
+			str_i += value;
+			if (j != i) {
+				VECTOR_ID(set)(str, j, VECTOR_ID(get)(str, j) + value);
+			}
+		}
+		VECTOR_ID(set)(str, i, str_i);
+	}
+	return str;
+}
@@ -1,5 +1,8 @@
 %{
 	#include <cmath>
+	#include <cstdlib>
+	#include <cstring>
+	#include <exception>
 	#include <gsl/gsl_matrix.h>
 	#include <gsl/gsl_permutation.h>
 	#include <gsl/gsl_vector.h>
@@ -7,18 +10,32 @@
 	#include <Python.h>
 	#include <vector>
 	
+	#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+	#include <numpy/arrayobject.h>
+	
+	/*
+	 * Serializes calls that change state shared across the library (the random
+	 * number generator and the status cache), which is not safe to do from
+	 * several threads at once.
+	 */
+	PyThread_type_lock rng_lock = NULL;
+	
 	/*
-	 * Checks if a PyObject* is an n-dimensional list.
+	 * Checks if a PyObject* is an n-dimensional list.  NumPy arrays count for
+	 * as many dimensions as they have, so a list of matrices may also be a
+	 * list of two-dimensional arrays.
 	 */
 	bool is_ndim_list(PyObject* object, int n) {
 		for (int i = 0; i < n; i++) {
-			if (PyList_Check(object) == 1 && PyList_Size(object) > 0) {
+			if (PyArray_Check(object) == 1) {
+				return PyArray_NDIM((PyArrayObject*)object) == n - i;
+			} else if (PyList_Check(object) == 1 && PyList_Size(object) > 0) {
 				object = PyList_GetItem(object, PyList_Size(object) - 1);
 			} else {
 				return false;
 			}
 		}
-		if (PyList_Check(object) == 0) {
+		if (PyList_Check(object) == 0 && PyArray_Check(object) == 0) {
 			return true;
 		} else {
 			return false;
@@ -50,7 +67,7 @@
 	 * Checks if a PyObject* can be converted to a gsl_permutation*.
 	 */
 	bool is_gslp(PyObject* object) {
-		if (!is_ndim_list(object, 1)) {
+		if (PyList_Check(object) == 0 || !is_ndim_list(object, 1)) {
 			return false;
 		}
 		int n = PyList_Size(object);
@@ -140,9 +157,19 @@
 	}
 	
 	/*
-	 * Converts a Python list to a gsl_vector*.
+	 * Converts a Python list or NumPy array to a gsl_vector*.
 	 */
 	gsl_vector* to_gslv(PyObject* list) {
+		if (PyArray_Check(list) == 1) {
+			PyArrayObject* array = (PyArrayObject*)PyArray_FROMANY(list, NPY_DOUBLE, 1, 1, NPY_ARRAY_IN_ARRAY);
+			if (array == NULL) {
+				return NULL;
+			}
+			gsl_vector* v = gsl_vector_alloc(PyArray_DIM(array, 0));
+			std::memcpy(v->data, PyArray_DATA(array), v->size * sizeof(double));
+			Py_DECREF(array);
+			return v;
+		}
 		int n = PyList_Size(list);
 		gsl_vector* v = gsl_vector_alloc(n);
 		for (int i = 0; i < n; i++) {
@@ -153,9 +180,19 @@
 	}
 	
 	/*
-	 * Converts a Python list of lists to a gsl_matrix*.
+	 * Converts a Python list of lists or a NumPy array to a gsl_matrix*.
 	 */
 	gsl_matrix* to_gslm(PyObject* list) {
+		if (PyArray_Check(list) == 1) {
+			PyArrayObject* array = (PyArrayObject*)PyArray_FROMANY(list, NPY_DOUBLE, 2, 2, NPY_ARRAY_IN_ARRAY);
+			if (array == NULL) {
+				return NULL;
+			}
+			gsl_matrix* m = gsl_matrix_alloc(PyArray_DIM(array, 0), PyArray_DIM(array, 1));
+			std::memcpy(m->data, PyArray_DATA(array), m->size1 * m->size2 * sizeof(double));
+			Py_DECREF(array);
+			return m;
+		}
 		int n_rows = PyList_Size(list);
 		int n_cols = PyList_Size(PyList_GetItem(list, 0));
 		gsl_matrix* m = gsl_matrix_alloc(n_rows, n_cols);
@@ -170,28 +207,20 @@
 	}
 	
 	/*
-	 * Converts a Python list of lists of lists to a std::vector<gsl_matrix*>.
+	 * Converts a Python list of lists of lists, a list of NumPy arrays, or a
+	 * three-dimensional NumPy array to a std::vector<gsl_matrix*>.
 	 */
 	std::vector<gsl_matrix*> to_gsl3dm(PyObject* list) {
-		int n_matrices = PyList_Size(list);
+		int n_matrices = PySequence_Size(list);
 		std::vector<gsl_matrix*> m(n_matrices);
 		for (int i = 0; i < n_matrices; i++) {
-			PyObject* sublist = PyList_GetItem(list, i);
+			PyObject* sublist = PySequence_GetItem(list, i);
 			if (sublist == Py_None) {
 				m[i] = NULL;
 			} else {
-				int n_rows = PyList_Size(sublist);
-				int n_cols = PyList_Size(PyList_GetItem(sublist, 0));
-				gsl_matrix* subm = gsl_matrix_alloc(n_rows, n_cols);
-				m[i] = subm;
-				for (int j = 0; j < n_rows; j++) {
-					PyObject* subsublist = PyList_GetItem(sublist, j);
-					for (int k = 0; k < n_cols; k++) {
-						double value = PyFloat_AsDouble(PyList_GetItem(subsublist, k));
-						gsl_matrix_set(subm, j, k, value);
-					}
-				}
+				m[i] = to_gslm(sublist);
 			}
+			Py_DECREF(sublist);
 		}
 		return m;
 	}
@@ -212,4 +241,246 @@
 			return p;
 		}
 	}
+	
+	/*
+	 * Frees the GSL vector or matrix owned by a NumPy array.
+	 */
+	void free_gslv_capsule(PyObject* capsule) {
+		gsl_vector_free((gsl_vector*)PyCapsule_GetPointer(capsule, NULL));
+	}
+	
+	void free_gslm_capsule(PyObject* capsule) {
+		gsl_matrix_free((gsl_matrix*)PyCapsule_GetPointer(capsule, NULL));
+	}
+	
+	/*
+	 * Wraps a gsl_vector* in a NumPy array without copying.  The array takes
+	 * ownership of the vector and frees it when it is garbage collected.  If the
+	 * array cannot be made, the vector is freed and NULL is returned.
+	 */
+	PyObject* to_ndarray(gsl_vector* v) {
+		if (v == NULL) {
+			Py_RETURN_NONE;
+		}
+		npy_intp dims[1] = { (npy_intp)v->size };
+		npy_intp strides[1] = { (npy_intp)(v->stride * sizeof(double)) };
+		PyObject* array = PyArray_New(&PyArray_Type, 1, dims, NPY_DOUBLE, strides, v->data, 0, NPY_ARRAY_BEHAVED, NULL);
+		if (array == NULL) {
+			gsl_vector_free(v);
+			return NULL;
+		}
+		PyObject* capsule = PyCapsule_New(v, NULL, NULL);
+		if (capsule == NULL) {
+			Py_DECREF(array);
+			gsl_vector_free(v);
+			return NULL;
+		}
+		if (PyArray_SetBaseObject((PyArrayObject*)array, capsule) != 0) {
+			Py_DECREF(array);
+			gsl_vector_free(v);
+			return NULL;
+		}
+		PyCapsule_SetDestructor(capsule, free_gslv_capsule);
+		return array;
+	}
+	
+	/*
+	 * Wraps a gsl_matrix* in a NumPy array without copying.  The array takes
+	 * ownership of the matrix and frees it when it is garbage collected.  If the
+	 * array cannot be made, the matrix is freed and NULL is returned.
+	 */
+	PyObject* to_ndarray(gsl_matrix* m) {
+		if (m == NULL) {
+			Py_RETURN_NONE;
+		}
+		npy_intp dims[2] = { (npy_intp)m->size1, (npy_intp)m->size2 };
+		npy_intp strides[2] = { (npy_intp)(m->tda * sizeof(double)), (npy_intp)sizeof(double) };
+		PyObject* array = PyArray_New(&PyArray_Type, 2, dims, NPY_DOUBLE, strides, m->data, 0, NPY_ARRAY_BEHAVED, NULL);
+		if (array == NULL) {
+			gsl_matrix_free(m);
+			return NULL;
+		}
+		PyObject* capsule = PyCapsule_New(m, NULL, NULL);
+		if (capsule == NULL) {
+			Py_DECREF(array);
+			gsl_matrix_free(m);
+			return NULL;
+		}
+		if (PyArray_SetBaseObject((PyArrayObject*)array, capsule) != 0) {
+			Py_DECREF(array);
+			gsl_matrix_free(m);
+			return NULL;
+		}
+		PyCapsule_SetDestructor(capsule, free_gslm_capsule);
+		return array;
+	}
+	
+	/*
+	 * Wraps each matrix in a std::vector<gsl_matrix*> in a NumPy array, as
+	 * above, and returns a list of the arrays.  If any array cannot be made,
+	 * every matrix is freed and NULL is returned.
+	 */
+	PyObject* to_ndarray(std::vector<gsl_matrix*>& m) {
+		PyObject* list = PyList_New(m.size());
+		for (int i = 0; i < (int)m.size(); i++) {
+			PyObject* array = NULL;
+			if (list != NULL) {
+				array = to_ndarray(m[i]);
+			} else {
+				gsl_matrix_free(m[i]);
+			}
+			m[i] = NULL;
+			if (array == NULL) {
+				Py_XDECREF(list);
+				list = NULL;
+			} else {
+				PyList_SetItem(list, i, array);
+			}
+		}
+		return list;
+	}
+	
+	/*
+	 * Returns the NumPy array of doubles in C order that a Python list or array
+	 * is viewed through.  An array that already has this layout is used as it
+	 * is; anything else is converted.  If writable is true, a converted array
+	 * is copied back to the original when it is released.
+	 */
+	PyArrayObject* to_carray(PyObject* object, int ndim, bool writable) {
+		int flags = NPY_ARRAY_IN_ARRAY;
+		if (writable && PyArray_Check(object) == 1) {
+			flags = NPY_ARRAY_INOUT_ARRAY2;
+		}
+		return (PyArrayObject*)PyArray_FROMANY(object, NPY_DOUBLE, ndim, ndim, flags);
+	}
+	
+	/*
+	 * Releases an array returned by to_carray, copying it back to the original
+	 * array if it was converted for writing.
+	 */
+	void release_carray(PyArrayObject* array) {
+		if (array != NULL) {
+			PyArray_ResolveWritebackIfCopy(array);
+			Py_DECREF(array);
+		}
+	}
+	
+	/*
+	 * Views the data of an array returned by to_carray as a gsl_vector* without
+	 * copying.  Freeing the vector does not free the data.
+	 */
+	gsl_vector* view_gslv(PyArrayObject* array) {
+		if (array == NULL) {
+			return NULL;
+		}
+		gsl_vector* v = (gsl_vector*)std::malloc(sizeof(gsl_vector));
+		v->size = PyArray_DIM(array, 0);
+		v->stride = 1;
+		v->data = (double*)PyArray_DATA(array);
+		v->block = NULL;
+		v->owner = 0;
+		return v;
+	}
+	
+	/*
+	 * Views the data of an array returned by to_carray as a gsl_matrix* without
+	 * copying.  Freeing the matrix does not free the data.
+	 */
+	gsl_matrix* view_gslm(PyArrayObject* array) {
+		if (array == NULL) {
+			return NULL;
+		}
+		gsl_matrix* m = (gsl_matrix*)std::malloc(sizeof(gsl_matrix));
+		m->size1 = PyArray_DIM(array, 0);
+		m->size2 = PyArray_DIM(array, 1);
+		m->tda = m->size2;
+		m->data = (double*)PyArray_DATA(array);
+		m->block = NULL;
+		m->owner = 0;
+		return m;
+	}
+%}
+
+%init %{
+	import_array();
+	rng_lock = PyThread_allocate_lock();
+	
+	// Build the lazily constructed state that calls would otherwise race to
+	// initialize once they run without the GIL
+	bct::get_rng();
+	bct::gsl_free(bct::motif3generate());
+	bct::gsl_free(bct::motif4generate());
 %}
+
+// Every call releases the GIL, so other Python threads run while the library
+// computes, and library exceptions are raised as RuntimeError
+%exception {
+	{
+		PyThreadState* thread_state = PyEval_SaveThread();
+		try {
+			$action
+		} catch (const std::exception& e) {
+			PyEval_RestoreThread(thread_state);
+			PyErr_SetString(PyExc_RuntimeError, e.what());
+			SWIG_fail;
+		}
+		PyEval_RestoreThread(thread_state);
+	}
+}
+
+// Calls that use the random number generator or change the status cache also
+// hold rng_lock, so they run one at a time but still without the GIL
+%define %serialized(name)
+%exception name {
+	{
+		PyThreadState* thread_state = PyEval_SaveThread();
+		PyThread_acquire_lock(rng_lock, WAIT_LOCK);
+		try {
+			$action
+		} catch (const std::exception& e) {
+			PyThread_release_lock(rng_lock);
+			PyEval_RestoreThread(thread_state);
+			PyErr_SetString(PyExc_RuntimeError, e.what());
+			SWIG_fail;
+		}
+		PyThread_release_lock(rng_lock);
+		PyEval_RestoreThread(thread_state);
+	}
+}
+%enddef
+
+%serialized(batch_run)
+%serialized(latmio_dir)
+%serialized(latmio_dir_connected)
+%serialized(latmio_und)
+%serialized(latmio_und_connected)
+%serialized(makeevenCIJ)
+%serialized(makefractalCIJ)
+%serialized(makelatticeCIJ)
+%serialized(makerandCIJ_bd)
+%serialized(makerandCIJ_bu)
+%serialized(makerandCIJ_wd)
+%serialized(makerandCIJ_wd_wp)
+%serialized(makerandCIJ_wu)
+%serialized(makerandCIJ_wu_wp)
+%serialized(makerandCIJdegreesfixed)
+%serialized(makeringlatticeCIJ)
+%serialized(maketoeplitzCIJ)
+%serialized(modularity_dir)
+%serialized(modularity_louvain_und)
+%serialized(modularity_und)
+%serialized(rand)
+%serialized(rand_vector)
+%serialized(randmio_dir)
+%serialized(randmio_dir_connected)
+%serialized(randmio_und)
+%serialized(randmio_und_connected)
+%serialized(randperm)
+%serialized(seed_rng)
+%serialized(cache_status)
+%serialized(uncache_status)
+%serialized(clear_status_cache)
+
+// set_motif_mode and set_safe_mode change globals that measures read without
+// any lock, so they are not thread safe; call them only while no other thread
+// is inside the library
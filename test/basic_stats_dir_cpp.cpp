@@ -0,0 +1,23 @@
+#include "bct_test.h"
+
+DEFUN_DLD(basic_stats_dir_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 1) {
+		return octave_value_list();
+	}
+	Matrix CIJ = args(0).matrix_value();
+	if (!error_state) {
+		gsl_matrix* CIJ_gsl = bct_test::to_gslm(CIJ);
+		bct::basic_stats* stats = bct::basic_stats_dir(CIJ_gsl);
+		octave_value_list ret;
+		ret(0) = octave_value(bct_test::from_gsl(stats->deg));
+		ret(1) = octave_value(bct_test::from_gsl(stats->str));
+		ret(2) = octave_value(stats->density);
+		ret(3) = octave_value(bct_test::from_gsl(stats->J));
+		ret(4) = octave_value(stats->assortativity);
+		gsl_matrix_free(CIJ_gsl);
+		bct::basic_stats_free(stats);
+		return ret;
+	} else {
+		return octave_value_list();
+	}
+}
@@ -0,0 +1,23 @@
+#include <string>
+#include <vector>
+
+#include "bct_test.h"
+
+DEFUN_DLD(batch_run_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 2) {
+		return octave_value_list();
+	}
+	NDArray graphs = args(0).array_value();
+	std::string measure = args(1).string_value();
+	if (!error_state) {
+		std::vector<gsl_matrix*> graphs_gsl = bct_test::to_gsl(graphs);
+		std::vector<std::string> measures(1, measure);
+		bct::batch_result* result = bct::batch_run(graphs_gsl, measures);
+		octave_value ret = octave_value(bct_test::from_gsl(result->values[0]));
+		bct::gsl_free(graphs_gsl);
+		bct::batch_result_free(result);
+		return ret;
+	} else {
+		return octave_value_list();
+	}
+}
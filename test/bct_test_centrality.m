@@ -9,7 +9,9 @@ end
 % betweenness_wei
 for i = 1:size(m)(2)
 	[EBC BC] = edge_betweenness_wei(m{i});
-	bct_test(sprintf("betweenness_wei %s", mname{i}), BC == betweenness_wei_cpp(m{i})')
+	[BC_cpp BC_adj_cpp] = betweenness_wei_cpp(m{i});
+	bct_test(sprintf("betweenness_wei %s", mname{i}), BC == BC_cpp')
+	bct_test(sprintf("betweenness_wei %s adjacency list", mname{i}), abs(BC - BC_adj_cpp') < 1e-6)
 end
 
 % edge_betweenness_bin
@@ -10,6 +10,18 @@ for i = 1:size(m)(2)
 	bct_test(sprintf("assortativity_und %s", mname{i}), assortativity(m{i}, 0) == assortativity_und_cpp(m{i}))
 end
 
+% basic_stats_dir
+for i = 1:size(m)(2)
+	[id od deg] = degrees_dir(m{i});
+	[is os str] = strengths_dir(m{i});
+	[deg_cpp str_cpp density_cpp J_cpp r_cpp] = basic_stats_dir_cpp(m{i});
+	bct_test(sprintf("basic_stats_dir %s deg", mname{i}), deg == deg_cpp)
+	bct_test(sprintf("basic_stats_dir %s str", mname{i}), abs(str - str_cpp) < 1e-6)
+	bct_test(sprintf("basic_stats_dir %s density", mname{i}), density_dir(m{i}) == density_cpp)
+	bct_test(sprintf("basic_stats_dir %s J", mname{i}), jdegree(m{i}) == J_cpp)
+	bct_test(sprintf("basic_stats_dir %s assortativity", mname{i}), assortativity(m{i}, 1) == r_cpp)
+end
+
 % degrees_dir
 for i = 1:size(m)(2)
 	[id od deg] = degrees_dir(m{i});
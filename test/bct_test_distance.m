@@ -9,6 +9,20 @@ for i = 1:size(m)(2)
 	bct_test(sprintf("breadth %s branch", mname{i}), branch == branch_cpp)
 end
 
+% breadth_batch
+for i = 1:size(m)(2)
+	sources = 1:length(m{i});
+	distance = zeros(length(sources));
+	branch = zeros(length(sources));
+	for j = sources
+		[distance(j,:) branch(j,:)] = breadth(m{i}, j);
+	end
+	[distance_cpp branch_cpp rejected] = breadth_batch_cpp(m{i}, sources);
+	bct_test(sprintf("breadth_batch %s distance", mname{i}), distance == distance_cpp)
+	bct_test(sprintf("breadth_batch %s branch", mname{i}), branch == branch_cpp)
+	bct_test(sprintf("breadth_batch %s rejects wrong workspace", mname{i}), rejected)
+end
+
 % breadthdist
 for i = 1:size(m)(2)
 	[R D] = breadthdist(m{i});
@@ -28,6 +42,16 @@ for i = 1:size(m)(2)
 	bct_test(sprintf("charpath %s diameter", mname{i}), diameter == diameter_cpp)
 end
 
+% charpath_m
+for i = 1:size(m)(2)
+	[lambda ecc radius diameter] = charpath(distance_wei(m{i}));
+	[ecc_cpp radius_cpp diameter_cpp] = charpath_ecc_m_cpp(m{i});
+	bct_test(sprintf("charpath_m %s lambda", mname{i}), abs(lambda - charpath_lambda_m_cpp(m{i})) < 1e-6)
+	bct_test(sprintf("charpath_m %s ecc", mname{i}), ecc == ecc_cpp')
+	bct_test(sprintf("charpath_m %s radius", mname{i}), radius == radius_cpp)
+	bct_test(sprintf("charpath_m %s diameter", mname{i}), diameter == diameter_cpp)
+end
+
 % cycprob
 for i = 1:size(m)(2)
 	sources = unique(floor(length(m{i}) * rand(1, 5))) + 1;
@@ -36,6 +60,9 @@ for i = 1:size(m)(2)
 	[fcyc pcyc] = cycprob(Pq);
 	bct_test(sprintf("cycprob %s fcyc", mname{i}), fcyc == cycprob_fcyc_cpp(Pq))
 	bct_test(sprintf("cycprob %s pcyc", mname{i}), pcyc == cycprob_pcyc_cpp(Pq))
+	[fcyc_cpp pcyc_cpp] = cycprob_cpp(m{i}, sources, qmax);
+	bct_test(sprintf("cycprob %s fcyc (fused)", mname{i}), fcyc == fcyc_cpp)
+	bct_test(sprintf("cycprob %s pcyc (fused)", mname{i}), pcyc == pcyc_cpp)
 end
 
 % distance_bin
@@ -50,7 +77,7 @@ end
 
 % efficiency_global
 for i = 1:size(m)(2)
-	bct_test(sprintf("efficiency_global %s", mname{i}), efficiency(m{i}) == efficiency_global_cpp(m{i}))
+	bct_test(sprintf("efficiency_global %s", mname{i}), abs(efficiency(m{i}) - efficiency_global_cpp(m{i})) < 1e-6)
 end
 
 % findpaths
@@ -66,6 +93,17 @@ for i = 1:size(m)(2)
 	bct_test(sprintf("findpaths %s util", mname{i}), util == util_cpp)
 end
 
+% findpaths_plq
+for i = 1:size(m)(2)
+	sources = unique(floor(length(m{i}) * rand(1, 5))) + 1;
+	qmax = 3;
+	[Pq tpath plq qstop allpths util] = findpaths(m{i}, sources, qmax, 0);
+	[plq_cpp qstop_cpp util_cpp] = findpaths_plq_cpp(m{i}, sources, qmax);
+	bct_test(sprintf("findpaths_plq %s plq", mname{i}), plq == plq_cpp)
+	bct_test(sprintf("findpaths_plq %s qstop", mname{i}), qstop == qstop_cpp)
+	bct_test(sprintf("findpaths_plq %s util", mname{i}), util == util_cpp)
+end
+
 % findwalks
 for i = 1:size(m)(2)
 	[Wq twalk wlq] = findwalks(m{i});
@@ -74,6 +112,19 @@ for i = 1:size(m)(2)
 	bct_test(sprintf("findwalks %s wlq", mname{i}), wlq == wlq_cpp)
 end
 
+% findwalks_wlq
+for i = 1:size(m)(2)
+	qmax = 3;
+	[Wq twalk wlq] = findwalks(m{i});
+	[wlq_cpp Wq_diag_cpp] = findwalks_wlq_cpp(m{i}, qmax);
+	bct_test(sprintf("findwalks_wlq %s wlq", mname{i}), wlq(1:qmax) == wlq_cpp)
+	Wq_diag = zeros(length(m{i}), qmax);
+	for q = 1:qmax
+		Wq_diag(:,q) = diag(Wq(:,:,q));
+	end
+	bct_test(sprintf("findwalks_wlq %s Wq_diag", mname{i}), Wq_diag == Wq_diag_cpp)
+end
+
 % reachdist
 for i = 1:size(m)(2)
 	[R D] = reachdist(m{i});
@@ -82,4 +133,12 @@ for i = 1:size(m)(2)
 	bct_test(sprintf("reachdist %s D", mname{i}), D == D_cpp)
 end
 
+% reachability
+for i = 1:size(m)(2)
+	R = reachdist(m{i});
+	[R_cpp R_adj_cpp] = reachability_cpp(m{i});
+	bct_test(sprintf("reachability %s", mname{i}), R == R_cpp)
+	bct_test(sprintf("reachability %s adjacency list", mname{i}), R == R_adj_cpp)
+end
+
 bct_test_teardown
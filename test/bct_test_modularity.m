@@ -56,6 +56,18 @@ for i = 1:size(m)(2)
 	bct_test(sprintf("module_degree_zscore %s", mname{i}), abs(module_degree_zscore(m{i}, Ci) - module_degree_zscore_cpp(m{i}, Ci)') < 1e-6)
 end
 
+% module_strength
+for i = 1:size(m)(2)
+	Ci = modularity_dir_cpp(m{i});
+	S = zeros(length(m{i}), max(Ci));
+	for j = 1:max(Ci)
+		S(:,j) = sum(m{i}(:,Ci == j), 2);
+	end
+	[S_cpp S_adj_cpp] = module_strength_cpp(m{i}, Ci);
+	bct_test(sprintf("module_strength %s", mname{i}), abs(S - S_cpp) < 1e-6)
+	bct_test(sprintf("module_strength %s adjacency list", mname{i}), abs(S - S_adj_cpp) < 1e-6)
+end
+
 % participation_coef
 for i = 1:size(m)(2)
 	Ci = modularity_dir_cpp(m{i});
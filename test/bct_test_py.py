@@ -0,0 +1,130 @@
+# Checks the NumPy conversions and threading in bct_py.  Build and install the
+# SWIG modules first (make swig && make swig-install), then run python
+# bct_test_py.py, or run make swig-check to build them in place and run this
+# file; each check is printed, and the exit status is nonzero if any fails.
+
+import gc
+import sys
+import threading
+import time
+
+import numpy
+
+import bct_py as bct
+
+failures = []
+
+def bct_test(name, passed):
+    print("%s: %s" % (name, "passed" if passed else "FAILED"))
+    if not passed:
+        failures.append(name)
+
+# A random undirected graph with positive weights
+numpy.random.seed(1)
+n = 30
+W = numpy.triu(numpy.random.rand(n, n) * (numpy.random.rand(n, n) < 0.3), 1)
+W = W + W.T
+deg = (W != 0).sum(axis=0).astype(float)
+strength = W.sum(axis=0)
+
+# Non-const arguments are written through to the caller's array, whether it is
+# viewed in place (C-ordered float64) or converted and copied back
+for name, out in [("float64", numpy.zeros(n)),
+                  ("float32", numpy.zeros(n, dtype=numpy.float32)),
+                  ("strided", numpy.zeros(2 * n)[::2])]:
+    bct.degrees_und_into(W, out)
+    bct_test("degrees_und_into writes back %s" % name, numpy.array_equal(out, deg))
+    bct.strengths_und_into(W, out)
+    bct_test("strengths_und_into writes back %s" % name, numpy.allclose(out, strength))
+D = numpy.zeros((n, n))
+bct.distance_wei_into(W, D)
+bct_test("distance_wei_into writes back", numpy.array_equal(D, bct.distance_wei(W)))
+for name, m in [("float64", W.copy()), ("Fortran order", numpy.asfortranarray(W))]:
+    bct.to_binary_in_place(m)
+    bct_test("to_binary_in_place writes back %s" % name, numpy.array_equal(m, (W != 0).astype(float)))
+
+# A const argument is never written to
+W_before = W.copy()
+bct.distance_wei(W)
+bct_test("const argument unchanged", numpy.array_equal(W, W_before))
+
+# A returned array owns the GSL result through a capsule; views of the array
+# keep that capsule alive after the array itself is gone
+D = bct.distance_wei(W)
+expected = D.copy()
+bct_test("result owned by capsule", type(D.base).__name__ == "PyCapsule")
+row = D[1]
+column = D[:, 2]
+del D
+gc.collect()
+garbage = [bct.distance_wei(W) for i in range(20)]
+del garbage
+gc.collect()
+bct_test("view outlives result", numpy.array_equal(row, expected[1]) and numpy.array_equal(column, expected[:, 2]))
+
+# Sequences of matrices passed by const reference accept a list of arrays or a
+# 3-D array; batch_run returns one row per graph for each measure
+A = (W != 0).astype(float)
+graphs = [W, 2 * W, A]
+for name, arg in [("list", graphs), ("3-D array", numpy.array(graphs))]:
+    result = bct.batch_run(arg, "degrees_und,density_und,strengths_und")
+    bct_test("batch_run %s measures" % name, sorted(result.keys()) == ["degrees_und", "density_und", "strengths_und"])
+    bct_test("batch_run %s degrees_und" % name, result["degrees_und"].shape == (3, n) and all(numpy.array_equal(row, deg) for row in result["degrees_und"]))
+    bct_test("batch_run %s density_und" % name, numpy.allclose(result["density_und"][:, 0], bct.density_und(W)))
+    bct_test("batch_run %s strengths_und" % name, numpy.allclose(result["strengths_und"], [strength, 2 * strength, deg]))
+try:
+    bct.batch_run(graphs, "no_such_measure")
+    bct_test("batch_run unknown measure raises", False)
+except RuntimeError:
+    bct_test("batch_run unknown measure raises", True)
+sources = list(range(n))
+fcyc, pcyc = bct.cycprob(A, sources, 3)
+Pq = bct.findpaths(A, sources, 3)[0]
+bct_test("cycprob_fcyc takes a list of matrices", numpy.allclose(bct.cycprob_fcyc(Pq), fcyc))
+bct_test("cycprob_pcyc takes a list of matrices", numpy.allclose(bct.cycprob_pcyc(Pq), pcyc))
+
+# Calls release the GIL, so measures run concurrently from several threads give
+# the same results as serial calls, and Python threads keep running meanwhile
+def run_threads(target, count):
+    results = [None] * count
+    def run(i):
+        try:
+            results[i] = target(i)
+        except Exception as e:
+            results[i] = e
+    threads = [threading.Thread(target=run, args=(i,)) for i in range(count)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    return results
+threaded = run_threads(lambda i: bct.distance_wei((i + 1) * W), 8)
+bct_test("distance_wei in threads", all(numpy.allclose(threaded[i], bct.distance_wei((i + 1) * W)) for i in range(8)))
+threaded = run_threads(lambda i: bct.batch_run(graphs, "degrees_und,strengths_und,charpath_lambda"), 4)
+serial = bct.batch_run(graphs, "degrees_und,strengths_und,charpath_lambda")
+bct_test("batch_run in threads", all(isinstance(r, dict) and all(numpy.array_equal(r[k], serial[k]) for k in serial) for r in threaded))
+threaded = run_threads(lambda i: bct.batch_run(graphs, "no_such_measure"), 4)
+bct_test("exception in threads raises RuntimeError", all(isinstance(r, RuntimeError) for r in threaded))
+
+# A Python thread that records the time every millisecond only runs during a
+# call if the call released the GIL; times near either end of the call could
+# have been recorded while the GIL was being handed over, so they are ignored
+m = 600
+G = numpy.random.rand(m, m) * (numpy.random.rand(m, m) < 0.2)
+ticks = [0.0]
+running = [True]
+def tick():
+    while running[0]:
+        t = time.time()
+        if t > ticks[-1] + 0.001:
+            ticks.append(t)
+ticker = threading.Thread(target=tick)
+ticker.start()
+start = time.time()
+bct.betweenness_wei(G)
+end = time.time()
+running[0] = False
+ticker.join()
+bct_test("GIL released during a call", end - start < 0.1 or any(start + 0.02 < t < end - 0.02 for t in ticks))
+
+sys.exit(1 if failures else 0)
@@ -1,8 +1,227 @@
 bct_test_setup
 
+% batch_run
+G = zeros(20, 20, 5);
+for k = 1:5
+	A = rand(20) > 0.7;
+	A(logical(eye(20))) = 0;
+	G(:,:,k) = triu(A) + triu(A)';
+end
+measures = {"degrees_und", "clustering_coef_bu", "charpath_lambda", "density_und", "strengths_und"};
+for i = 1:length(measures)
+	values = batch_run_cpp(G, measures{i});
+	for k = 1:5
+		switch measures{i}
+			case "charpath_lambda"
+				expected = charpath_lambda_cpp(distance_bin_cpp(G(:,:,k)));
+			otherwise
+				expected = feval([measures{i} "_cpp"], G(:,:,k));
+		end
+		bct_test(sprintf("batch_run %s %d", measures{i}, k), all(values(k,:) == expected(:)'))
+	end
+end
+
+% graph_context
+% Cached quantities are, in order, adjacency list, basic statistics, degrees,
+% strengths, triangles, binary distances, weighted distances, modules, and
+% module strengths
+for k = 1:5
+	A = G(:,:,k);
+	B = triu(A .* rand(20));
+	B = B + B';
+	for j = 1:2
+		if j == 1
+			W = A;
+			wname = "binary";
+		else
+			W = B;
+			wname = "weighted";
+		end
+		[value cached once] = graph_context_cpp(W, "assortativity_und");
+		bct_test(sprintf("graph_context %s %d assortativity_und", wname, k), abs(value - assortativity_und_cpp(W)) < 1e-6 && cached(3) && once)
+		[value cached once] = graph_context_cpp(W, "assortativity_dir");
+		bct_test(sprintf("graph_context %s %d assortativity_dir", wname, k), abs(value - assortativity_dir_cpp(W)) < 1e-6 && cached(2) && once)
+		D = distance_wei_cpp(W);
+		dmax = length(W) * mean(nonzeros(W));
+		expected = sum(sum(min(D, dmax))) / (length(W) ^ 2 - length(W));
+		[value cached once] = graph_context_cpp(W, "capped_charpath_lambda");
+		bct_test(sprintf("graph_context %s %d capped_charpath_lambda", wname, k), abs(value - expected) < 1e-6 && cached(7) && once)
+		[value cached once] = graph_context_cpp(W, "efficiency_global");
+		bct_test(sprintf("graph_context %s %d efficiency_global", wname, k), abs(value - efficiency_global_cpp(W)) < 1e-6 && cached(6) == (j == 1) && once)
+		[value cached once] = graph_context_cpp(W, "charpath_lambda");
+		bct_test(sprintf("graph_context %s %d charpath_lambda", wname, k), abs(value - charpath_lambda_cpp(distance_bin_cpp(W))) < 1e-6 && cached(6) && once)
+		[value cached once] = graph_context_cpp(W, "strengths_und");
+		bct_test(sprintf("graph_context %s %d strengths_und", wname, k), all(abs(value - strengths_und_cpp(W)) < 1e-6) && cached(4) && once)
+	end
+end
+
+% bit_matrix
+% Sizes straddle word boundaries so that partial words are exercised
+bit_sizes = {[1 1], [3 70], [65 129]};
+for i = 1:size(bit_sizes)(2)
+	b = rand(bit_sizes{i}) > 0.5;
+	[b_cpp b_get_cpp b_count_cpp] = bit_matrix_cpp(b);
+	bct_test(sprintf("bit_matrix %dx%d to_matrix", bit_sizes{i}), isequal(double(b), b_cpp))
+	bct_test(sprintf("bit_matrix %dx%d get", bit_sizes{i}), isequal(double(b), b_get_cpp))
+	bct_test(sprintf("bit_matrix %dx%d bit_count", bit_sizes{i}), isequal(sum(b, 2)', b_count_cpp))
+end
+for i = 1:size(m)(2)
+	[b_cpp b_get_cpp] = bit_matrix_cpp(m{i});
+	bct_test(sprintf("bit_matrix %s", mname{i}), isequal(double(m{i} != 0), b_cpp) && isequal(b_cpp, b_get_cpp))
+end
+
 W = rand(10);
 W(logical(eye(10))) = 0;
 
+% matrix_status
+% Expected flags follow the per-property checks used before matrix_status
+% classified matrices in one pass: elements within tolerance (two units in the
+% last place) are equal, elements within epsilon of zero are zero, and loops are
+% exactly nonzero diagonal elements.  Rectangular matrices are directed.
+pairs = [1 2; 4 8; 16 32; 64 128; 256 512];
+status_sizes = {[1 1], [63 63], [64 64], [65 65], [130 130], [70 130], [130 70]};
+status_m = {};
+status_mname = {};
+for i = 1:size(status_sizes)(2)
+	n = status_sizes{i};
+	k = min(n);
+	A = double(rand(k) > 0.7);
+	A = triu(A, 1) + triu(A, 1)';
+	B = zeros(n);
+	B(1:k,1:k) = A;
+	S = triu(A .* (1 + rand(k)), 1);
+	variants = {B, B .* (1 + rand(n)), B};
+	variants{3}(1:k,1:k) = S + S';
+	vname = {"binary", "weighted", "symmetric weighted"};
+	for j = 1:3
+		V = variants{j};
+		status_m{end + 1} = V;
+		status_mname{end + 1} = sprintf("%dx%d %s", n, vname{j});
+		
+		% Changes in the last element, so that tiles before it cannot decide
+		changes = {1, 1 + eps(1), 2, -1, 1e-20};
+		cname = {"loop", "near one", "asymmetric", "negative", "near zero"};
+		for c = 1:size(changes)(2)
+			W = V;
+			if c == 1
+				W(k,k) = changes{c};
+			else
+				W(k,max(k - 1, 1)) = changes{c};
+			end
+			status_m{end + 1} = W;
+			status_mname{end + 1} = sprintf("%dx%d %s %s", n, vname{j}, cname{c});
+		end
+		
+		% Asymmetry within tolerance
+		W = V;
+		W(k,max(k - 1, 1)) = W(max(k - 1, 1),k) + eps(W(max(k - 1, 1),k));
+		status_m{end + 1} = W;
+		status_mname{end + 1} = sprintf("%dx%d %s asymmetric within tolerance", n, vname{j});
+	end
+end
+for i = 1:size(m)(2)
+	status_m{end + 1} = m{i};
+	status_mname{end + 1} = mname{i};
+end
+for i = 1:size(status_m)(2)
+	W = status_m{i};
+	square = rows(W) == columns(W);
+	if square
+		zero = abs(W) < eps & abs(W') < eps;
+		directed = any(any(abs(W - W') > 2 * eps(max(abs(W), abs(W'))) & !zero));
+	else
+		directed = true;
+	end
+	weighted = any(abs(W(:)) > eps & abs(W(:) - 1) > 2 * eps(max(abs(W(:)), 1)));
+	signed = any(W(:) < 0);
+	loops = any(diag(W) != 0);
+	expected = [2 - square, 4 + 4 * directed, 16 + 16 * weighted, 64 + 64 * signed, 256 + 256 * loops];
+	bct_test(sprintf("matrix_status %s", status_mname{i}), matrix_status_cpp(W) == sum(expected))
+	
+	% Requesting one flag determines only its pair, and may stop early
+	for p = 1:rows(pairs)
+		for q = 1:2
+			status = matrix_status_cpp(W, pairs(p,q));
+			determined = bitand(status, sum(pairs(2:end,:)(:)));
+			bct_test(sprintf("matrix_status %s flag %d", status_mname{i}, pairs(p,q)), bitand(status, 3) == expected(1) && determined == (p > 1) * expected(p))
+		end
+	end
+end
+
+% cache_status, uncache_status, and clear_status_cache
+for i = 1:size(m)(2)
+	A = double(m{i} != 0);
+	A = triu(A, 1) + triu(A, 1)';
+	bct_test(sprintf("status cache %s", mname{i}), all(status_cache_cpp(A)))
+end
+
+% packed_matrix
+% Each packed overload must match the full matrix result, and randmio_und must
+% make the same swaps when the random number generator is seeded the same way
+packed_measures = {"degrees_und", "strengths_und", "density_und", "number_of_edges_und", "clustering_coef_wu"};
+for i = 1:size(m)(2)
+	P = triu(m{i}, 1) + triu(m{i}, 1)';
+	for j = 1:length(packed_measures)
+		[full packed] = packed_matrix_cpp(P, packed_measures{j});
+		bct_test(sprintf("packed_matrix %s %s", packed_measures{j}, mname{i}), isequal(full, packed))
+	end
+	[full packed] = packed_matrix_cpp(P, "threshold_proportional_und", 0.3);
+	bct_test(sprintf("packed_matrix threshold_proportional_und %s", mname{i}), isequal(full, packed))
+	[full packed] = packed_matrix_cpp(double(P != 0), "randmio_und", 10, 1234);
+	bct_test(sprintf("packed_matrix randmio_und %s", mname{i}), isequal(full, packed))
+end
+
+% _into and _in_place
+% Results computed into existing outputs, with scratch space reused between
+% graphs with different numbers of edges, must match the allocating functions
+into_measures = {"degrees_und", "strengths_und", "clustering_coef_wu", "betweenness_wei"};
+in_place_conversions = {"invert_elements", "remove_loops", "to_binary", "to_positive", "to_undirected_bin", "to_undirected_wei"};
+in_place_expected = {@(A) (A != 0) ./ (A + (A == 0)), @(A) A .* !eye(length(A)), @(A) double(A != 0), @abs, @(A) double(A != 0 | A' != 0), @(A) (A + A') / 2};
+for i = 1:size(m)(2)
+	P = abs(triu(m{i}, 1) + triu(m{i}, 1)');
+	for j = 1:length(into_measures)
+		[value value_into value_adj_into rejected] = into_cpp(P, into_measures{j});
+		bct_test(sprintf("%s_into %s", into_measures{j}, mname{i}), all(abs(value - value_into) < 1e-6) && (isempty(value_adj_into) || isequal(value_into, value_adj_into)) && rejected)
+	end
+	[D D_into D_adj_into D_rows rejected] = into_cpp(P, "distance_wei");
+	bct_test(sprintf("distance_wei_into %s", mname{i}), isequal(D, D_into) && isequal(D, D_adj_into) && isequal(D, D_rows) && rejected)
+	for j = 1:length(in_place_conversions)
+		[converted converted_in_place] = in_place_cpp(m{i}, in_place_conversions{j});
+		bct_test(sprintf("%s_in_place %s", in_place_conversions{j}, mname{i}), isequal(converted, converted_in_place) && all(all(abs(converted_in_place - in_place_expected{j}(m{i})) < 1e-6)))
+	end
+end
+
+% sort, unique, and setxor
+% Elements have many ties, NaNs, and both signed zeros.  Sizes cover short runs,
+% radix sorted runs, and inputs long enough to be sorted in parallel runs that
+% are then merged.
+function match = nanmatch(x, y)
+	match = isequal(size(x), size(y)) && isequal(isnan(x), isnan(y)) && isequal(x(!isnan(x)), y(!isnan(y)));
+end
+sort_sizes = [100 300 5000 70000];
+for n = sort_sizes
+	x = round(10 * rand(1, n)) - 5;
+	x(rand(1, n) < 0.05) = NaN;
+	x(x == 0 & rand(1, n) < 0.5) = -0;
+	for mode = {"ascend", "descend"}
+		[y i] = sort(x, mode{1});
+		[y_cpp i_cpp] = sort_cpp(x, mode{1});
+		bct_test(sprintf("sort %d %s", n, mode{1}), nanmatch(y, y_cpp) && isequal(i, i_cpp))
+	end
+	X = reshape(x(1:3 * floor(n / 3)), [], 3);
+	[Y I] = sort(X, "descend");
+	[Y_cpp I_cpp] = sort_cpp(X, "descend");
+	bct_test(sprintf("sort %d columns", n), nanmatch(Y, Y_cpp) && isequal(I, I_cpp))
+	for first_or_last = {"first", "last"}
+		[y i j] = unique(x, first_or_last{1});
+		[y_cpp i_cpp j_cpp] = unique_cpp(x, first_or_last{1});
+		bct_test(sprintf("unique %d %s", n, first_or_last{1}), nanmatch(y, y_cpp) && isequal(i(:)', i_cpp) && isequal(j(:)', j_cpp))
+	end
+	z = round(20 * rand(1, n)) - 10;
+	z(rand(1, n) < 0.05) = NaN;
+	bct_test(sprintf("setxor %d", n), nanmatch(setxor(x, z), setxor_cpp(x, z)))
+end
+
 % threshold_absolute
 bct_test("threshold_absolute", threshold_absolute(W, 0.5) == threshold_absolute_cpp(W, 0.5))
 
@@ -13,4 +232,64 @@ bct_test("threshold_proportional_dir", threshold_proportional(W, 0.5) == thresho
 W = triu(W) + triu(W)';
 bct_test("threshold_proportional_und", threshold_proportional(W, 0.5) == threshold_proportional_und_cpp(W, 0.5))
 
+% threshold_sweep
+thr = [0.9 0.5 0.7 0.1 0.3 1.1];
+W = rand(10);
+W(logical(eye(10))) = 0;
+[W_thr deg str] = threshold_sweep_cpp(W, thr, false);
+for i = 1:length(thr)
+	W_i = threshold_absolute(W, thr(i));
+	[id od deg_i] = degrees_dir(W_i);
+	[is os str_i] = strengths_dir(W_i);
+	bct_test(sprintf("threshold_sweep_dir %g W_thr", thr(i)), W_thr(:,:,i) == W_i)
+	bct_test(sprintf("threshold_sweep_dir %g deg", thr(i)), deg(i,:) == deg_i)
+	bct_test(sprintf("threshold_sweep_dir %g str", thr(i)), abs(str(i,:) - str_i) < 1e-6)
+end
+W = triu(W) + triu(W)';
+[W_thr deg str] = threshold_sweep_cpp(W, thr, true);
+for i = 1:length(thr)
+	W_i = threshold_absolute(W, thr(i));
+	bct_test(sprintf("threshold_sweep_und %g W_thr", thr(i)), W_thr(:,:,i) == W_i)
+	bct_test(sprintf("threshold_sweep_und %g deg", thr(i)), deg(i,:) == degrees_und(W_i))
+	bct_test(sprintf("threshold_sweep_und %g str", thr(i)), abs(str(i,:) - strengths_und(W_i)) < 1e-6)
+end
+
+% read_connectome and write_connectome
+W = rand(20) .* (rand(20) > 0.7);
+W(logical(eye(20))) = 0;
+filename = tempname();
+for sparse = [false true]
+	write_connectome_cpp(W, filename, sparse);
+	[R R_mapped] = read_connectome_cpp(filename);
+	bct_test(sprintf("read_connectome sparse=%d", sparse), R == W)
+	bct_test(sprintf("connectome_open sparse=%d", sparse), R_mapped == W)
+end
+
+% Malformed sparse files are rejected rather than read out of bounds
+fid = fopen(filename, "r");
+bytes = fread(fid, Inf, "uint8=>uint8");
+fclose(fid);
+offsets = 64;
+nodes = ceil((offsets + 21 * 4) / 64) * 64;
+bad = {bytes(1:end - 8), bytes, bytes, bytes, bytes, bytes};
+bad{2}(nodes + 1:nodes + 4) = typecast(int32(20), "uint8");
+bad{3}(nodes + 1:nodes + 4) = typecast(int32(-1), "uint8");
+bad{4}(offsets + 5:offsets + 8) = typecast(int32(1000), "uint8");
+bad{5}(offsets + 1:offsets + 4) = typecast(int32(1), "uint8");
+bad{6}(25:32) = typecast(uint64(2^40), "uint8");
+badname = {"truncated", "column too large", "negative column", "decreasing offsets", "nonzero first offset", "size too large"};
+for i = 1:length(bad)
+	fid = fopen(filename, "w");
+	fwrite(fid, bad{i}, "uint8");
+	fclose(fid);
+	rejected = false;
+	try
+		read_connectome_cpp(filename);
+	catch
+		rejected = true;
+	end_try_catch
+	bct_test(sprintf("read_connectome rejects %s", badname{i}), rejected)
+end
+delete(filename);
+
 bct_test_teardown
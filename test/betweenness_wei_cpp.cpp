@@ -1,3 +1,27 @@
 #include "bct_test.h"
 
-MATRIX_TO_VECTOR_FUNCTION(betweenness_wei)
+/*
+ * Returns the result for the matrix and for its adjacency list.
+ */
+DEFUN_DLD(betweenness_wei_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 1) {
+		return octave_value_list();
+	}
+	Matrix G = args(0).matrix_value();
+	if (!error_state) {
+		gsl_matrix* G_gsl = bct_test::to_gslm(G);
+		gsl_vector* ret_gsl = bct::betweenness_wei(G_gsl);
+		bct::adjacency_list* adj = bct::to_adjacency_list(G_gsl);
+		gsl_vector* ret_adj_gsl = bct::betweenness_wei(adj);
+		octave_value_list ret;
+		ret(0) = octave_value(bct_test::from_gsl(ret_gsl));
+		ret(1) = octave_value(bct_test::from_gsl(ret_adj_gsl));
+		gsl_matrix_free(G_gsl);
+		gsl_vector_free(ret_gsl);
+		bct::adjacency_list_free(adj);
+		gsl_vector_free(ret_adj_gsl);
+		return ret;
+	} else {
+		return octave_value_list();
+	}
+}
@@ -0,0 +1,53 @@
+#include "bct_test.h"
+
+DEFUN_DLD(bit_matrix_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 1) {
+		return octave_value_list();
+	}
+	Matrix m = args(0).matrix_value();
+	if (!error_state) {
+		gsl_matrix* m_gsl = bct_test::to_gslm(m);
+		bct::bit_matrix* bits = bct::bit_matrix_alloc(m_gsl->size1, m_gsl->size2);
+		
+		// Set every bit, then clear the bits of zero elements, so that both
+		// operations are exercised
+		for (int i = 0; i < (int)m_gsl->size1; i++) {
+			for (int j = 0; j < (int)m_gsl->size2; j++) {
+				bct::bit_matrix_set(bits, i, j, true);
+			}
+		}
+		for (int i = 0; i < (int)m_gsl->size1; i++) {
+			for (int j = 0; j < (int)m_gsl->size2; j++) {
+				if (gsl_matrix_get(m_gsl, i, j) == 0.0) {
+					bct::bit_matrix_set(bits, i, j, false);
+				}
+			}
+		}
+		
+		gsl_matrix* converted = bct::bit_matrix_to_matrix(bits);
+		gsl_matrix* got = gsl_matrix_calloc(m_gsl->size1, m_gsl->size2);
+		gsl_vector* counts = gsl_vector_calloc(m_gsl->size1);
+		for (int i = 0; i < (int)m_gsl->size1; i++) {
+			for (int j = 0; j < (int)m_gsl->size2; j++) {
+				gsl_matrix_set(got, i, j, bct::bit_matrix_get(bits, i, j) ? 1.0 : 0.0);
+			}
+			int count = 0;
+			for (int k = 0; k < bits->words; k++) {
+				count += bct::bit_count(bits->data[i * bits->words + k]);
+			}
+			gsl_vector_set(counts, i, count);
+		}
+		octave_value_list ret;
+		ret(0) = octave_value(bct_test::from_gsl(converted));
+		ret(1) = octave_value(bct_test::from_gsl(got));
+		ret(2) = octave_value(bct_test::from_gsl(counts));
+		gsl_matrix_free(m_gsl);
+		bct::bit_matrix_free(bits);
+		gsl_matrix_free(converted);
+		gsl_matrix_free(got);
+		gsl_vector_free(counts);
+		return ret;
+	} else {
+		return octave_value_list();
+	}
+}
@@ -0,0 +1,48 @@
+#include <gsl/gsl_math.h>
+
+#include "bct_test.h"
+
+DEFUN_DLD(breadth_batch_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 2) {
+		return octave_value_list();
+	}
+	Matrix CIJ = args(0).matrix_value();
+	Matrix sources = args(1).matrix_value();
+	if (!error_state) {
+		gsl_matrix* CIJ_gsl = bct_test::to_gslm(CIJ);
+		gsl_vector* sources_gsl = bct_test::to_gslv(sources);
+		gsl_vector_add_constant(sources_gsl, -1.0);
+		gsl_matrix* branch;
+		gsl_matrix* distance = bct::breadth_batch(CIJ_gsl, sources_gsl, &branch);
+		for (int i = 0; i < (int)branch->size1; i++) {
+			for (int j = 0; j < (int)branch->size2; j++) {
+				int value = (int)gsl_matrix_get(branch, i, j);
+				if (gsl_isinf(gsl_matrix_get(distance, i, j)) == 0 && value != -1) {
+					gsl_matrix_set(branch, i, j, (double)value + 1.0);
+				}
+			}
+		}
+		int n = CIJ_gsl->size1;
+		bct::adjacency_list* adj = bct::to_adjacency_list(CIJ_gsl);
+		bct::breadth_workspace* ws_wrong = bct::breadth_workspace_alloc(n + 1);
+		double* distance_wrong = new double[n + 1];
+		int sources_wrong[1] = { 0 };
+		int rejected = 0;
+		try { bct::breadth(adj, 0, ws_wrong, distance_wrong); } catch (bct::bct_exception& e) { rejected++; }
+		try { bct::breadth_batch(adj, sources_wrong, 1, ws_wrong, distance_wrong); } catch (bct::bct_exception& e) { rejected++; }
+		octave_value_list ret;
+		ret(0) = octave_value(bct_test::from_gsl(distance));
+		ret(1) = octave_value(bct_test::from_gsl(branch));
+		ret(2) = octave_value(rejected == 2);
+		delete[] distance_wrong;
+		bct::breadth_workspace_free(ws_wrong);
+		bct::adjacency_list_free(adj);
+		gsl_matrix_free(CIJ_gsl);
+		gsl_vector_free(sources_gsl);
+		gsl_matrix_free(branch);
+		gsl_matrix_free(distance);
+		return ret;
+	} else {
+		return octave_value_list();
+	}
+}
@@ -0,0 +1,23 @@
+#include "bct_test.h"
+
+DEFUN_DLD(charpath_ecc_m_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 1) {
+		return octave_value_list();
+	}
+	Matrix L = args(0).matrix_value();
+	if (!error_state) {
+		gsl_matrix* L_gsl = bct_test::to_gslm(L);
+		double radius;
+		double diameter;
+		gsl_vector* ecc = bct::charpath_ecc_m(L_gsl, &radius, &diameter);
+		octave_value_list ret;
+		ret(0) = octave_value(bct_test::from_gsl(ecc));
+		ret(1) = octave_value(radius);
+		ret(2) = octave_value(diameter);
+		gsl_matrix_free(L_gsl);
+		gsl_vector_free(ecc);
+		return ret;
+	} else {
+		return octave_value_list();
+	}
+}
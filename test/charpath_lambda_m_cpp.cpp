@@ -0,0 +1,3 @@
+#include "bct_test.h"
+
+MATRIX_TO_SCALAR_FUNCTION(charpath_lambda_m)
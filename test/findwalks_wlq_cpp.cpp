@@ -0,0 +1,23 @@
+#include "bct_test.h"
+
+DEFUN_DLD(findwalks_wlq_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 2) {
+		return octave_value_list();
+	}
+	Matrix CIJ = args(0).matrix_value();
+	int qmax = args(1).int_value();
+	if (!error_state) {
+		gsl_matrix* CIJ_gsl = bct_test::to_gslm(CIJ);
+		gsl_matrix* Wq_diag;
+		gsl_vector* wlq = bct::findwalks_wlq(CIJ_gsl, qmax, &Wq_diag);
+		octave_value_list ret;
+		ret(0) = octave_value(bct_test::from_gsl(wlq, 1));
+		ret(1) = octave_value(bct_test::from_gsl(Wq_diag, 0, 1));
+		gsl_matrix_free(CIJ_gsl);
+		gsl_vector_free(wlq);
+		gsl_matrix_free(Wq_diag);
+		return ret;
+	} else {
+		return octave_value_list();
+	}
+}
@@ -0,0 +1,59 @@
+#include <gsl/gsl_math.h>
+#include <string>
+
+#include "bct_test.h"
+
+/*
+ * Returns the named measure computed through a graph context, and which
+ * quantities the context had cached afterwards, in the order adjacency list,
+ * basic statistics, degrees, strengths, triangles, binary distances, weighted
+ * distances, modules, and module strengths.  The third value is true if
+ * computing the measure again neither recomputed nor replaced any cached
+ * quantity and gave the same result.
+ */
+DEFUN_DLD(graph_context_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 2) {
+		return octave_value_list();
+	}
+	Matrix W = args(0).matrix_value();
+	std::string measure = args(1).string_value();
+	if (!error_state) {
+		gsl_matrix* W_gsl = bct_test::to_gslm(W);
+		bct::graph_context* context = bct::graph_context_alloc(W_gsl);
+		gsl_vector* value = bct::context_measure(context, measure);
+		const void* cached[] = {
+			context->adj, context->stats, context->deg, context->str, context->triangles,
+			context->D_bin, context->D_wei, context->Ci, context->S
+		};
+		const int n_cached = sizeof(cached) / sizeof(cached[0]);
+		gsl_vector* is_cached = gsl_vector_alloc(n_cached);
+		for (int i = 0; i < n_cached; i++) {
+			gsl_vector_set(is_cached, i, cached[i] != NULL);
+		}
+		gsl_vector* value_again = bct::context_measure(context, measure);
+		const void* cached_again[] = {
+			context->adj, context->stats, context->deg, context->str, context->triangles,
+			context->D_bin, context->D_wei, context->Ci, context->S
+		};
+		bool once = value->size == value_again->size;
+		for (int i = 0; once && i < (int)value->size; i++) {
+			once = gsl_vector_get(value, i) == gsl_vector_get(value_again, i) ||
+				(gsl_isnan(gsl_vector_get(value, i)) && gsl_isnan(gsl_vector_get(value_again, i)));
+		}
+		for (int i = 0; i < n_cached; i++) {
+			once = once && cached[i] == cached_again[i];
+		}
+		octave_value_list ret;
+		ret(0) = octave_value(bct_test::from_gsl(value));
+		ret(1) = octave_value(bct_test::from_gsl(is_cached));
+		ret(2) = octave_value(once);
+		gsl_matrix_free(W_gsl);
+		bct::graph_context_free(context);
+		gsl_vector_free(value);
+		gsl_vector_free(is_cached);
+		gsl_vector_free(value_again);
+		return ret;
+	} else {
+		return octave_value_list();
+	}
+}
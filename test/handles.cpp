@@ -0,0 +1,106 @@
+#if __cplusplus < 201103L
+#error "test/handles.cpp checks the C++11 handles in bct.h and must be compiled as C++11"
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+#include "../bct.h"
+
+/*
+ * Checks the owning handles in bct.h, which are only declared when compiling as
+ * C++11 or later.  Memory allocated with new is counted, so a handle that frees
+ * an adjacency list or a packed matrix through the library's deleter can be
+ * told apart from one that leaks it.  Prints each check and exits with a
+ * nonzero status if any fails.
+ */
+namespace bct_handles {
+	long live = 0;
+	int failures = 0;
+	
+	void check(const char* name, bool passed);
+}
+
+void* operator new(std::size_t size) {
+	void* p = std::malloc((size > 0) ? size : 1);
+	if (p == NULL) {
+		throw std::bad_alloc();
+	}
+	bct_handles::live++;
+	return p;
+}
+
+void operator delete(void* p) noexcept {
+	if (p != NULL) {
+		bct_handles::live--;
+		std::free(p);
+	}
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	operator delete(p);
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void operator delete[](void* p) noexcept {
+	operator delete(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+	operator delete(p);
+}
+
+void bct_handles::check(const char* name, bool passed) {
+	std::printf("%s: %s\n", name, passed ? "passed" : "FAILED");
+	if (!passed) {
+		failures++;
+	}
+}
+
+int main() {
+	using namespace bct_handles;
+	static_assert(std::is_same<bct::matrix_handle::deleter_type, bct::deleter>::value, "handles must free through bct::deleter");
+	
+	// A ring of five nodes with distinct weights
+	const int N = 5;
+	bct::matrix_handle G = bct::own(bct::zeros(N));
+	for (int i = 0; i < N; i++) {
+		gsl_matrix_set(G.get(), i, (i + 1) % N, i + 1.0);
+		gsl_matrix_set(G.get(), (i + 1) % N, i, i + 1.0);
+	}
+	
+	long before = live;
+	{
+		bct::handle<bct::adjacency_list> adj = bct::own(bct::to_adjacency_list(G.get()));
+		check("adjacency_list allocated", live > before && adj->offsets[N] == 2 * N);
+	}
+	check("adjacency_list freed by handle", live == before);
+	{
+		bct::handle<bct::packed_matrix> packed = bct::own(bct::to_packed_matrix(G.get()));
+		check("packed_matrix allocated", live > before && bct::packed_matrix_get(packed.get(), 0, 1) == 1.0);
+		packed.reset();
+		check("packed_matrix freed by reset", live == before);
+	}
+	
+	// output() hands the out-parameter to the handle once the call returns
+	bct::vector_handle BC;
+	bct::matrix_handle EBC = bct::own(bct::edge_betweenness_wei(G.get(), bct::output(BC)));
+	bct::vector_handle BC_expected = bct::own(bct::betweenness_wei(G.get()));
+	bool same = BC != NULL && BC->size == BC_expected->size;
+	for (int i = 0; same && i < N; i++) {
+		same = gsl_vector_get(BC.get(), i) == gsl_vector_get(BC_expected.get(), i);
+	}
+	check("output captures out-parameter", same);
+	check("output leaves result to own", EBC != NULL && (int)EBC->size1 == N);
+	
+	// A view accepts a handle and a raw pointer alike without taking ownership
+	bct::matrix_view view = G;
+	check("view refers to handle", view.get() == G.get());
+	
+	return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+#include <string>
+
+#include "bct_test.h"
+
+/*
+ * Returns the named conversion applied to a copy of the matrix and applied in
+ * place.
+ */
+DEFUN_DLD(in_place_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 2) {
+		return octave_value_list();
+	}
+	Matrix m = args(0).matrix_value();
+	std::string conversion = args(1).string_value();
+	if (!error_state) {
+		gsl_matrix* m_gsl = bct_test::to_gslm(m);
+		gsl_matrix* copy;
+		if (conversion == "invert_elements") {
+			copy = bct::invert_elements(m_gsl);
+			bct::invert_elements_in_place(m_gsl);
+		} else if (conversion == "remove_loops") {
+			copy = bct::remove_loops(m_gsl);
+			bct::remove_loops_in_place(m_gsl);
+		} else if (conversion == "to_binary") {
+			copy = bct::to_binary(m_gsl);
+			bct::to_binary_in_place(m_gsl);
+		} else if (conversion == "to_positive") {
+			copy = bct::to_positive(m_gsl);
+			bct::to_positive_in_place(m_gsl);
+		} else if (conversion == "to_undirected_bin") {
+			copy = bct::to_undirected_bin(m_gsl);
+			bct::to_undirected_bin_in_place(m_gsl);
+		} else {
+			copy = bct::to_undirected_wei(m_gsl);
+			bct::to_undirected_wei_in_place(m_gsl);
+		}
+		octave_value_list ret;
+		ret(0) = octave_value(bct_test::from_gsl(copy));
+		ret(1) = octave_value(bct_test::from_gsl(m_gsl));
+		gsl_matrix_free(m_gsl);
+		gsl_matrix_free(copy);
+		return ret;
+	} else {
+		return octave_value_list();
+	}
+}
@@ -0,0 +1,129 @@
+#include <string>
+
+#include "bct_test.h"
+
+/*
+ * Returns the named measure computed by the function that allocates its
+ * result, by the matrix _into function, and by the adjacency list _into
+ * function (empty if there is none).  betweenness_wei has no matrix _into
+ * function, so its first two values come from the adjacency list functions.  Scratch space passed to the matrix
+ * function is reused for a sparser graph in between, so that it both grows and
+ * shrinks before the returned result is computed.  For distance_wei, the fourth
+ * value holds the rows found by distance_wei_row with a reused workspace.  The
+ * last value is true if every output of the wrong size was rejected.
+ */
+DEFUN_DLD(into_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 2) {
+		return octave_value_list();
+	}
+	Matrix W = args(0).matrix_value();
+	std::string measure = args(1).string_value();
+	if (!error_state) {
+		gsl_matrix* W_gsl = bct_test::to_gslm(W);
+		int n = W_gsl->size1;
+		gsl_matrix* W_sparse = gsl_matrix_calloc(n, n);
+		for (int i = 0; i < n; i++) {
+			for (int j = 0; j < n; j++) {
+				if ((i + j) % 2 == 0) {
+					gsl_matrix_set(W_sparse, i, j, gsl_matrix_get(W_gsl, i, j));
+				}
+			}
+		}
+		bct::adjacency_list* adj = bct::to_adjacency_list(W_gsl);
+		int rejected = 0;
+		int wrong_size = 0;
+		octave_value_list ret;
+		if (measure == "distance_wei") {
+			gsl_matrix* D = bct::distance_wei(W_gsl);
+			gsl_matrix* D_into = gsl_matrix_alloc(n, n);
+			bct::distance_wei_workspace* ws = bct::distance_wei_workspace_alloc(n);
+			bct::distance_wei_into(W_sparse, D_into, ws);
+			bct::distance_wei_into(W_gsl, D_into, ws);
+			bct::distance_wei_into(W_sparse, D_into, ws);
+			bct::distance_wei_into(W_gsl, D_into, ws);
+			gsl_matrix* D_adj_into = gsl_matrix_alloc(n, n);
+			bct::distance_wei_into(adj, D_adj_into, ws);
+			gsl_matrix* D_rows = gsl_matrix_alloc(n, n);
+			gsl_vector* D_row = gsl_vector_alloc(n);
+			for (int i = 0; i < n; i++) {
+				bct::distance_wei_row(adj, i, D_row, ws);
+				gsl_matrix_set_row(D_rows, i, D_row);
+			}
+			gsl_matrix* D_wrong = gsl_matrix_alloc(n + 1, n);
+			gsl_vector* D_row_wrong = gsl_vector_alloc(n + 1);
+			bct::distance_wei_workspace* ws_wrong = bct::distance_wei_workspace_alloc(n + 1);
+			try { wrong_size++; bct::distance_wei_into(W_gsl, D_wrong); } catch (bct::bct_exception& e) { rejected++; }
+			try { wrong_size++; bct::distance_wei_into(adj, D_wrong); } catch (bct::bct_exception& e) { rejected++; }
+			try { wrong_size++; bct::distance_wei_into(W_gsl, D_into, ws_wrong); } catch (bct::bct_exception& e) { rejected++; }
+			try { wrong_size++; bct::distance_wei_into(adj, D_into, ws_wrong); } catch (bct::bct_exception& e) { rejected++; }
+			try { wrong_size++; bct::distance_wei_row(adj, 0, D_row_wrong); } catch (bct::bct_exception& e) { rejected++; }
+			try { wrong_size++; bct::distance_wei_row(adj, 0, D_row, ws_wrong); } catch (bct::bct_exception& e) { rejected++; }
+			ret(0) = octave_value(bct_test::from_gsl(D));
+			ret(1) = octave_value(bct_test::from_gsl(D_into));
+			ret(2) = octave_value(bct_test::from_gsl(D_adj_into));
+			ret(3) = octave_value(bct_test::from_gsl(D_rows));
+			gsl_matrix_free(D);
+			gsl_matrix_free(D_into);
+			gsl_matrix_free(D_adj_into);
+			gsl_matrix_free(D_rows);
+			gsl_vector_free(D_row);
+			gsl_matrix_free(D_wrong);
+			gsl_vector_free(D_row_wrong);
+			bct::distance_wei_workspace_free(ws);
+			bct::distance_wei_workspace_free(ws_wrong);
+		} else {
+			gsl_vector* value;
+			gsl_vector* value_into = gsl_vector_alloc(n);
+			gsl_vector* value_adj_into = gsl_vector_alloc(n);
+			gsl_vector* value_wrong = gsl_vector_alloc(n + 1);
+			bool has_adj = true;
+			if (measure == "degrees_und") {
+				value = bct::degrees_und(W_gsl);
+				bct::degrees_und_into(W_sparse, value_into);
+				bct::degrees_und_into(W_gsl, value_into);
+				has_adj = false;
+				try { wrong_size++; bct::degrees_und_into(W_gsl, value_wrong); } catch (bct::bct_exception& e) { rejected++; }
+			} else if (measure == "strengths_und") {
+				value = bct::strengths_und(W_gsl);
+				bct::strengths_und_into(W_sparse, value_into);
+				bct::strengths_und_into(W_gsl, value_into);
+				has_adj = false;
+				try { wrong_size++; bct::strengths_und_into(W_gsl, value_wrong); } catch (bct::bct_exception& e) { rejected++; }
+			} else if (measure == "clustering_coef_wu") {
+				value = bct::clustering_coef_wu(W_gsl);
+				bct::adjacency_list* scratch = bct::adjacency_list_alloc(n, 0);
+				bct::clustering_coef_wu_into(W_sparse, value_into, scratch);
+				bct::clustering_coef_wu_into(W_gsl, value_into, scratch);
+				bct::clustering_coef_wu_into(W_sparse, value_into, scratch);
+				bct::clustering_coef_wu_into(W_gsl, value_into, scratch);
+				bct::clustering_coef_wu_into(adj, value_adj_into);
+				bct::adjacency_list* scratch_wrong = bct::adjacency_list_alloc(n + 1, 0);
+				try { wrong_size++; bct::clustering_coef_wu_into(W_gsl, value_wrong); } catch (bct::bct_exception& e) { rejected++; }
+				try { wrong_size++; bct::clustering_coef_wu_into(adj, value_wrong); } catch (bct::bct_exception& e) { rejected++; }
+				try { wrong_size++; bct::clustering_coef_wu_into(W_gsl, value_into, scratch_wrong); } catch (bct::bct_exception& e) { rejected++; }
+				bct::adjacency_list_free(scratch);
+				bct::adjacency_list_free(scratch_wrong);
+			} else {
+				value = bct::betweenness_wei(adj);
+				gsl_vector_set_all(value_into, 1.0);
+				bct::betweenness_wei_into(adj, value_into);
+				bct::betweenness_wei_into(adj, value_adj_into);
+				try { wrong_size++; bct::betweenness_wei_into(adj, value_wrong); } catch (bct::bct_exception& e) { rejected++; }
+			}
+			ret(0) = octave_value(bct_test::from_gsl(value));
+			ret(1) = octave_value(bct_test::from_gsl(value_into));
+			ret(2) = has_adj ? octave_value(bct_test::from_gsl(value_adj_into)) : octave_value(Matrix());
+			gsl_vector_free(value);
+			gsl_vector_free(value_into);
+			gsl_vector_free(value_adj_into);
+			gsl_vector_free(value_wrong);
+		}
+		ret(ret.length()) = octave_value(rejected == wrong_size);
+		gsl_matrix_free(W_gsl);
+		gsl_matrix_free(W_sparse);
+		bct::adjacency_list_free(adj);
+		return ret;
+	} else {
+		return octave_value_list();
+	}
+}
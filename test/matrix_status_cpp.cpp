@@ -0,0 +1,21 @@
+#include "bct_test.h"
+
+DEFUN_DLD(matrix_status_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 1 && args.length() != 2) {
+		return octave_value_list();
+	}
+	Matrix m = args(0).matrix_value();
+	if (!error_state) {
+		gsl_matrix* m_gsl = bct_test::to_gslm(m);
+		int status;
+		if (args.length() == 2) {
+			status = bct::matrix_status(m_gsl, args(1).int_value());
+		} else {
+			status = bct::matrix_status(m_gsl);
+		}
+		gsl_matrix_free(m_gsl);
+		return octave_value((double)status);
+	} else {
+		return octave_value_list();
+	}
+}
@@ -0,0 +1,27 @@
+#include "bct_test.h"
+
+DEFUN_DLD(module_strength_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 2) {
+		return octave_value_list();
+	}
+	Matrix W = args(0).matrix_value();
+	Matrix Ci = args(1).matrix_value();
+	if (!error_state) {
+		gsl_matrix* W_gsl = bct_test::to_gslm(W);
+		gsl_vector* Ci_gsl = bct_test::to_gslv(Ci);
+		gsl_matrix* S = bct::module_strength(W_gsl, Ci_gsl);
+		bct::adjacency_list* adj = bct::to_adjacency_list(W_gsl);
+		gsl_matrix* S_adj = bct::module_strength(adj, Ci_gsl);
+		octave_value_list ret;
+		ret(0) = octave_value(bct_test::from_gsl(S));
+		ret(1) = octave_value(bct_test::from_gsl(S_adj));
+		gsl_matrix_free(W_gsl);
+		gsl_vector_free(Ci_gsl);
+		gsl_matrix_free(S);
+		bct::adjacency_list_free(adj);
+		gsl_matrix_free(S_adj);
+		return ret;
+	} else {
+		return octave_value_list();
+	}
+}
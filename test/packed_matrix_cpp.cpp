@@ -0,0 +1,72 @@
+#include <string>
+
+#include "bct_test.h"
+
+/*
+ * Returns the named measure computed from a full matrix and from a packed
+ * symmetric matrix holding the same graph.  The third argument is p for
+ * threshold_proportional_und, or ITER for randmio_und; randmio_und also takes
+ * a seed as the fourth argument, and the random number generator is seeded
+ * with it before each call.  Matrix results are returned as full matrices.
+ */
+DEFUN_DLD(packed_matrix_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() < 2 || args.length() > 4) {
+		return octave_value_list();
+	}
+	Matrix W = args(0).matrix_value();
+	std::string measure = args(1).string_value();
+	double arg = (args.length() > 2) ? args(2).double_value() : 0.0;
+	unsigned long seed = (args.length() > 3) ? (unsigned long)args(3).int_value() : 0;
+	if (!error_state) {
+		gsl_matrix* W_gsl = bct_test::to_gslm(W);
+		bct::packed_matrix* W_packed = bct::to_packed_matrix(W_gsl);
+		octave_value_list ret;
+		if (measure == "degrees_und" || measure == "strengths_und" || measure == "clustering_coef_wu") {
+			gsl_vector* full;
+			gsl_vector* packed;
+			if (measure == "degrees_und") {
+				full = bct::degrees_und(W_gsl);
+				packed = bct::degrees_und(W_packed);
+			} else if (measure == "strengths_und") {
+				full = bct::strengths_und(W_gsl);
+				packed = bct::strengths_und(W_packed);
+			} else {
+				full = bct::clustering_coef_wu(W_gsl);
+				packed = bct::clustering_coef_wu(W_packed);
+			}
+			ret(0) = octave_value(bct_test::from_gsl(full));
+			ret(1) = octave_value(bct_test::from_gsl(packed));
+			gsl_vector_free(full);
+			gsl_vector_free(packed);
+		} else if (measure == "density_und") {
+			ret(0) = octave_value(bct::density_und(W_gsl));
+			ret(1) = octave_value(bct::density_und(W_packed));
+		} else if (measure == "number_of_edges_und") {
+			ret(0) = octave_value(bct::number_of_edges_und(W_gsl));
+			ret(1) = octave_value(bct::number_of_edges_und(W_packed));
+		} else if (measure == "threshold_proportional_und" || measure == "randmio_und") {
+			gsl_matrix* full;
+			bct::packed_matrix* packed;
+			if (measure == "threshold_proportional_und") {
+				full = bct::threshold_proportional_und(W_gsl, arg);
+				packed = bct::threshold_proportional_und(W_packed, arg);
+			} else {
+				bct::seed_rng(bct::get_rng(), seed);
+				full = bct::randmio_und(W_gsl, (int)arg);
+				bct::seed_rng(bct::get_rng(), seed);
+				packed = bct::randmio_und(W_packed, (int)arg);
+			}
+			gsl_matrix* packed_full = bct::packed_matrix_to_matrix(packed);
+			ret(0) = octave_value(bct_test::from_gsl(full));
+			ret(1) = octave_value(bct_test::from_gsl(packed_full));
+			gsl_matrix_free(full);
+			bct::packed_matrix_free(packed);
+			gsl_matrix_free(packed_full);
+		}
+		gsl_matrix_free(W_gsl);
+		bct::packed_matrix_free(W_packed);
+		return ret;
+	} else {
+		return octave_value_list();
+	}
+}
@@ -0,0 +1,28 @@
+#include "bct_test.h"
+
+DEFUN_DLD(reachability_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 1) {
+		return octave_value_list();
+	}
+	Matrix CIJ = args(0).matrix_value();
+	if (!error_state) {
+		gsl_matrix* CIJ_gsl = bct_test::to_gslm(CIJ);
+		bct::bit_matrix* R_bits = bct::reachability(CIJ_gsl);
+		bct::adjacency_list* adj = bct::to_adjacency_list(CIJ_gsl);
+		bct::bit_matrix* R_adj_bits = bct::reachability(adj);
+		gsl_matrix* R = bct::bit_matrix_to_matrix(R_bits);
+		gsl_matrix* R_adj = bct::bit_matrix_to_matrix(R_adj_bits);
+		octave_value_list ret;
+		ret(0) = octave_value(bct_test::from_gsl(R));
+		ret(1) = octave_value(bct_test::from_gsl(R_adj));
+		gsl_matrix_free(CIJ_gsl);
+		bct::bit_matrix_free(R_bits);
+		bct::adjacency_list_free(adj);
+		bct::bit_matrix_free(R_adj_bits);
+		gsl_matrix_free(R);
+		gsl_matrix_free(R_adj);
+		return ret;
+	} else {
+		return octave_value_list();
+	}
+}
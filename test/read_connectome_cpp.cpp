@@ -0,0 +1,50 @@
+#include <string>
+
+#include "bct_test.h"
+
+/*
+ * Returns the matrix read by read_connectome and the matrix mapped by
+ * connectome_open, which should be the same.
+ */
+DEFUN_DLD(read_connectome_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 1) {
+		return octave_value_list();
+	}
+	std::string filename = args(0).string_value();
+	if (!error_state) {
+		gsl_matrix* m;
+		bct::connectome* conn;
+		try {
+			m = bct::read_connectome(filename);
+		} catch (bct::bct_exception& e) {
+			error("%s", e.what());
+			return octave_value_list();
+		}
+		try {
+			conn = bct::connectome_open(filename);
+		} catch (bct::bct_exception& e) {
+			gsl_matrix_free(m);
+			error("%s", e.what());
+			return octave_value_list();
+		}
+		Matrix mapped;
+		if (conn->m != NULL) {
+			mapped = bct_test::from_gsl(conn->m);
+		} else {
+			mapped = Matrix(conn->size, conn->size, 0.0);
+			for (int i = 0; i < conn->size; i++) {
+				for (int k = conn->adj->offsets[i]; k < conn->adj->offsets[i + 1]; k++) {
+					mapped(i, conn->adj->nodes[k]) = conn->adj->weights[k];
+				}
+			}
+		}
+		octave_value_list ret;
+		ret(0) = octave_value(bct_test::from_gsl(m));
+		ret(1) = octave_value(mapped);
+		gsl_matrix_free(m);
+		bct::connectome_close(conn);
+		return ret;
+	} else {
+		return octave_value_list();
+	}
+}
@@ -0,0 +1,26 @@
+#include "bct_test.h"
+
+DEFUN_DLD(setxor_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 2) {
+		return octave_value_list();
+	}
+	Matrix a = args(0).matrix_value();
+	Matrix b = args(1).matrix_value();
+	if (!error_state) {
+		gsl_vector* a_gsl = bct_test::to_gslv(a);
+		gsl_vector* b_gsl = bct_test::to_gslv(b);
+		gsl_vector* c = bct::setxor(a_gsl, b_gsl);
+		octave_value ret;
+		if (c == NULL) {
+			ret = octave_value(Matrix(1, 0));
+		} else {
+			ret = octave_value(bct_test::from_gsl(c));
+			gsl_vector_free(c);
+		}
+		gsl_vector_free(a_gsl);
+		gsl_vector_free(b_gsl);
+		return ret;
+	} else {
+		return octave_value_list();
+	}
+}
@@ -0,0 +1,41 @@
+#include <string>
+
+#include "bct_test.h"
+
+/*
+ * Sorts a vector, or each column of a matrix, returning one-based indices.
+ */
+DEFUN_DLD(sort_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 2) {
+		return octave_value_list();
+	}
+	Matrix x = args(0).matrix_value();
+	std::string mode = args(1).string_value();
+	if (!error_state) {
+		octave_value_list ret;
+		if (x.dims()(0) == 1 || x.dims()(1) == 1) {
+			gsl_vector* x_gsl = bct_test::to_gslv(x);
+			gsl_vector* ind;
+			gsl_vector* y = bct::sort(x_gsl, mode, &ind);
+			gsl_vector_add_constant(ind, 1.0);
+			ret(0) = octave_value(bct_test::from_gsl(y));
+			ret(1) = octave_value(bct_test::from_gsl(ind));
+			gsl_vector_free(x_gsl);
+			gsl_vector_free(y);
+			gsl_vector_free(ind);
+		} else {
+			gsl_matrix* x_gsl = bct_test::to_gslm(x);
+			gsl_matrix* ind;
+			gsl_matrix* y = bct::sort(x_gsl, 1, mode, &ind);
+			gsl_matrix_add_constant(ind, 1.0);
+			ret(0) = octave_value(bct_test::from_gsl(y));
+			ret(1) = octave_value(bct_test::from_gsl(ind));
+			gsl_matrix_free(x_gsl);
+			gsl_matrix_free(y);
+			gsl_matrix_free(ind);
+		}
+		return ret;
+	} else {
+		return octave_value_list();
+	}
+}
@@ -0,0 +1,66 @@
+#include "bct_test.h"
+
+/*
+ * Exercises the status cache on an undirected matrix without loops and returns
+ * the result of check_status after each step.  Every element should be true.
+ */
+DEFUN_DLD(status_cache_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 1) {
+		return octave_value_list();
+	}
+	Matrix m = args(0).matrix_value();
+	if (!error_state) {
+		gsl_matrix* m_gsl = bct_test::to_gslm(m);
+		int N = m_gsl->size1;
+		double original = gsl_matrix_get(m_gsl, 0, N - 1);
+		gsl_matrix* other = gsl_matrix_calloc(N, N);
+		gsl_matrix_view view = gsl_matrix_submatrix(m_gsl, 0, 0, N - 1, N);
+		gsl_vector* ret = gsl_vector_alloc(9);
+		bct::clear_status_cache();
+		
+		// A cached matrix is not examined again, even if it is modified
+		bct::cache_status(m_gsl);
+		gsl_matrix_set(m_gsl, 0, N - 1, original + 1.0);
+		gsl_vector_set(ret, 0, bct::check_status(m_gsl, bct::UNDIRECTED, "status_cache_cpp"));
+		
+		// A view of the same data with another shape is not found
+		gsl_vector_set(ret, 1, bct::check_status(&view.matrix, bct::RECTANGULAR | bct::DIRECTED, "status_cache_cpp"));
+		
+		// Size checks never use the cache
+		gsl_vector_set(ret, 2, bct::check_status(m_gsl, bct::SQUARE, "status_cache_cpp"));
+		
+		// Removing a matrix causes it to be examined
+		bct::uncache_status(m_gsl);
+		gsl_vector_set(ret, 3, bct::check_status(m_gsl, bct::DIRECTED, "status_cache_cpp"));
+		
+		// Caching a matrix again reclassifies it
+		bct::cache_status(m_gsl);
+		gsl_matrix_set(m_gsl, 0, N - 1, original);
+		gsl_vector_set(ret, 4, bct::check_status(m_gsl, bct::DIRECTED, "status_cache_cpp"));
+		bct::cache_status(m_gsl);
+		gsl_vector_set(ret, 5, bct::check_status(m_gsl, bct::UNDIRECTED | bct::NO_LOOPS, "status_cache_cpp"));
+		
+		// Clearing the cache invalidates every entry, including those whose
+		// slots are later reused
+		bct::cache_status(other);
+		bct::clear_status_cache();
+		gsl_matrix_set(m_gsl, 0, N - 1, original + 1.0);
+		gsl_vector_set(ret, 6, bct::check_status(m_gsl, bct::DIRECTED, "status_cache_cpp"));
+		bct::cache_status(other);
+		gsl_vector_set(ret, 7, bct::check_status(m_gsl, bct::DIRECTED, "status_cache_cpp"));
+		
+		// Entries cached after clearing are found
+		bct::cache_status(m_gsl);
+		gsl_matrix_set(m_gsl, 0, N - 1, original);
+		gsl_vector_set(ret, 8, bct::check_status(m_gsl, bct::DIRECTED, "status_cache_cpp"));
+		
+		bct::clear_status_cache();
+		octave_value ret_oct = bct_test::from_gsl(ret);
+		gsl_matrix_free(m_gsl);
+		gsl_matrix_free(other);
+		gsl_vector_free(ret);
+		return ret_oct;
+	} else {
+		return octave_value_list();
+	}
+}
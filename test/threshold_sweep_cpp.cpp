@@ -0,0 +1,39 @@
+#include <vector>
+
+#include "bct_test.h"
+
+DEFUN_DLD(threshold_sweep_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 3) {
+		return octave_value_list();
+	}
+	Matrix W = args(0).matrix_value();
+	Matrix thr = args(1).matrix_value();
+	bool undirected = args(2).bool_value();
+	if (!error_state) {
+		gsl_matrix* W_gsl = bct_test::to_gslm(W);
+		gsl_vector* thr_gsl = bct_test::to_gslv(thr);
+		int steps = thr_gsl->size;
+		bct::threshold_sweep* sweep = bct::threshold_sweep_alloc(W_gsl, undirected);
+		std::vector<gsl_matrix*> W_thr(steps);
+		gsl_matrix* deg = gsl_matrix_alloc(steps, W_gsl->size1);
+		gsl_matrix* str = gsl_matrix_alloc(steps, W_gsl->size1);
+		for (int i = 0; i < steps; i++) {
+			W_thr[i] = bct::copy(bct::threshold_sweep_absolute(sweep, gsl_vector_get(thr_gsl, i)));
+			gsl_matrix_set_row(deg, i, sweep->deg);
+			gsl_matrix_set_row(str, i, sweep->str);
+		}
+		octave_value_list ret;
+		ret(0) = octave_value(bct_test::from_gsl(W_thr));
+		ret(1) = octave_value(bct_test::from_gsl(deg));
+		ret(2) = octave_value(bct_test::from_gsl(str));
+		gsl_matrix_free(W_gsl);
+		gsl_vector_free(thr_gsl);
+		bct::threshold_sweep_free(sweep);
+		bct::gsl_free(W_thr);
+		gsl_matrix_free(deg);
+		gsl_matrix_free(str);
+		return ret;
+	} else {
+		return octave_value_list();
+	}
+}
@@ -0,0 +1,33 @@
+#include <string>
+
+#include "bct_test.h"
+
+/*
+ * Returns the unique elements of a vector and one-based indices i and j.
+ */
+DEFUN_DLD(unique_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 2) {
+		return octave_value_list();
+	}
+	Matrix x = args(0).matrix_value();
+	std::string first_or_last = args(1).string_value();
+	if (!error_state) {
+		gsl_vector* x_gsl = bct_test::to_gslv(x);
+		gsl_vector* i;
+		gsl_vector* j;
+		gsl_vector* y = bct::unique(x_gsl, first_or_last, &i, &j);
+		gsl_vector_add_constant(i, 1.0);
+		gsl_vector_add_constant(j, 1.0);
+		octave_value_list ret;
+		ret(0) = octave_value(bct_test::from_gsl(y));
+		ret(1) = octave_value(bct_test::from_gsl(i));
+		ret(2) = octave_value(bct_test::from_gsl(j));
+		gsl_vector_free(x_gsl);
+		gsl_vector_free(y);
+		gsl_vector_free(i);
+		gsl_vector_free(j);
+		return ret;
+	} else {
+		return octave_value_list();
+	}
+}
@@ -0,0 +1,22 @@
+#include <string>
+
+#include "bct_test.h"
+
+DEFUN_DLD(write_connectome_cpp, args, , "Wrapper for C++ function.") {
+	if (args.length() != 3) {
+		return octave_value_list();
+	}
+	Matrix m = args(0).matrix_value();
+	std::string filename = args(1).string_value();
+	bool sparse = args(2).bool_value();
+	if (!error_state) {
+		gsl_matrix* m_gsl = bct_test::to_gslm(m);
+		try {
+			bct::write_connectome(m_gsl, filename, sparse);
+		} catch (bct::bct_exception& e) {
+			error("%s", e.what());
+		}
+		gsl_matrix_free(m_gsl);
+	}
+	return octave_value_list();
+}
@@ -1,7 +1,14 @@
+#include <algorithm>
 #include <cmath>
+#include <functional>
+#include <vector>
 
 #include "bct.h"
 
+const int parallel_select_limit = 1 << 20;
+FP_T select_descending(std::vector<FP_T>& values, int k);
+MATRIX_T* threshold_proportional(const MATRIX_T* W, int en, bool undirected);
+
 /*
  * Preserves a given proportion of the strongest weights in a directed graph.
  * All other weights, as well as those on the main diagonal, are set to zero.
@@ -12,34 +19,10 @@ MATRIX_T* BCT_NAMESPACE::threshold_proportional_dir(const MATRIX_T* W, FP_T p) {
 	// n=size(W,1);
 	int n = W->size1;
 	
-	// W(1:n+1:end)=0;
-	MATRIX_T* W_thr = copy(W);
-	for (int i = 0; i < (int)W_thr->size1; i++) {
-		MATRIX_ID(set)(W_thr, i, i, 0.0);
-	}
-	
-	// ind=find(W);
-	VECTOR_T* ind = find(W_thr);
-	
-	// E=sortrows([ind W(ind)], -2);
-	VECTOR_T* W_thr_ind = ordinal_index(W_thr, ind);
-	VECTOR_T* sort_ind;
-	VECTOR_T* sort_W_thr_ind = sort(W_thr_ind, "descend", &sort_ind);
-	VECTOR_ID(free)(W_thr_ind);
-	VECTOR_ID(free)(sort_W_thr_ind);
-	
 	// en=round((n^2-n)*p);
 	int en = (int)std::floor(n * (n - 1) * p + 0.5);
 	
-	// W(E(en+1:end,1))=0;
-	for (int i = en; i < (int)sort_ind->size; i++) {
-		int index = VECTOR_ID(get)(ind, VECTOR_ID(get)(sort_ind, i));
-		ordinal_index_assign(W_thr, index, 0.0);
-	}
-	
-	VECTOR_ID(free)(ind);
-	VECTOR_ID(free)(sort_ind);
-	return W_thr;
+	return threshold_proportional(W, en, false);
 }
 
 /*
@@ -52,35 +35,193 @@ MATRIX_T* BCT_NAMESPACE::threshold_proportional_und(const MATRIX_T* W, FP_T p) {
 	// n=size(W,1);
 	int n = W->size1;
 	
-	// W(1:n+1:end)=0;
-	MATRIX_T* W_thr = triu(W, 1);
+	// en=round((n^2-n)*p);
+	int en = (int)std::floor(0.5 * n * (n - 1) * p + 0.5);
+	
+	return threshold_proportional(W, en, true);
+}
+
+/*
+ * Preserves a given proportion of the strongest weights in an undirected graph
+ * stored as a packed symmetric matrix.  Each weight is stored once, so the
+ * upper triangle is scanned without copying it.
+ */
+BCT_NAMESPACE::packed_matrix* BCT_NAMESPACE::threshold_proportional_und(const packed_matrix* W, FP_T p) {
+	int n = W->size;
+	
+	// en=round((n^2-n)*p);
+	int en = (int)std::floor(0.5 * n * (n - 1) * p + 0.5);
+	
+	packed_matrix* W_thr = packed_matrix_alloc(n);
 	
 	// ind=find(W);
-	VECTOR_T* ind = find(W_thr);
+	std::vector<FP_T> W_ind;
+	for (int i = 0; i < n; i++) {
+		const FP_T* row = packed_matrix_const_row(W, i);
+		for (int j = i + 1; j < n; j++) {
+			if (fp_nonzero(row[j - i])) {
+				W_ind.push_back(row[j - i]);
+			}
+		}
+	}
+	if (en <= 0 || W_ind.empty()) {
+		return W_thr;
+	}
+	if (en > (int)W_ind.size()) {
+		en = W_ind.size();
+	}
 	
 	// E=sortrows([ind W(ind)], -2);
-	VECTOR_T* W_thr_ind = ordinal_index(W_thr, ind);
-	VECTOR_T* sort_ind;
-	VECTOR_T* sort_W_thr_ind = sort(W_thr_ind, "descend", &sort_ind);
-	VECTOR_ID(free)(W_thr_ind);
-	VECTOR_ID(free)(sort_W_thr_ind);
+	FP_T cutoff = select_descending(W_ind, en - 1);
 	
-	// en=round((n^2-n)*p);
-	int en = (int)std::floor(0.5 * n * (n - 1) * p + 0.5);
+	// W(E(en+1:end,1))=0;
+	int above = 0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:above) schedule(dynamic, 64)
+#endif
+	for (int i = 0; i < n; i++) {
+		const FP_T* row = packed_matrix_const_row(W, i);
+		FP_T* thr_row = packed_matrix_row(W_thr, i);
+		for (int j = i + 1; j < n; j++) {
+			FP_T value = row[j - i];
+			if (fp_nonzero(value) && value > cutoff) {
+				thr_row[j - i] = value;
+				above++;
+			}
+		}
+	}
+	
+	// Ties are kept in order of linear index, which runs down the columns of
+	// the upper triangle
+	int ties = en - above;
+	for (int j = 0; j < n && ties > 0; j++) {
+		for (int i = 0; i < j && ties > 0; i++) {
+			if (packed_matrix_get(W, i, j) == cutoff) {
+				packed_matrix_set(W_thr, i, j, cutoff);
+				ties--;
+			}
+		}
+	}
+	
+	return W_thr;
+}
+
+/*
+ * Keeps the en strongest off-diagonal weights (upper triangle only if
+ * undirected).  Rather than sorting every weight, this selects the en-th
+ * largest weight and then copies everything above it straight into the
+ * output.  Weights equal to the cutoff are kept in order of their linear
+ * index, which is how the stable sortrows in the MATLAB version breaks ties.
+ */
+MATRIX_T* threshold_proportional(const MATRIX_T* W, int en, bool undirected) {
+	using namespace BCT_NAMESPACE;
+	
+	int n = W->size1;
+	MATRIX_T* W_thr = zeros(n);
+	
+	// ind=find(W);
+	std::vector<FP_T> W_ind;
+	for (int j = 0; j < n; j++) {
+		for (int i = 0; i < (undirected ? j : n); i++) {
+			FP_T value = MATRIX_ID(get)(W, i, j);
+			if (i != j && fp_nonzero(value)) {
+				W_ind.push_back(value);
+			}
+		}
+	}
+	if (en <= 0 || W_ind.empty()) {
+		return W_thr;
+	}
+	if (en > (int)W_ind.size()) {
+		en = W_ind.size();
+	}
+	
+	// E=sortrows([ind W(ind)], -2);
+	FP_T cutoff = select_descending(W_ind, en - 1);
 	
 	// W(E(en+1:end,1))=0;
-	for (int i = en; i < (int)sort_ind->size; i++) {
-		int index = VECTOR_ID(get)(ind, VECTOR_ID(get)(sort_ind, i));
-		ordinal_index_assign(W_thr, index, 0.0);
+	int above = 0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:above)
+#endif
+	for (int j = 0; j < n; j++) {
+		for (int i = 0; i < (undirected ? j : n); i++) {
+			FP_T value = MATRIX_ID(get)(W, i, j);
+			if (i != j && fp_nonzero(value) && value > cutoff) {
+				MATRIX_ID(set)(W_thr, i, j, value);
+				above++;
+			}
+		}
+	}
+	int ties = en - above;
+	for (int j = 0; j < n && ties > 0; j++) {
+		for (int i = 0; i < (undirected ? j : n) && ties > 0; i++) {
+			if (i != j && MATRIX_ID(get)(W, i, j) == cutoff) {
+				MATRIX_ID(set)(W_thr, i, j, cutoff);
+				ties--;
+			}
+		}
 	}
-	for (int i = 0; i < (int)W_thr->size1; i++) {
-		for (int j = i + 1; j < (int)W_thr->size2; j++) {
-			FP_T value = MATRIX_ID(get)(W_thr, i, j);
-			MATRIX_ID(set)(W_thr, j, i, value);
+	
+	if (undirected) {
+		for (int i = 0; i < n; i++) {
+			for (int j = i + 1; j < n; j++) {
+				FP_T value = MATRIX_ID(get)(W_thr, i, j);
+				MATRIX_ID(set)(W_thr, j, i, value);
+			}
 		}
 	}
 	
-	VECTOR_ID(free)(ind);
-	VECTOR_ID(free)(sort_ind);
 	return W_thr;
 }
+
+/*
+ * Returns the kth largest value (counting from zero), reordering the given
+ * values in the process.  Large inputs are narrowed down by partitioning
+ * around a pivot in parallel before finishing with std::nth_element.
+ */
+FP_T select_descending(std::vector<FP_T>& values, int k) {
+#ifdef _OPENMP
+	while ((int)values.size() > parallel_select_limit) {
+		int size = values.size();
+		FP_T pivot[] = { values[0], values[size / 2], values[size - 1] };
+		std::sort(pivot, pivot + 3);
+		int greater = 0;
+		int equal = 0;
+#pragma omp parallel for reduction(+:greater, equal)
+		for (int i = 0; i < size; i++) {
+			if (values[i] > pivot[1]) {
+				greater++;
+			} else if (values[i] == pivot[1]) {
+				equal++;
+			}
+		}
+		if (k >= greater && k < greater + equal) {
+			return pivot[1];
+		}
+		bool keep_greater = k < greater;
+		if (!keep_greater) {
+			k -= greater + equal;
+		}
+		std::vector<FP_T> partition(keep_greater ? greater : size - greater - equal);
+		int position = 0;
+#pragma omp parallel
+		{
+			std::vector<FP_T> local;
+#pragma omp for nowait
+			for (int i = 0; i < size; i++) {
+				if (keep_greater ? values[i] > pivot[1] : values[i] < pivot[1]) {
+					local.push_back(values[i]);
+				}
+			}
+			int start;
+#pragma omp atomic capture
+			{ start = position; position += local.size(); }
+			std::copy(local.begin(), local.end(), partition.begin() + start);
+		}
+		values.swap(partition);
+	}
+#endif
+	std::nth_element(values.begin(), values.begin() + k, values.end(), std::greater<FP_T>());
+	return values[k];
+}
@@ -0,0 +1,243 @@
+#include <cmath>
+#include <vector>
+
+#include "bct.h"
+
+namespace BCT_NAMESPACE {
+	int threshold_sweep_root(int* parent, int i);
+	void threshold_sweep_union(threshold_sweep* sweep, int i, int j);
+}
+
+/*
+ * Prepares a sweep over many thresholds of the same graph.  The off-diagonal
+ * weights (upper triangle only if undirected) are sorted once, in the same
+ * order used by threshold_proportional_dir and threshold_proportional_und
+ * (descending, with ties kept in order of their linear index).
+ * Successive thresholds then add or remove edges in weight order instead of
+ * rebuilding the thresholded graph, and degree, strength, and connected
+ * components are updated edge by edge.
+ *
+ * sweep->n_candidates is the number of edges that can be added, while
+ * sweep->edges is the number in the current thresholded graph.  sweep->deg and
+ * sweep->str count each edge at both of its ends, so for a directed graph they
+ * hold in-degree plus out-degree and in-strength plus out-strength, as returned
+ * by degrees_dir and strengths_dir.
+ *
+ * If sweep->hook is set, it is called for every edge that is added to or
+ * removed from the thresholded graph, so that other measures can be updated
+ * incrementally as well.
+ */
+BCT_NAMESPACE::threshold_sweep* BCT_NAMESPACE::threshold_sweep_alloc(const MATRIX_T* W, bool undirected) {
+	if (safe_mode) check_status(W, SQUARE | (undirected ? UNDIRECTED : DIRECTED), "threshold_sweep_alloc");
+	int n = W->size1;
+	
+	// ind=find(W);
+	std::vector<int> ind_i;
+	std::vector<int> ind_j;
+	std::vector<FP_T> W_ind;
+	for (int j = 0; j < n; j++) {
+		for (int i = 0; i < (undirected ? j : n); i++) {
+			FP_T value = MATRIX_ID(get)(W, i, j);
+			if (i != j && fp_nonzero(value)) {
+				ind_i.push_back(i);
+				ind_j.push_back(j);
+				W_ind.push_back(value);
+			}
+		}
+	}
+	
+	// E=sortrows([ind W(ind)], -2);
+	threshold_sweep* sweep = new threshold_sweep;
+	sweep->undirected = undirected;
+	sweep->n_candidates = W_ind.size();
+	sweep->rows = new int[sweep->n_candidates + 1];
+	sweep->columns = new int[sweep->n_candidates + 1];
+	sweep->weights = new FP_T[sweep->n_candidates + 1];
+	std::vector<std::size_t> order(sweep->n_candidates + 1);
+	if (sweep->n_candidates > 0) {
+		argsort(&W_ind[0], sweep->n_candidates, &order[0], true);
+	}
+	for (int i = 0; i < sweep->n_candidates; i++) {
+		sweep->rows[i] = ind_i[order[i]];
+		sweep->columns[i] = ind_j[order[i]];
+		sweep->weights[i] = W_ind[order[i]];
+	}
+	
+	sweep->W_thr = zeros(n);
+	sweep->edges = 0;
+	sweep->deg = zeros_vector(n);
+	sweep->str = zeros_vector(n);
+	sweep->parent = new int[n];
+	for (int i = 0; i < n; i++) {
+		sweep->parent[i] = i;
+	}
+	sweep->components = n;
+	sweep->hook = NULL;
+	sweep->hook_data = NULL;
+	return sweep;
+}
+
+/*
+ * Frees a threshold sweep, including its thresholded graph.
+ */
+void BCT_NAMESPACE::threshold_sweep_free(threshold_sweep* sweep) {
+	if (sweep == NULL) {
+		return;
+	}
+	MATRIX_ID(free)(sweep->W_thr);
+	VECTOR_ID(free)(sweep->deg);
+	VECTOR_ID(free)(sweep->str);
+	delete[] sweep->rows;
+	delete[] sweep->columns;
+	delete[] sweep->weights;
+	delete[] sweep->parent;
+	delete sweep;
+}
+
+/*
+ * Moves the sweep to the graph containing the given number of strongest edges
+ * and returns it.  The returned matrix belongs to the sweep and changes with
+ * the next threshold; copy it if it must be kept.
+ */
+const MATRIX_T* BCT_NAMESPACE::threshold_sweep_edges(threshold_sweep* sweep, int edges) {
+	if (edges < 0) {
+		edges = 0;
+	} else if (edges > sweep->n_candidates) {
+		edges = sweep->n_candidates;
+	}
+	while (sweep->edges < edges) {
+		int i = sweep->rows[sweep->edges];
+		int j = sweep->columns[sweep->edges];
+		FP_T w = sweep->weights[sweep->edges];
+		MATRIX_ID(set)(sweep->W_thr, i, j, w);
+		if (sweep->undirected) {
+			MATRIX_ID(set)(sweep->W_thr, j, i, w);
+		}
+		VECTOR_ID(set)(sweep->deg, i, VECTOR_ID(get)(sweep->deg, i) + 1.0);
+		VECTOR_ID(set)(sweep->deg, j, VECTOR_ID(get)(sweep->deg, j) + 1.0);
+		VECTOR_ID(set)(sweep->str, i, VECTOR_ID(get)(sweep->str, i) + w);
+		VECTOR_ID(set)(sweep->str, j, VECTOR_ID(get)(sweep->str, j) + w);
+		if (sweep->components >= 0) {
+			threshold_sweep_union(sweep, i, j);
+		}
+		sweep->edges++;
+		if (sweep->hook != NULL) {
+			sweep->hook(i, j, w, true, sweep->hook_data);
+		}
+	}
+	while (sweep->edges > edges) {
+		sweep->edges--;
+		int i = sweep->rows[sweep->edges];
+		int j = sweep->columns[sweep->edges];
+		FP_T w = sweep->weights[sweep->edges];
+		MATRIX_ID(set)(sweep->W_thr, i, j, 0.0);
+		if (sweep->undirected) {
+			MATRIX_ID(set)(sweep->W_thr, j, i, 0.0);
+		}
+		VECTOR_ID(set)(sweep->deg, i, VECTOR_ID(get)(sweep->deg, i) - 1.0);
+		VECTOR_ID(set)(sweep->deg, j, VECTOR_ID(get)(sweep->deg, j) - 1.0);
+		VECTOR_ID(set)(sweep->str, i, VECTOR_ID(get)(sweep->str, i) - w);
+		VECTOR_ID(set)(sweep->str, j, VECTOR_ID(get)(sweep->str, j) - w);
+		
+		// Union-find cannot split components, so recount them when asked
+		sweep->components = -1;
+		if (sweep->hook != NULL) {
+			sweep->hook(i, j, w, false, sweep->hook_data);
+		}
+	}
+	return sweep->W_thr;
+}
+
+/*
+ * Moves the sweep to the graph returned by threshold_absolute.
+ */
+const MATRIX_T* BCT_NAMESPACE::threshold_sweep_absolute(threshold_sweep* sweep, FP_T thr) {
+	
+	// W(W<thr)=0;
+	int lower = 0;
+	int upper = sweep->n_candidates;
+	while (lower < upper) {
+		int middle = (lower + upper) / 2;
+		if (fp_less(sweep->weights[middle], thr)) {
+			upper = middle;
+		} else {
+			lower = middle + 1;
+		}
+	}
+	return threshold_sweep_edges(sweep, lower);
+}
+
+/*
+ * Moves the sweep to the graph returned by threshold_proportional_dir or
+ * threshold_proportional_und.
+ */
+const MATRIX_T* BCT_NAMESPACE::threshold_sweep_proportional(threshold_sweep* sweep, FP_T p) {
+	int n = sweep->W_thr->size1;
+	
+	// en=round((n^2-n)*p);
+	int en;
+	if (sweep->undirected) {
+		en = (int)std::floor(0.5 * n * (n - 1) * p + 0.5);
+	} else {
+		en = (int)std::floor(n * (n - 1) * p + 0.5);
+	}
+	return threshold_sweep_edges(sweep, en);
+}
+
+/*
+ * Returns the density of the current thresholded graph.
+ */
+FP_T BCT_NAMESPACE::threshold_sweep_density(const threshold_sweep* sweep) {
+	int N = sweep->W_thr->size1;
+	if (sweep->undirected) {
+		return (FP_T)sweep->edges / ((FP_T)(N * (N - 1)) / 2.0);
+	} else {
+		return (FP_T)sweep->edges / (FP_T)(N * (N - 1));
+	}
+}
+
+/*
+ * Returns the number of connected components (weakly connected, if directed)
+ * of the current thresholded graph.
+ */
+int BCT_NAMESPACE::threshold_sweep_components(threshold_sweep* sweep) {
+	if (sweep->components < 0) {
+		int N = sweep->W_thr->size1;
+		for (int i = 0; i < N; i++) {
+			sweep->parent[i] = i;
+		}
+		sweep->components = N;
+		for (int i = 0; i < sweep->edges; i++) {
+			threshold_sweep_union(sweep, sweep->rows[i], sweep->columns[i]);
+		}
+	}
+	return sweep->components;
+}
+
+/*
+ * Returns the representative of a node's component, compressing the path.
+ */
+int BCT_NAMESPACE::threshold_sweep_root(int* parent, int i) {
+	int root = i;
+	while (parent[root] != root) {
+		root = parent[root];
+	}
+	while (parent[i] != root) {
+		int next = parent[i];
+		parent[i] = root;
+		i = next;
+	}
+	return root;
+}
+
+/*
+ * Merges the components of two nodes.
+ */
+void BCT_NAMESPACE::threshold_sweep_union(threshold_sweep* sweep, int i, int j) {
+	int root_i = threshold_sweep_root(sweep->parent, i);
+	int root_j = threshold_sweep_root(sweep->parent, j);
+	if (root_i != root_j) {
+		sweep->parent[root_j] = root_i;
+		sweep->components--;
+	}
+}
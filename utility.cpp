@@ -45,9 +45,29 @@ int BCT_NAMESPACE::number_of_edges_dir(const MATRIX_T* m) {
  * Returns the number of edges in an undirected graph.
  */
 int BCT_NAMESPACE::number_of_edges_und(const MATRIX_T* m) {
-	MATRIX_T* triu_m = triu(m);
-	int ret = nnz(triu_m);
-	MATRIX_ID(free)(triu_m);
+	int ret = 0;
+	for (int i = 0; i < (int)m->size1; i++) {
+		for (int j = i; j < (int)m->size2; j++) {
+			if (fp_nonzero(MATRIX_ID(get)(m, i, j))) {
+				ret++;
+			}
+		}
+	}
+	return ret;
+}
+
+/*
+ * Returns the number of edges in an undirected graph stored as a packed
+ * symmetric matrix.
+ */
+int BCT_NAMESPACE::number_of_edges_und(const packed_matrix* m) {
+	int ret = 0;
+	long elements = (long)m->size * (m->size + 1) / 2;
+	for (long k = 0; k < elements; k++) {
+		if (fp_nonzero(m->data[k])) {
+			ret++;
+		}
+	}
 	return ret;
 }
 